@@ -7,7 +7,11 @@ uniform sampler2D text;
 uniform vec3 text_color;
 
 void main() {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, tex_coords).r);
-    color = vec4(text_color, 1.0) * sampled;
+    // SDF atlas: 0.5 is glyph outline, edge width follows screen-space derivative
+    float dist = texture(text, tex_coords).r;
+    float width = fwidth(dist);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+
+    color = vec4(text_color, alpha);
 }
 
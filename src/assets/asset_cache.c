@@ -0,0 +1,255 @@
+/*
+    asset_cache.c -- Shared GPU Assets Registry
+
+    * Meshes (per glTF node) and textures are keyed by normalized path
+    * Handles are refcounted, last release unloads handle from GPU
+    * Lookups are allowed from loader workers (guarded by mutex)
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "asset_cache.h"
+#include "assets/texture.h"
+
+#include "core/containers/map.h"
+#include "core/log.h"
+
+
+typedef struct CacheEntry {
+    char key[ASSET_KEY_LEN];
+    void* handle;
+    u32 refs;
+
+    u64 bytes;
+    f64 load_time;
+} CacheEntry;
+
+typedef struct Cache {
+    map(CacheEntry) by_key;
+    map(CacheEntry) by_handle;
+} Cache;
+
+
+static struct AssetCache {
+    pthread_mutex_t lock;
+    Cache meshes;
+    Cache textures;
+
+    /* --- Stats since last `asset_cache_log_stats` --- */
+    u32 hits;
+    u64 saved_bytes;
+    f64 saved_time;
+    u64 loaded_bytes;
+} self = {};
+
+
+/* ------------------------------------------------------------------------- */
+
+/* Unify separators, drop `.` segments and resolve `..` */
+static
+void _normalize_path(const char* path, char* dest) {
+    char buf[ASSET_KEY_LEN];
+    strncpy(buf, path, ASSET_KEY_LEN - 1);
+    buf[ASSET_KEY_LEN - 1] = '\0';
+
+    for (char* c = buf; *c; c++)
+        if (*c == '\\')  *c = '/';
+
+    char* segments[ASSET_KEY_LEN / 2];
+    int count = 0;
+
+    char* save;
+    for (char* seg = strtok_r(buf, "/", &save); seg; seg = strtok_r(NULL, "/", &save)) {
+        if (strcmp(seg, ".") == 0)
+            continue;
+
+        if (strcmp(seg, "..") == 0 && count > 0 && strcmp(segments[count-1], "..") != 0) {
+            count--;
+            continue;
+        }
+        segments[count++] = seg;
+    }
+
+    dest[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        if (i > 0)  strcat(dest, "/");
+        strcat(dest, segments[i]);
+    }
+}
+
+static inline
+void _mesh_key(const char* mesh_path, int node_idx, char* dest) {
+    char path[ASSET_KEY_LEN];
+    _normalize_path(mesh_path, path);
+    snprintf(dest, ASSET_KEY_LEN, "%.240s#%d", path, node_idx);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline
+void _cache_init(Cache* cache) {
+    cache->by_key = map_new(MHASH_STR);
+    cache->by_handle = map_new(MHASH_INT);
+}
+
+static inline
+void _cache_destroy(Cache* cache) {
+    CacheEntry* entry;
+    map_for_each(entry, cache->by_key) {
+        log_error("[asset_cache] Asset is still referenced on exit: %s (%d refs)", entry->key, entry->refs);
+        free(entry);
+    }
+    map_free(cache->by_key);
+    map_free(cache->by_handle);
+}
+
+static inline
+void* _cache_acquire(Cache* cache, const char* key) {
+    CacheEntry* entry = map_get(cache->by_key, (void*)key);
+    if (!entry)  return NULL;
+
+    entry->refs++;
+    self.hits++;
+    self.saved_bytes += entry->bytes;
+    self.saved_time += entry->load_time;
+
+    return entry->handle;
+}
+
+static inline
+void _cache_add(Cache* cache, const char* key, void* handle, u64 bytes, f64 load_time) {
+    CacheEntry* entry = malloc(sizeof(CacheEntry));
+    memset(entry, 0, sizeof(CacheEntry));
+
+    strcpy(entry->key, key);
+    entry->handle = handle;
+    entry->refs = 1;
+    entry->bytes = bytes;
+    entry->load_time = load_time;
+
+    map_set(cache->by_key, entry, entry->key);
+    map_set(cache->by_handle, entry, handle);
+
+    self.loaded_bytes += bytes;
+}
+
+/* Returns true if handle is not referenced anymore and should be unloaded */
+static inline
+bool _cache_release(Cache* cache, void* handle) {
+    CacheEntry* entry = map_get(cache->by_handle, handle);
+    if (!entry)  return true;  // not cached (loaded directly)
+
+    if (--entry->refs > 0)  return false;
+
+    map_remove(cache->by_key, entry->key);
+    map_remove(cache->by_handle, handle);
+    free(entry);
+    return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void asset_cache_init() {
+    pthread_mutex_init(&self.lock, NULL);
+    _cache_init(&self.meshes);
+    _cache_init(&self.textures);
+}
+
+void asset_cache_destroy() {
+    _cache_destroy(&self.meshes);
+    _cache_destroy(&self.textures);
+    pthread_mutex_destroy(&self.lock);
+}
+
+/* ------ Meshes ------ */
+
+GfxMesh* asset_cache_acquire_mesh(const char* mesh_path, int node_idx) {
+    char key[ASSET_KEY_LEN];
+    _mesh_key(mesh_path, node_idx, key);
+
+    pthread_mutex_lock(&self.lock);
+    GfxMesh* mesh = _cache_acquire(&self.meshes, key);
+    pthread_mutex_unlock(&self.lock);
+
+    return mesh;
+}
+
+void asset_cache_add_mesh(const char* mesh_path, int node_idx, GfxMesh* mesh, u64 bytes, f64 load_time) {
+    char key[ASSET_KEY_LEN];
+    _mesh_key(mesh_path, node_idx, key);
+
+    pthread_mutex_lock(&self.lock);
+    _cache_add(&self.meshes, key, mesh, bytes, load_time);
+    pthread_mutex_unlock(&self.lock);
+}
+
+void asset_cache_release_mesh(GfxMesh* mesh) {
+    if (!mesh)  return;
+
+    pthread_mutex_lock(&self.lock);
+    bool unload = _cache_release(&self.meshes, mesh);
+    pthread_mutex_unlock(&self.lock);
+
+    if (unload)  gfx_unload_mesh(mesh);
+}
+
+/* ------ Textures ------ */
+
+GfxTexture* asset_cache_acquire_texture(const char* texture_path) {
+    char key[ASSET_KEY_LEN];
+    _normalize_path(texture_path, key);
+
+    pthread_mutex_lock(&self.lock);
+    GfxTexture* texture = _cache_acquire(&self.textures, key);
+    pthread_mutex_unlock(&self.lock);
+
+    return texture;
+}
+
+void asset_cache_add_texture(const char* texture_path, GfxTexture* texture, u64 bytes, f64 load_time) {
+    char key[ASSET_KEY_LEN];
+    _normalize_path(texture_path, key);
+
+    pthread_mutex_lock(&self.lock);
+    _cache_add(&self.textures, key, texture, bytes, load_time);
+    pthread_mutex_unlock(&self.lock);
+}
+
+void asset_cache_release_texture(GfxTexture* texture) {
+    if (!texture)  return;
+
+    pthread_mutex_lock(&self.lock);
+    bool unload = _cache_release(&self.textures, texture);
+    pthread_mutex_unlock(&self.lock);
+
+    if (unload)  texture_unload(texture);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void asset_cache_log_stats() {
+    pthread_mutex_lock(&self.lock);
+
+    log_info(
+        "[asset_cache] Loaded %.2f MB, reused %d assets: saved %.2f MB GPU memory, %.1f ms load time",
+        (f64)self.loaded_bytes / (1024.0 * 1024.0),
+        self.hits,
+        (f64)self.saved_bytes / (1024.0 * 1024.0),
+        self.saved_time * 1000.0
+    );
+    self.hits = 0;
+    self.saved_bytes = 0;
+    self.saved_time = 0.0;
+    self.loaded_bytes = 0;
+
+    pthread_mutex_unlock(&self.lock);
+}
+
+void asset_cache_print() {
+    log_debug(
+        "[asset_cache] meshes: %i ; textures: %i",
+        map_size(self.meshes.by_key), map_size(self.textures.by_key)
+    );
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdbool.h>
+
+#include "core/types.h"
+#include "graphics/gfx.h"
+
+
+#define ASSET_KEY_LEN  256
+
+
+void asset_cache_init();
+void asset_cache_destroy();
+
+/* Return shared handle and increment its refcount, NULL if not cached */
+GfxMesh* asset_cache_acquire_mesh(const char* mesh_path, int node_idx);
+GfxTexture* asset_cache_acquire_texture(const char* texture_path);
+
+/* Register newly loaded handle with refcount 1 */
+void asset_cache_add_mesh(const char* mesh_path, int node_idx, GfxMesh*, u64 bytes, f64 load_time);
+void asset_cache_add_texture(const char* texture_path, GfxTexture*, u64 bytes, f64 load_time);
+
+/* Decrement refcount, handle is unloaded when it's not referenced anymore */
+void asset_cache_release_mesh(GfxMesh*);
+void asset_cache_release_texture(GfxTexture*);
+
+void asset_cache_log_stats();
+void asset_cache_print();
@@ -0,0 +1,227 @@
+/*
+    asset_loader.c -- Asynchronous Assets Loading
+
+    * Worker threads do file I/O, glTF parsing, index conversion and DDS reading
+      (`model_prepare`), prepared models come back through lock-free completion stack
+    * Main thread uploads prepared nodes to GPU within per-frame time budget
+    * Model pointer is published to its owner as soon as model is parsed (AABB is
+      known), `Model.is_ready` is set when the last node is uploaded
+*/
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include <GLFW/glfw3.h>
+#include <cvector.h>
+#include <cvector_utils.h>
+
+#include "asset_loader.h"
+
+#include "core/config.h"
+#include "core/log.h"
+
+
+#define MAX_WORKERS  16
+
+
+typedef struct AssetJob {
+    ModelInfo* info;
+    Model** dest;
+
+    ModelData* data;
+    int next_node;
+
+    struct AssetJob* next;  // completion stack link
+} AssetJob;
+
+
+static struct AssetLoader {
+    bool async;
+    pthread_t workers[MAX_WORKERS];
+    u32 workers_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    cvector(AssetJob*) queue;
+    bool stop;
+
+    _Atomic(AssetJob*) completed;
+    cvector(AssetJob*) uploads;
+    u32 pending;
+} self = {};
+
+
+/* ------ Workers ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+void _push_completed(AssetJob* job) {
+    AssetJob* head = atomic_load_explicit(&self.completed, memory_order_relaxed);
+    do {
+        job->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &self.completed, &head, job, memory_order_release, memory_order_relaxed
+    ));
+}
+
+/* Take all completed jobs at once, restoring submission order */
+static inline
+AssetJob* _pop_completed() {
+    AssetJob* head = atomic_exchange_explicit(&self.completed, NULL, memory_order_acquire);
+    AssetJob* reversed = NULL;
+
+    while (head) {
+        AssetJob* next = head->next;
+        head->next = reversed;
+        reversed = head;
+        head = next;
+    }
+    return reversed;
+}
+
+static
+void* _worker(void* _) {
+    pthread_mutex_lock(&self.lock);
+
+    while (true) {
+        while (!self.stop && cvector_empty(self.queue))
+            pthread_cond_wait(&self.cond, &self.lock);
+
+        if (self.stop)  break;
+
+        AssetJob* job = self.queue[0];
+        cvector_erase(self.queue, 0);
+        pthread_mutex_unlock(&self.lock);
+
+        job->data = model_prepare(job->info);
+        _push_completed(job);
+
+        pthread_mutex_lock(&self.lock);
+    }
+
+    pthread_mutex_unlock(&self.lock);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void asset_loader_init() {
+    self.async = Config.ASSETS_ASYNC_LOADING;
+    self.pending = 0;
+    atomic_store(&self.completed, NULL);
+
+    if (!self.async)  return;
+
+    self.workers_count = Config.ASSETS_WORKERS;
+    if (self.workers_count < 1)            self.workers_count = 1;
+    if (self.workers_count > MAX_WORKERS)  self.workers_count = MAX_WORKERS;
+
+    pthread_mutex_init(&self.lock, NULL);
+    pthread_cond_init(&self.cond, NULL);
+    self.stop = false;
+
+    for (u32 i = 0; i < self.workers_count; i++) {
+        if (pthread_create(&self.workers[i], NULL, _worker, NULL) != 0)
+            log_exit("[asset_loader] Unable to start worker thread");
+    }
+}
+
+void asset_loader_destroy() {
+    if (!self.async)  return;
+
+    pthread_mutex_lock(&self.lock);
+    self.stop = true;
+    pthread_cond_broadcast(&self.cond);
+    pthread_mutex_unlock(&self.lock);
+
+    for (u32 i = 0; i < self.workers_count; i++)
+        pthread_join(self.workers[i], NULL);
+
+    AssetJob** it;
+
+    // Never started
+    cvector_for_each_in(it, self.queue) {
+        free(*it);
+    }
+    cvector_free(self.queue);
+
+    // Prepared, but not published to owner yet
+    AssetJob* job = _pop_completed();
+    while (job) {
+        AssetJob* next = job->next;
+        model_destroy(job->data->model);
+        model_data_free(job->data);
+        free(job);
+        job = next;
+    }
+
+    // Published, model is released by its owner
+    cvector_for_each_in(it, self.uploads) {
+        model_data_free((*it)->data);
+        free(*it);
+    }
+    cvector_free(self.uploads);
+
+    pthread_cond_destroy(&self.cond);
+    pthread_mutex_destroy(&self.lock);
+}
+
+
+void asset_loader_load_model(ModelInfo* info, Model** dest) {
+    if (!self.async) {
+        *dest = model_create_from_info(info);
+        return;
+    }
+
+    AssetJob* job = malloc(sizeof(AssetJob));
+    memset(job, 0, sizeof(AssetJob));
+    job->info = info;
+    job->dest = dest;
+    *dest = NULL;
+
+    self.pending++;
+
+    pthread_mutex_lock(&self.lock);
+    cvector_push_back(self.queue, job);
+    pthread_cond_signal(&self.cond);
+    pthread_mutex_unlock(&self.lock);
+}
+
+bool asset_loader_is_busy() {
+    return self.pending > 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void asset_loader_update() {
+    if (!self.async || self.pending == 0)  return;
+
+    /* --- Publish parsed models --- */
+    AssetJob* job = _pop_completed();
+    while (job) {
+        AssetJob* next = job->next;
+        *job->dest = job->data->model;
+        cvector_push_back(self.uploads, job);
+        job = next;
+    }
+
+    /* --- Upload within frame budget (at least one node per frame) --- */
+    f64 budget = Config.ASSETS_UPLOAD_BUDGET_MS / 1000.0;
+    f64 start = glfwGetTime();
+
+    while (!cvector_empty(self.uploads)) {
+        job = self.uploads[0];
+
+        if (job->next_node < job->data->nodes_count)
+            model_upload_node(job->data, job->next_node++);
+
+        if (job->next_node >= job->data->nodes_count) {
+            model_data_free(job->data);
+            free(job);
+            cvector_erase(self.uploads, 0);
+            self.pending--;
+        }
+
+        if (glfwGetTime() - start >= budget)  break;
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdbool.h>
+
+#include "assets/model.h"
+
+
+void asset_loader_init();
+void asset_loader_destroy();
+void asset_loader_update();
+
+void asset_loader_load_model(ModelInfo* info, Model** dest);
+bool asset_loader_is_busy();
@@ -1,72 +1,405 @@
+/*
+    font.c -- SDF Glyph Atlas
+
+    * Glyphs are rasterized as signed distance fields into single atlas of
+      fixed-size cells, so one atlas serves every UI text size
+    * Baked glyphs (printable ASCII) with their metrics are cached on disk,
+      keyed by font file hash and SDF size; warm start doesn't touch FreeType
+    * Other codepoints are rasterized on first use into free cells, least
+      recently used ones are evicted when atlas is full. Glyphs used in current
+      frame are kept (their UVs are already in vertex arrays), if none is left
+      codepoint is drawn as FONT_FALLBACK_CODE
+*/
+#define _POSIX_C_SOURCE 200809L
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 #include <cglm/ivec2.h>
+#include <GLFW/glfw3.h>
 
 #include "font.h"
 
 #include "graphics/gfx.h"
+#include "core/config.h"
 #include "core/log.h"
 #include "core/types.h"
 
 
 #define DEFAULT_FONT_PATH "assets/fonts/berkeley_mono_bold.ttf"
 
+#define FONT_BAKED_FIRST  32   // printable ASCII
+#define FONT_BAKED_LAST   126
+#define FONT_BAKED_COUNT  (FONT_BAKED_LAST - FONT_BAKED_FIRST + 1)
+#define FONT_ATLAS_COLS   (FONT_ATLAS_SIZE / FONT_CELL_SIZE)
+#define FONT_BAKED_ROWS   ((FONT_BAKED_COUNT + FONT_ATLAS_COLS - 1) / FONT_ATLAS_COLS * FONT_CELL_SIZE)
+#define FONT_FALLBACK_CODE  '?'  // baked, drawn when atlas has no cell to evict
 
-Font default_font;
+#define FONT_CACHE_MAGIC    "ILFC"
+#define FONT_CACHE_VERSION  1
+
+
+/* Cache file: header, glyph metrics, then first `atlas_rows` rows of atlas */
+typedef struct FontCacheHeader {
+    char magic[4];
+    u32 version;
+    u64 font_hash;
+    u32 sdf_size;
+    u32 sdf_spread;
+    u32 atlas_size;
+    u32 cell_size;
+    u32 glyphs_count;
+    u32 atlas_rows;
+} FontCacheHeader;
+
+typedef struct FontCacheGlyph {
+    u32 code;
+    u32 cell;
+    i32 size[2];
+    i32 bearing[2];
+    u32 advance;
+} FontCacheGlyph;
 
-void font_load_default() {
-    bool err;
 
+static struct Fonts {
+    Font font;
+    u64 font_hash;
+    u64 tick;
+    u64 frame_tick;  // `tick` at frame start, glyphs used after it aren't evicted
+
+    // Opened only when some glyph has to be rasterized
     FT_Library ft;
-    err = FT_Init_FreeType(&ft);
+    FT_Face face;
+} self = {};
+
+
+/* ------------------------------------------------------------------------- */
+
+/* FNV-1a over font file contents */
+static
+u64 _hash_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file)  log_exit("Failed to open font file: %s", path);
+
+    u64 hash = 0xcbf29ce484222325ULL;
+    u8 buf[16384];
+    u64 read;
+
+    while ((read = fread(buf, 1, sizeof(buf), file)) > 0) {
+        for (u64 i = 0; i < read; i++) {
+            hash ^= buf[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    fclose(file);
+    return hash;
+}
+
+static inline
+void _cache_path(char* dest, u64 size) {
+    snprintf(dest, size, "%sfont_%016llx_%d.bin", Config.DIR_CACHE, self.font_hash, FONT_SDF_SIZE);
+}
+
+static inline
+void _set_glyph_uv(Glyph* glyph) {
+    u32 x = (glyph->cell % FONT_ATLAS_COLS) * FONT_CELL_SIZE;
+    u32 y = (glyph->cell / FONT_ATLAS_COLS) * FONT_CELL_SIZE;
+
+    glyph->uv[0] = (f32)x / FONT_ATLAS_SIZE;
+    glyph->uv[1] = (f32)y / FONT_ATLAS_SIZE;
+    glyph->uv[2] = (f32)(x + glyph->size[0]) / FONT_ATLAS_SIZE;
+    glyph->uv[3] = (f32)(y + glyph->size[1]) / FONT_ATLAS_SIZE;
+}
+
+static inline
+void _register_glyph(Glyph* glyph) {
+    _set_glyph_uv(glyph);
+    map_set(self.font.by_code, glyph, (void*)(u64)glyph->code);
+}
+
+/* ------ FreeType ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void _open_face() {
+    if (self.face)  return;
+
+    bool err;
+    err = FT_Init_FreeType(&self.ft);
     if (err)  log_exit("ERROR::FREETYPE: Could not init FreeType Library");
 
-    FT_Face face;
-    err = FT_New_Face(ft, DEFAULT_FONT_PATH, 0, &face);
+    FT_Int spread = FONT_SDF_SPREAD;
+    FT_Property_Set(self.ft, "sdf", "spread", &spread);
+    FT_Property_Set(self.ft, "bsdf", "spread", &spread);
+
+    err = FT_New_Face(self.ft, DEFAULT_FONT_PATH, 0, &self.face);
     if (err)  log_exit("ERROR::FREETYPE: Failed to load default font");
 
     // set width and height (0 width -> dynamically calculated)
-    FT_Set_Pixel_Sizes(face, 0, 48);
-
-    // Load first 128 ASCII characters
-    for (u8 c = 0; c < 128; c++) {
-        // FT_LOAD_RENDER - create an 8-bit grayscale bitmap image
-        err = FT_Load_Char(face, c, FT_LOAD_RENDER);
-        if (err) {
-            log_error("ERROR::FREETYPE: Failed to load Glyph for character %d", c);
-            continue;
-        }
+    FT_Set_Pixel_Sizes(self.face, 0, FONT_SDF_SIZE);
+}
 
-        GfxTexture* font_texture = gfx_load_font_texture(
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            face->glyph->bitmap.buffer
-        );
-        
-        default_font.chars[c].texture = font_texture;
-        default_font.chars[c].code = c;
-        default_font.chars[c].size[0] = face->glyph->bitmap.width;
-        default_font.chars[c].size[1] = face->glyph->bitmap.rows;
-        default_font.chars[c].bearing[0] = face->glyph->bitmap_left;
-        default_font.chars[c].bearing[1] = face->glyph->bitmap_top;
-        default_font.chars[c].advance = face->glyph->advance.x;
+static
+void _close_face() {
+    if (!self.face)  return;
+
+    FT_Done_Face(self.face);
+    FT_Done_FreeType(self.ft);
+    self.face = NULL;
+    self.ft = NULL;
+}
+
+/* Rasterize SDF of `glyph->code` into `dest` cell (row stride `pitch`) and fill metrics */
+static
+void _rasterize(Glyph* glyph, u8* dest, u32 pitch) {
+    _open_face();
+    FT_GlyphSlot slot = self.face->glyph;
+
+    glyph->size[0] = glyph->size[1] = 0;
+    glyph->bearing[0] = glyph->bearing[1] = 0;
+    glyph->advance = 0;
+
+    if (FT_Load_Char(self.face, glyph->code, FT_LOAD_DEFAULT)) {
+        log_error("ERROR::FREETYPE: Failed to load Glyph for character %d", glyph->code);
+        return;
     }
+    glyph->advance = slot->advance.x >> 6;
+
+    // Glyphs without outline (e.g. space) have nothing to render
+    if (slot->outline.n_points == 0 || FT_Render_Glyph(slot, FT_RENDER_MODE_SDF))
+        return;
+
+    FT_Bitmap* bitmap = &slot->bitmap;
+    u32 width = bitmap->width < FONT_CELL_SIZE ? bitmap->width : FONT_CELL_SIZE;
+    u32 rows = bitmap->rows < FONT_CELL_SIZE ? bitmap->rows : FONT_CELL_SIZE;
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    if (width < bitmap->width || rows < bitmap->rows)
+        log_error("Glyph %d (%dx%d) doesn't fit atlas cell, clipping", glyph->code, bitmap->width, bitmap->rows);
+
+    for (u32 y = 0; y < rows; y++)
+        memcpy(dest + y * pitch, bitmap->buffer + y * bitmap->pitch, width);
+
+    glyph->size[0] = width;
+    glyph->size[1] = rows;
+    glyph->bearing[0] = slot->bitmap_left;
+    glyph->bearing[1] = slot->bitmap_top;
 }
 
+/* ------ Disk Cache ------ */
+/* ------------------------------------------------------------------------- */
 
-void font_unload_default() {
-    for (int i = 0; i < 128; i++) {
-        if (default_font.chars[i].texture) {
-            gfx_unload_texture(default_font.chars[i].texture);
-        }
+static
+bool _cache_read(u8* atlas_rows) {
+    char path[256];
+    _cache_path(path, sizeof(path));
+
+    FILE* file = fopen(path, "rb");
+    if (!file)  return false;
+
+    FontCacheHeader header;
+    FontCacheGlyph entries[FONT_BAKED_COUNT];
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, FONT_CACHE_MAGIC, 4) == 0
+        && header.version == FONT_CACHE_VERSION
+        && header.font_hash == self.font_hash
+        && header.sdf_size == FONT_SDF_SIZE
+        && header.sdf_spread == FONT_SDF_SPREAD
+        && header.atlas_size == FONT_ATLAS_SIZE
+        && header.cell_size == FONT_CELL_SIZE
+        && header.glyphs_count == FONT_BAKED_COUNT
+        && header.atlas_rows == FONT_BAKED_ROWS
+        && fread(entries, sizeof(FontCacheGlyph), FONT_BAKED_COUNT, file) == FONT_BAKED_COUNT
+        && fread(atlas_rows, FONT_ATLAS_SIZE, FONT_BAKED_ROWS, file) == FONT_BAKED_ROWS;
+    fclose(file);
+
+    if (!ok) {
+        log_info("[font] Glyph cache is outdated, rebuilding: %s", path);
+        return false;
+    }
+
+    for (u32 i = 0; i < FONT_BAKED_COUNT; i++) {
+        if (entries[i].cell >= FONT_BAKED_COUNT)  return false;
+    }
+    for (u32 i = 0; i < FONT_BAKED_COUNT; i++) {
+        Glyph* glyph = &self.font.glyphs[entries[i].cell];
+        glyph->code = entries[i].code;
+        glyph->cell = entries[i].cell;
+        glyph->size[0] = entries[i].size[0];
+        glyph->size[1] = entries[i].size[1];
+        glyph->bearing[0] = entries[i].bearing[0];
+        glyph->bearing[1] = entries[i].bearing[1];
+        glyph->advance = entries[i].advance;
+        glyph->is_pinned = true;
+        _register_glyph(glyph);
+    }
+    return true;
+}
+
+static
+void _cache_write(u8* atlas_rows) {
+    char path[256];
+    _cache_path(path, sizeof(path));
+    mkdir(Config.DIR_CACHE, 0755);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        log_error("[font] Unable to write glyph cache: %s", path);
+        return;
+    }
+
+    FontCacheHeader header = {
+        .magic = FONT_CACHE_MAGIC,
+        .version = FONT_CACHE_VERSION,
+        .font_hash = self.font_hash,
+        .sdf_size = FONT_SDF_SIZE,
+        .sdf_spread = FONT_SDF_SPREAD,
+        .atlas_size = FONT_ATLAS_SIZE,
+        .cell_size = FONT_CELL_SIZE,
+        .glyphs_count = FONT_BAKED_COUNT,
+        .atlas_rows = FONT_BAKED_ROWS,
+    };
+    fwrite(&header, sizeof(header), 1, file);
+
+    for (u32 i = 0; i < FONT_BAKED_COUNT; i++) {
+        Glyph* glyph = &self.font.glyphs[i];
+        FontCacheGlyph entry = {
+            .code = glyph->code,
+            .cell = glyph->cell,
+            .size = {glyph->size[0], glyph->size[1]},
+            .bearing = {glyph->bearing[0], glyph->bearing[1]},
+            .advance = glyph->advance,
+        };
+        fwrite(&entry, sizeof(entry), 1, file);
+    }
+    fwrite(atlas_rows, FONT_ATLAS_SIZE, FONT_BAKED_ROWS, file);
+    fclose(file);
+}
+
+static
+void _bake(u8* atlas_rows) {
+    for (u32 i = 0; i < FONT_BAKED_COUNT; i++) {
+        Glyph* glyph = &self.font.glyphs[i];
+        glyph->code = FONT_BAKED_FIRST + i;
+        glyph->cell = i;
+        glyph->is_pinned = true;
+
+        u32 x = (i % FONT_ATLAS_COLS) * FONT_CELL_SIZE;
+        u32 y = (i / FONT_ATLAS_COLS) * FONT_CELL_SIZE;
+        _rasterize(glyph, atlas_rows + y * FONT_ATLAS_SIZE + x, FONT_ATLAS_SIZE);
+        _register_glyph(glyph);
     }
 }
 
+/* ------------------------------------------------------------------------- */
+
+void font_load_default() {
+    f64 start = glfwGetTime();
+
+    self.font_hash = _hash_file(DEFAULT_FONT_PATH);
+    self.font.by_code = map_new(MHASH_INT);
+
+    for (u32 i = 0; i < FONT_ATLAS_CELLS; i++)
+        self.font.glyphs[i].cell = i;
+
+    u8* atlas_rows = calloc(FONT_BAKED_ROWS, FONT_ATLAS_SIZE);
+    bool is_cached = _cache_read(atlas_rows);
+
+    if (!is_cached) {
+        _bake(atlas_rows);
+        _cache_write(atlas_rows);
+    }
+
+    self.font.atlas = gfx_load_font_texture(FONT_ATLAS_SIZE, FONT_ATLAS_SIZE, NULL);
+    gfx_font_texture_update(self.font.atlas, 0, 0, FONT_ATLAS_SIZE, FONT_BAKED_ROWS, atlas_rows);
+    free(atlas_rows);
+
+    log_info(
+        "[font] Glyph atlas ready in %.1f ms (%s)",
+        (glfwGetTime() - start) * 1000.0, is_cached ? "cached" : "baked"
+    );
+}
+
+void font_unload_default() {
+    gfx_unload_texture(self.font.atlas);
+    map_free(self.font.by_code);
+    _close_face();
+    memset(&self.font, 0, sizeof(Font));
+}
 
 Font* font_get_default() {
-    return &default_font;
+    return &self.font;
+}
+
+void font_begin_frame() {
+    self.frame_tick = self.tick;
+}
+
+/* Free cell if any, otherwise least recently used unpinned glyph not used
+   in current frame. NULL if every cell is taken by this frame's glyphs */
+static inline
+Glyph* _acquire_cell(Font* font) {
+    Glyph* lru = NULL;
+
+    for (u32 i = FONT_BAKED_COUNT; i < FONT_ATLAS_CELLS; i++) {
+        Glyph* glyph = &font->glyphs[i];
+        if (glyph->code == 0)  return glyph;
+
+        if (glyph->is_pinned || glyph->last_used > self.frame_tick)  continue;
+        if (!lru || glyph->last_used < lru->last_used)
+            lru = glyph;
+    }
+    if (lru)  map_remove(font->by_code, (void*)(u64)lru->code);
+    return lru;
+}
+
+Glyph* font_get_glyph(Font* font, u32 code) {
+    Glyph* glyph = map_get(font->by_code, (void*)(u64)code);
+
+    if (!glyph) {
+        glyph = _acquire_cell(font);
+        if (!glyph)  return map_get(font->by_code, (void*)(u64)FONT_FALLBACK_CODE);
+
+        glyph->code = code;
+
+        u8 cell[FONT_CELL_SIZE * FONT_CELL_SIZE] = {};
+        _rasterize(glyph, cell, FONT_CELL_SIZE);
+
+        gfx_font_texture_update(
+            font->atlas,
+            (glyph->cell % FONT_ATLAS_COLS) * FONT_CELL_SIZE, (glyph->cell / FONT_ATLAS_COLS) * FONT_CELL_SIZE,
+            FONT_CELL_SIZE, FONT_CELL_SIZE, cell
+        );
+        _register_glyph(glyph);
+    }
+    glyph->last_used = ++self.tick;
+    return glyph;
+}
+
+u32 font_utf8_next(const char** str) {
+    const u8* s = (const u8*)*str;
+    if (*s == 0)  return 0;
+
+    u32 code;
+    int len;
+    if      (s[0] < 0x80)           { code = s[0];        len = 1; }
+    else if ((s[0] & 0xE0) == 0xC0) { code = s[0] & 0x1F; len = 2; }
+    else if ((s[0] & 0xF0) == 0xE0) { code = s[0] & 0x0F; len = 3; }
+    else if ((s[0] & 0xF8) == 0xF0) { code = s[0] & 0x07; len = 4; }
+    else {
+        *str += 1;
+        return 0xFFFD;
+    }
+
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *str += i;
+            return 0xFFFD;  // truncated sequence
+        }
+        code = (code << 6) | (s[i] & 0x3F);
+    }
+    *str += len;
+    return code;
 }
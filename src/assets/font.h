@@ -1,19 +1,43 @@
 #pragma once
+#include "core/containers/map.h"
 #include "graphics/gfx.h"
 
+
+#define FONT_SDF_SIZE     32    // px size glyphs are rasterized at, any UI scale is drawn from it
+#define FONT_SDF_SPREAD   4     // px of distance encoded around glyph outline
+#define FONT_ATLAS_SIZE   1024
+#define FONT_CELL_SIZE    64
+#define FONT_ATLAS_CELLS  ((FONT_ATLAS_SIZE / FONT_CELL_SIZE) * (FONT_ATLAS_SIZE / FONT_CELL_SIZE))
+
+
 typedef struct Glyph {
-    u8 code;                // Character code
-    GfxTexture* texture;    // Glyph texture
-    ivec2 size;             // Glyph size
+    u32 code;               // Unicode codepoint
+    u32 cell;               // Atlas cell index
+    ivec2 size;             // Glyph size (incl. SDF spread)
     ivec2 bearing;          // Offset from baseline to left/top of glyph
-    u32 advance;            // Offset to advance to next glyph
+    u32 advance;            // Offset to advance to next glyph (px)
+    vec4 uv;                // Atlas rect (u0, v0, u1, v1), v0 is glyph top
+
+    u64 last_used;          // LRU stamp
+    bool is_pinned;         // Baked glyph, never evicted
 } Glyph;
 
 typedef struct Font {
-    Glyph chars[128];
+    GfxTexture* atlas;      // Single channel SDF atlas
+    Glyph glyphs[FONT_ATLAS_CELLS];
+    map(Glyph) by_code;
 } Font;
 
 
 void font_load_default();
 void font_unload_default();
 Font* font_get_default();
+
+/* Glyphs returned from now on stay in atlas until next call (call once per frame) */
+void font_begin_frame();
+
+/* Find glyph, missing codepoints are rasterized into atlas on demand */
+Glyph* font_get_glyph(Font*, u32 code);
+
+/* Decode next UTF-8 codepoint and advance `str`, 0 at end of string */
+u32 font_utf8_next(const char** str);
@@ -1,6 +1,11 @@
 #include <stdlib.h>
 #include <assert.h>
+#include <float.h>
 #include <stdbool.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define CGLTF_IMPLEMENTATION
 
@@ -43,12 +48,242 @@ void gltf_close(GLTF_Asset* data) {
 
 
 int gltf_get_nodes_count(GLTF_Asset* data) {
-    assert(data->nodes_count == data->meshes_count);
     return data->nodes_count;
 }
 
 
-void gltf_load_model_nodes(GLTF_Asset* data, ModelNode** dest) {
+/* ------ Attributes & Indices Import ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+cgltf_accessor* _find_attribute(cgltf_primitive* pr, cgltf_attribute_type type) {
+    for (cgltf_size i = 0; i < pr->attributes_count; i++) {
+        if (pr->attributes[i].type == type && pr->attributes[i].index == 0)
+            return pr->attributes[i].data;
+    }
+    return NULL;
+}
+
+static inline
+const u8* _accessor_data(const cgltf_accessor* acc) {
+    return cgltf_buffer_view_data(acc->buffer_view) + acc->offset;
+}
+
+/* Read float attribute honoring stride/offset; non-float or sparse go through cgltf */
+static
+void _read_floats(const cgltf_accessor* acc, f32* dest, u32 comps) {
+    if (acc->component_type != cgltf_component_type_r_32f || acc->is_sparse || !acc->buffer_view) {
+        cgltf_accessor_unpack_floats(acc, dest, acc->count * comps);
+        return;
+    }
+
+    const u8* src = _accessor_data(acc);
+    u64 elem_size = comps * sizeof(f32);
+
+    if (acc->stride == elem_size) {
+        memcpy(dest, src, acc->count * elem_size);
+        return;
+    }
+
+    // Interleaved view: gather fixed-size elements
+    if (comps == 3) {
+        for (cgltf_size i = 0; i < acc->count; i++) {
+            const f32* e = (const f32*)(src + i * acc->stride);
+            dest[i*3 + 0] = e[0];
+            dest[i*3 + 1] = e[1];
+            dest[i*3 + 2] = e[2];
+        }
+    }
+    else {
+        for (cgltf_size i = 0; i < acc->count; i++) {
+            const f32* e = (const f32*)(src + i * acc->stride);
+            dest[i*2 + 0] = e[0];
+            dest[i*2 + 1] = e[1];
+        }
+    }
+}
+
+static inline
+void _widen_u8_u16(const u8* src, u16* dest, u64 count) {
+    u64 i = 0;
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; i < count; i++)  dest[i] = src[i];
+}
+
+static inline
+void _widen_u16_u32(const u16* src, u32* dest, u64 count) {
+    u64 i = 0;
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_unpackhi_epi16(v, zero));
+    }
+#endif
+    for (; i < count; i++)  dest[i] = src[i];
+}
+
+/* Values must fit u16 (primitive has <= 65536 vertices) */
+static inline
+void _narrow_u32_u16(const u32* src, u16* dest, u64 count) {
+    u64 i = 0;
+#ifdef __SSE2__
+    // SSE2 has only signed saturation: bias to signed range, pack, unbias
+    __m128i bias32 = _mm_set1_epi32(0x8000);
+    __m128i bias16 = _mm_set1_epi16((i16)0x8000);
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(src + i)), bias32);
+        __m128i hi = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(src + i + 4)), bias32);
+        __m128i packed = _mm_add_epi16(_mm_packs_epi32(lo, hi), bias16);
+        _mm_storeu_si128((__m128i*)(dest + i), packed);
+    }
+#endif
+    for (; i < count; i++)  dest[i] = (u16)src[i];
+}
+
+static
+void _read_indices(const cgltf_accessor* acc, void* dest, u32 index_size) {
+    u64 count = acc->count;
+    u64 src_size = cgltf_component_size(acc->component_type);
+
+    // Index views are tightly packed by spec; anything else is read element-wise
+    if (acc->is_sparse || !acc->buffer_view || acc->stride != src_size) {
+        cgltf_accessor_unpack_indices(acc, dest, index_size, count);
+        return;
+    }
+    const void* src = _accessor_data(acc);
+
+    if (src_size == index_size) {
+        memcpy(dest, src, count * index_size);
+    }
+    else if (index_size == 2) {
+        if (src_size == 1)  _widen_u8_u16(src, dest, count);
+        else                _narrow_u32_u16(src, dest, count);
+    }
+    else {
+        if (src_size == 2) {
+            _widen_u16_u32(src, dest, count);
+        } else {
+            for (u64 j = 0; j < count; j++)  ((u32*)dest)[j] = ((const u8*)src)[j];
+        }
+    }
+}
+
+static inline
+void _sequential_indices(void* dest, u32 index_size, u64 count) {
+    for (u64 j = 0; j < count; j++) {
+        if (index_size == 2)  ((u16*)dest)[j] = j;
+        else                  ((u32*)dest)[j] = j;
+    }
+}
+
+static inline
+bool _is_drawable(cgltf_primitive* pr, const char* node_name) {
+    if (pr->type != cgltf_primitive_type_triangles) {
+        log_info("Skipping non-triangle primitive in node '%s'", node_name);
+        return false;
+    }
+    if (!_find_attribute(pr, cgltf_attribute_type_position) || !_find_attribute(pr, cgltf_attribute_type_normal)) {
+        log_error("Primitive of node '%s' is missing POSITION or NORMAL attribute. Skipping.", node_name);
+        return false;
+    }
+    return true;
+}
+
+/*
+    All triangle primitives of mesh go to single planar (PPP...NNN...TTT...) vertex
+    buffer and single index buffer, each primitive becomes draw range with base vertex.
+    Indices stay u16 when every primitive has <= 65536 vertices.
+*/
+static
+void _read_mesh(cgltf_mesh* mesh, const char* node_name, ModelNodeData* dest) {
+    u64 vtx_count = 0;
+    u64 ind_count = 0;
+    u64 max_prim_vtx = 0;
+    u32 ranges_count = 0;
+
+    for (cgltf_size p = 0; p < mesh->primitives_count; p++) {
+        cgltf_primitive* pr = &mesh->primitives[p];
+        if (!_is_drawable(pr, node_name))  continue;
+
+        u64 prim_vtx = _find_attribute(pr, cgltf_attribute_type_position)->count;
+        vtx_count += prim_vtx;
+        ind_count += pr->indices ? pr->indices->count : prim_vtx;
+        if (prim_vtx > max_prim_vtx)  max_prim_vtx = prim_vtx;
+        ranges_count++;
+    }
+    if (ranges_count == 0) {
+        log_info("Skipping mesh for node '%s' as it has no drawable primitives.", node_name);
+        return;
+    }
+
+    u32 index_size = max_prim_vtx <= 0x10000 ? sizeof(u16) : sizeof(u32);
+
+    f32* vtx_buf = malloc(vtx_count * 8 * sizeof(f32));
+    u8* ind_buf = malloc(ind_count * index_size);
+    GfxMeshRange* ranges = malloc(sizeof(GfxMeshRange) * ranges_count);
+    if (!vtx_buf || !ind_buf || !ranges)
+        log_exit("Failed to allocate memory for mesh buffers (Node: %s)", node_name);
+
+    f32* positions = vtx_buf;
+    f32* normals = vtx_buf + vtx_count * 3;
+    f32* texcoords = vtx_buf + vtx_count * 6;
+
+    u64 vtx_offset = 0;
+    u64 ind_offset = 0;
+    u32 r = 0;
+
+    for (cgltf_size p = 0; p < mesh->primitives_count; p++) {
+        cgltf_primitive* pr = &mesh->primitives[p];
+        if (!_is_drawable(pr, node_name))  continue;
+
+        cgltf_accessor* pos = _find_attribute(pr, cgltf_attribute_type_position);
+        cgltf_accessor* normal = _find_attribute(pr, cgltf_attribute_type_normal);
+        cgltf_accessor* texcoord = _find_attribute(pr, cgltf_attribute_type_texcoord);
+        u64 prim_vtx = pos->count;
+
+        _read_floats(pos, positions + vtx_offset * 3, 3);
+        _read_floats(normal, normals + vtx_offset * 3, 3);
+
+        if (texcoord)  _read_floats(texcoord, texcoords + vtx_offset * 2, 2);
+        else           memset(texcoords + vtx_offset * 2, 0, prim_vtx * 2 * sizeof(f32));
+
+        u64 prim_ind = pr->indices ? pr->indices->count : prim_vtx;
+        void* ind_dest = ind_buf + ind_offset * index_size;
+
+        if (pr->indices)  _read_indices(pr->indices, ind_dest, index_size);
+        else              _sequential_indices(ind_dest, index_size, prim_vtx);
+
+        ranges[r++] = (GfxMeshRange){
+            .ind_offset = ind_offset,
+            .ind_count = prim_ind,
+            .base_vertex = vtx_offset,
+        };
+        vtx_offset += prim_vtx;
+        ind_offset += prim_ind;
+    }
+
+    // Buffers ownership goes to caller, upload is done separately (`model_upload_node`)
+    dest->vtx_buf = vtx_buf;
+    dest->ind_buf = ind_buf;
+    dest->vtx_count = vtx_count;
+    dest->ind_count = ind_count;
+    dest->index_size = index_size;
+    dest->ranges = ranges;
+    dest->ranges_count = ranges_count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void gltf_read_model_nodes(GLTF_Asset* data, ModelNode** dest, ModelNodeData* dest_data) {
     for (int i = 0; i < gltf_get_nodes_count(data); i++) {
         cgltf_node node = data->nodes[i];
 
@@ -92,134 +327,10 @@ void gltf_load_model_nodes(GLTF_Asset* data, ModelNode** dest) {
             log_info("Skipping node '%s' as it has no mesh.", node.name ? node.name : "[unnamed]");
             continue;
         }
+        // Mesh is shared from asset cache, no need to build buffers
+        if (dest[i]->mesh)  continue;
 
-        // Check primitive count - currently only support one primitive per mesh node
-        if (mesh->primitives_count == 0) {
-             log_info("Skipping mesh for node '%s' as it has no primitives.", node.name ? node.name : "[unnamed]");
-             continue;
-        }
-        if (mesh->primitives_count > 1) {
-            log_info("Mesh for node '%s' has %d primitives. Only processing the first one.", node.name ? node.name : "[unnamed]", mesh->primitives_count);
-        }
-        cgltf_primitive* pr = &mesh->primitives[0];
-        
-        cgltf_accessor* pos_attr;
-        cgltf_accessor* normal_attr;
-        cgltf_accessor* texcoord_attr = NULL;
-        cgltf_accessor* ind_attr = pr->indices;
-        
-        for (int j = 0; j < pr->attributes_count; j++) {
-            cgltf_attribute* attr = &pr->attributes[j];
-            
-            if (attr->type == cgltf_attribute_type_position) {
-                pos_attr = attr->data;
-            }
-            else if (attr->type == cgltf_attribute_type_normal) {        
-                normal_attr = attr->data;
-            }
-            else if (attr->type == cgltf_attribute_type_texcoord) {   
-                if (texcoord_attr != NULL) {
-                    log_exit("Multiple texcoord attrs!");
-                }
-                texcoord_attr = attr->data;
-            }
-            else if (attr->type == cgltf_attribute_type_color) {
-                continue;
-            }
-            else {
-                log_exit("Unprocessed mesh attribute: %i", attr->type);
-            }
-        }
-
-        // Check if essential attributes were found
-        if (!pos_attr) {
-             log_error("Mesh primitive for node '%s' is missing POSITION attribute. Skipping.", node.name ? node.name : "[unnamed]");
-             continue;
-        }
-         if (!normal_attr) {
-             log_error("Mesh primitive for node '%s' is missing NORMAL attribute. Skipping.", node.name ? node.name : "[unnamed]");
-             continue;
-        }
-        // Check if indices exist (required by current loading logic)
-        if (!ind_attr) {
-             log_error("Mesh primitive for node '%s' is missing indices. Skipping.", node.name ? node.name : "[unnamed]");
-             continue;
-        }
-
-        /* -- Buffers Handling --*/
-        cgltf_buffer_view* pos_bufv = pos_attr->buffer_view;
-        cgltf_buffer_view* normal_bufv = normal_attr->buffer_view;
-        cgltf_buffer_view* texcoord_bufv = texcoord_attr->buffer_view;
-        cgltf_buffer_view* ind_bufv = ind_attr->buffer_view;
-        
-        u64 vtx_count = pos_attr->count;
-        f32* vtx_buf = malloc(pos_bufv->size + normal_bufv->size + texcoord_bufv->size);
-        if (!vtx_buf) {
-            log_error("Failed to allocate memory for vertex buffer (Node: %s)", node.name ? node.name : "[unnamed]");
-            // TODO: Consider freeing model data allocated so far before returning NULL
-            cgltf_free(data);
-            exit(EXIT_FAILURE);
-        }
-        memcpy(
-            vtx_buf,
-            pos_bufv->buffer->data + pos_bufv->offset,
-            pos_bufv->size
-        );
-        memcpy(
-            (void*)vtx_buf + pos_bufv->size,
-            normal_bufv->buffer->data + normal_bufv->offset,
-            normal_bufv->size
-        );
-        memcpy(
-            (void*)vtx_buf + pos_bufv->size + normal_bufv->size,
-            texcoord_bufv->buffer->data + texcoord_bufv->offset,
-            texcoord_bufv->size
-        );
-        
-        u64 ind_count = ind_attr->count;
-        // Allocate space for u32 indices
-        u32* ind_buf = malloc(sizeof(u32) * ind_count);
-        if (!ind_buf) {
-            log_error("Failed to allocate memory for index buffer (Node: %s)", node.name ? node.name : "[unnamed]");
-            free(vtx_buf); // Free previously allocated vertex buffer
-            // TODO: Consider freeing model data allocated so far before returning NULL
-            cgltf_free(data);
-            exit(EXIT_FAILURE);
-        }
-
-        // Read indices based on their actual component type
-        void* ind_data_ptr = (u8*)ind_bufv->buffer->data + ind_bufv->offset;
-        
-        for (u64 j = 0; j < ind_count; j++) {
-            switch (ind_attr->component_type) {
-                case cgltf_component_type_r_8u:
-                    ind_buf[j] = ((u8*)ind_data_ptr)[j];
-                    break;
-                case cgltf_component_type_r_16u:
-                    ind_buf[j] = ((u16*)ind_data_ptr)[j];
-                    break;
-                case cgltf_component_type_r_32u:
-                    ind_buf[j] = ((u32*)ind_data_ptr)[j];
-                    break;
-                default:
-                    log_error(
-                        "Unsupported index component type: %d (Node: %s)",
-                        ind_attr->component_type,
-                        node.name ? node.name : "[unnamed]"
-                    );
-                    free(ind_buf);
-                    free(vtx_buf);
-                     // TODO: Consider freeing model data allocated so far before returning NULL
-                    cgltf_free(data);
-                    exit(EXIT_FAILURE);
-            }
-        }
-        
-        GfxMesh* gfx_mesh = gfx_load_mesh(mesh->name, vtx_buf, ind_buf, vtx_count, ind_count, false);
-        free(vtx_buf);
-        free(ind_buf);
-        
-        dest[i]->mesh = gfx_mesh;
+        _read_mesh(mesh, node.name ? node.name : "[unnamed]", &dest_data[i]);
     }
 }
 
@@ -232,28 +343,18 @@ bool gltf_get_mesh_aabb(GLTF_Asset* data, int node_index, vec3 aabb_min, vec3 aa
     if (!node->mesh) {
         return false;
     }
-    cgltf_mesh* mesh = node->mesh;
-    if (mesh->primitives_count == 0) {
-        return false;
-    }
 
-    cgltf_primitive* primitive = &mesh->primitives[0];
-    cgltf_accessor* pos_accessor = NULL;
+    bool found = false;
+    glm_vec3_fill(aabb_min, FLT_MAX);
+    glm_vec3_fill(aabb_max, -FLT_MAX);
 
-    for (int i = 0; i < primitive->attributes_count; i++) {
-        cgltf_attribute* attr = &primitive->attributes[i];
-        if (attr->type == cgltf_attribute_type_position) {
-            pos_accessor = attr->data;
-            break;
-        }
-    }
+    for (cgltf_size p = 0; p < node->mesh->primitives_count; p++) {
+        cgltf_accessor* pos = _find_attribute(&node->mesh->primitives[p], cgltf_attribute_type_position);
+        if (!pos || !pos->has_min || !pos->has_max)  continue;
 
-    if (!pos_accessor || !pos_accessor->has_min || !pos_accessor->has_max) {
-        return false;
+        glm_vec3_minv(aabb_min, pos->min, aabb_min);
+        glm_vec3_maxv(aabb_max, pos->max, aabb_max);
+        found = true;
     }
-
-    glm_vec3_copy(pos_accessor->min, aabb_min);
-    glm_vec3_copy(pos_accessor->max, aabb_max);
-
-    return true;
+    return found;
 }
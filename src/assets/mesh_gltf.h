@@ -13,5 +13,5 @@ GLTF_Asset* gltf_open(char* path);
 void gltf_close(GLTF_Asset* data);
 
 int gltf_get_nodes_count(GLTF_Asset* data);
-void gltf_load_model_nodes(GLTF_Asset* data, ModelNode** dest);
+void gltf_read_model_nodes(GLTF_Asset* data, ModelNode** dest, ModelNodeData* dest_data);
 bool gltf_get_mesh_aabb(GLTF_Asset* data, int node_index, vec3 aabb_min, vec3 aabb_max);
@@ -1,8 +1,12 @@
 #include <float.h>
 #include <string.h>
 
+#include <GLFW/glfw3.h>
+
 #include "model.h"
+#include "assets/asset_cache.h"
 #include "assets/mesh_gltf.h"
+#include "assets/pack.h"
 #include "assets/texture.h"
 
 #include "core/containers/tuple.h"
@@ -75,29 +79,188 @@ void _model_calc_aabb(Model* m) {
 }
 
 
-Model* model_create_from_info(ModelInfo* info) {
-    GLTF_Asset* gltf = gltf_open(info->mesh);
-    int nodes_count = gltf_get_nodes_count(gltf);
+/* Node transforms, AABB and GPU-ready buffers straight from the pack mapping */
+static inline
+void _read_packed_nodes(const PackMeshFile* packed, Model* model, ModelData* data) {
+    const PackMeshNode* pnodes = pack_get_mesh_nodes(packed);
+
+    for (int i = 0; i < data->nodes_count; i++) {
+        const PackMeshNode* pn = &pnodes[i];
+        ModelNode* node = model->nodes[i];
+
+        strncpy(node->name, pack_string(pn->name), sizeof(node->name) - 1);
+        glm_vec3_copy((f32*)pn->position, node->position);
+        glm_vec3_copy((f32*)pn->rotation, node->rotation);
+        glm_vec3_copy((f32*)pn->aabb_min, node->aabb_min);
+        glm_vec3_copy((f32*)pn->aabb_max, node->aabb_max);
+
+        if (!pn->has_mesh || node->mesh)  continue;
+
+        data->nodes[i].vtx_buf = (f32*)pack_blob(pn->vtx_offset);
+        data->nodes[i].ind_buf = (void*)pack_blob(pn->ind_offset);
+        data->nodes[i].vtx_count = pn->vtx_count;
+        data->nodes[i].ind_count = pn->ind_count;
+        data->nodes[i].index_size = pn->index_size;
+        data->nodes[i].ranges = (GfxMeshRange*)pack_blob(pn->ranges_offset);
+        data->nodes[i].ranges_count = pn->ranges_count;
+        data->nodes[i].is_packed = true;
+    }
+}
+
+/* Parse mesh and read textures without touching GPU (thread-safe) */
+ModelData* model_prepare(ModelInfo* info) {
+    const PackMeshFile* packed = pack_find_mesh(info->mesh);
+    GLTF_Asset* gltf = NULL;
+    int nodes_count;
+
+    if (packed) {
+        nodes_count = packed->nodes_count;
+    } else {
+        gltf = gltf_open(info->mesh);
+        nodes_count = gltf_get_nodes_count(gltf);
+    }
 
     // allow only 1 texture per node (mesh)
     assert(info->texture_count == nodes_count);
+
+    ModelData* data = malloc(sizeof(ModelData));
+    data->info = info;
+    data->nodes_count = nodes_count;
+    data->nodes = malloc(sizeof(ModelNodeData) * nodes_count);
+    memset(data->nodes, 0, sizeof(ModelNodeData) * nodes_count);
     
     Model* model = _model_alloc(nodes_count);
-    gltf_load_model_nodes(gltf, model->nodes);
+
+    /* --- Shared Assets (already on GPU, skip reading) --- */
+    int built_count = 0;
+    for (int i = 0; i < nodes_count; i++) {
+        model->nodes[i]->mesh = asset_cache_acquire_mesh(info->mesh, i);
+        model->nodes[i]->texture = asset_cache_acquire_texture(info->textures[i]);
+        if (!model->nodes[i]->mesh)  built_count++;
+    }
+
+    f64 start = glfwGetTime();
+    if (packed)
+        _read_packed_nodes(packed, model, data);
+    else
+        gltf_read_model_nodes(gltf, model->nodes, data->nodes);
+    f64 mesh_time = built_count ? (glfwGetTime() - start) / built_count : 0.0;
 
     int i = 0;
     ModelNode* node;
     tuple_for_each(node, model->nodes) {
-        node->texture = texture_load(info->textures[i]);
+        data->nodes[i].mesh_time = mesh_time;
+
+        if (!node->texture) {
+            start = glfwGetTime();
+            texture_read(info->textures[i], &data->nodes[i].texture);
+            data->nodes[i].texture_time = glfwGetTime() - start;
+        }
         
-        if (!gltf_get_mesh_aabb(gltf, i, node->aabb_min, node->aabb_max)) {
+        if (gltf && !gltf_get_mesh_aabb(gltf, i, node->aabb_min, node->aabb_max)) {
             log_error("Failed to extract AABB for node %d ('%s')", i, node->name);
         }
         i++;
     }
     _model_calc_aabb(model);
 
-    gltf_close(gltf);
+    if (gltf)  gltf_close(gltf);
+
+    model->is_ready = (nodes_count == 0);
+    data->model = model;
+    return data;
+}
+
+static inline
+u64 _mesh_bytes(ModelNodeData* node_data) {
+    // planar (pos, normal, uv) vertices + u16/u32 indices
+    return node_data->vtx_count * 8 * sizeof(f32) + node_data->ind_count * node_data->index_size;
+}
+
+static inline
+u64 _texture_bytes(DDS_File* dds) {
+    u64 bytes = 0;
+    for (u32 level = 0; level < dds->mipmap_cnt; level++)
+        bytes += texture_dds_level_size(dds, level);
+    return bytes;
+}
+
+/* Upload single node to GPU and release its CPU buffers */
+void model_upload_node(ModelData* data, int node_idx) {
+    ModelNode* node = data->model->nodes[node_idx];
+    ModelNodeData* node_data = &data->nodes[node_idx];
+
+    if (node_data->vtx_buf) {
+        // Same mesh could be uploaded by another model while this one was parsed
+        node->mesh = asset_cache_acquire_mesh(data->info->mesh, node_idx);
+
+        if (!node->mesh) {
+            f64 start = glfwGetTime();
+            node->mesh = gfx_load_mesh(
+                node->name,
+                node_data->vtx_buf, node_data->ind_buf,
+                node_data->vtx_count, node_data->ind_count, node_data->index_size,
+                node_data->ranges, node_data->ranges_count,
+                false
+            );
+            asset_cache_add_mesh(
+                data->info->mesh, node_idx, node->mesh,
+                _mesh_bytes(node_data), node_data->mesh_time + glfwGetTime() - start
+            );
+        }
+        if (!node_data->is_packed) {
+            free(node_data->vtx_buf);
+            free(node_data->ind_buf);
+            free(node_data->ranges);
+        }
+        node_data->vtx_buf = NULL;
+        node_data->ind_buf = NULL;
+        node_data->ranges = NULL;
+    }
+
+    if (node_data->texture.data) {
+        char* texture_path = data->info->textures[node_idx];
+        node->texture = asset_cache_acquire_texture(texture_path);
+
+        if (!node->texture) {
+            f64 start = glfwGetTime();
+            node->texture = texture_upload(texture_path, &node_data->texture);
+            asset_cache_add_texture(
+                texture_path, node->texture,
+                _texture_bytes(&node_data->texture), node_data->texture_time + glfwGetTime() - start
+            );
+        }
+        texture_release(&node_data->texture);
+    }
+
+    if (node_idx == data->nodes_count - 1)
+        data->model->is_ready = true;
+}
+
+/* Free CPU-side data; model itself stays alive */
+void model_data_free(ModelData* data) {
+    for (int i = 0; i < data->nodes_count; i++) {
+        if (!data->nodes[i].is_packed) {
+            free(data->nodes[i].vtx_buf);
+            free(data->nodes[i].ind_buf);
+            free(data->nodes[i].ranges);
+        }
+        if (data->nodes[i].texture.data)
+            texture_release(&data->nodes[i].texture);
+    }
+    free(data->nodes);
+    free(data);
+}
+
+
+Model* model_create_from_info(ModelInfo* info) {
+    ModelData* data = model_prepare(info);
+    Model* model = data->model;
+
+    for (int i = 0; i < data->nodes_count; i++)
+        model_upload_node(data, i);
+
+    model_data_free(data);
     return model;
 }
 
@@ -105,8 +268,8 @@ Model* model_create_from_info(ModelInfo* info) {
 void model_destroy(Model* model) {
     ModelNode* node;
     tuple_for_each(node, model->nodes) {
-        gfx_unload_mesh(node->mesh);
-        gfx_unload_texture(node->texture);
+        asset_cache_release_mesh(node->mesh);
+        asset_cache_release_texture(node->texture);
     };
 
     _model_free(model);
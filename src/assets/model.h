@@ -1,5 +1,6 @@
 #pragma once
 
+#include "assets/texture.h"
 #include "database/schemas.h"
 #include "graphics/gfx.h"
 
@@ -26,8 +27,40 @@ typedef struct Model {
         vec3 size;
         vec3 offset;
     } aabb;
+
+    bool is_ready;  // all nodes are uploaded to GPU
 } Model;
 
 
+/* CPU-side node data, waiting for upload */
+typedef struct ModelNodeData {
+    f32* vtx_buf;
+    void* ind_buf;
+    u64 vtx_count;
+    u64 ind_count;
+    u32 index_size;    // 2 (u16) or 4 (u32)
+
+    GfxMeshRange* ranges;  // draw range per glTF primitive
+    u32 ranges_count;
+    bool is_packed;    // buffers point into engine pack (not owned)
+
+    DDS_File texture;
+
+    f64 mesh_time;     // CPU time spent, counted as saved on cache hits
+    f64 texture_time;
+} ModelNodeData;
+
+typedef struct ModelData {
+    ModelInfo* info;
+    Model* model;
+    ModelNodeData* nodes;
+    int nodes_count;
+} ModelData;
+
+
 Model* model_create_from_info(ModelInfo*);
 void model_destroy(Model*);
+
+ModelData* model_prepare(ModelInfo*);
+void model_upload_node(ModelData*, int node_idx);
+void model_data_free(ModelData*);
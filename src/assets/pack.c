@@ -0,0 +1,233 @@
+/*
+    pack.c -- Cooked Engine Pack
+
+    * Whole pack is memory-mapped once; tables, strings, vertex/index buffers
+      and texture mips are used in place, without parsing or heap copies
+    * Pack is skipped (sources are loaded instead) if it's missing, has other
+      version or data .json files are newer than the pack
+    * Single mesh or texture is loaded from source if its file is newer than
+      the one it was cooked from
+*/
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE  // madvise
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pack.h"
+
+#include "core/config.h"
+#include "core/containers/map.h"
+#include "core/log.h"
+#include "platform/file.h"
+
+
+static struct Pack {
+    bool is_loaded;
+    char path[64];
+
+    u8* mapping;
+    u64 size;
+    const PackHeader* header;
+
+    map(PackMeshFile) meshes;
+    map(PackTexture) textures;
+} self = {};
+
+
+/* ------------------------------------------------------------------------- */
+
+static inline
+i64 _file_mtime(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0)  return 0;
+    return st.st_mtime;
+}
+
+static inline
+bool _is_stale(const char* full_path, i64 source_mtime) {
+    if (_file_mtime(full_path) <= source_mtime)  return false;
+
+    log_info("[pack] %s is newer than pack, loading from source", full_path);
+    return true;
+}
+
+static inline
+bool _validate_header(const PackHeader* header, u64 size) {
+    if (size < sizeof(PackHeader) || memcmp(header->magic, PACK_MAGIC, 4) != 0) {
+        log_error("[pack] Invalid pack file: %s", self.path);
+        return false;
+    }
+    if (header->version != PACK_VERSION) {
+        log_info("[pack] Pack version %d is not supported (expected %d), re-cook it", header->version, PACK_VERSION);
+        return false;
+    }
+    if (header->file_size != size) {
+        log_error("[pack] Pack file is truncated: %s", self.path);
+        return false;
+    }
+
+    i64 source_mtime = _file_mtime(Config.PATH_OBJECTS_DATA);
+    i64 scene_mtime = _file_mtime(Config.PATH_SCENES_DATA);
+    if (scene_mtime > source_mtime)  source_mtime = scene_mtime;
+
+    if (source_mtime > header->source_mtime) {
+        log_info("[pack] Data files are newer than pack, loading from sources");
+        return false;
+    }
+    return true;
+}
+
+static inline
+void _build_lookups() {
+    self.meshes = map_new(MHASH_STR);
+    self.textures = map_new(MHASH_STR);
+
+    const PackMeshFile* meshes = pack_table(&self.header->mesh_files);
+    for (u64 i = 0; i < self.header->mesh_files.count; i++)
+        map_set(self.meshes, (void*)&meshes[i], (void*)pack_string(meshes[i].path));
+
+    const PackTexture* textures = pack_table(&self.header->textures);
+    for (u64 i = 0; i < self.header->textures.count; i++)
+        map_set(self.textures, (void*)&textures[i], (void*)pack_string(textures[i].path));
+}
+
+/* ------------------------------------------------------------------------- */
+
+bool pack_open(const char* path) {
+    strncpy(self.path, path, sizeof(self.path) - 1);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)  return false;  // not cooked, nothing to report
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    u8* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        log_error("[pack] Unable to map pack file: %s", path);
+        return false;
+    }
+
+    if (!_validate_header((const PackHeader*)mapping, st.st_size)) {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+
+    self.mapping = mapping;
+    self.size = st.st_size;
+    self.header = (const PackHeader*)mapping;
+    self.is_loaded = true;
+
+    _build_lookups();
+
+    log_info(
+        "[pack] Loaded %s (%.2f MB, %ld meshes, %ld textures)",
+        path, self.size / (1024.0 * 1024.0),
+        self.header->mesh_files.count, self.header->textures.count
+    );
+    return true;
+}
+
+void pack_close() {
+    if (!self.is_loaded)  return;
+
+    map_free(self.meshes);
+    map_free(self.textures);
+
+    munmap(self.mapping, self.size);
+    self.mapping = NULL;
+    self.header = NULL;
+    self.is_loaded = false;
+}
+
+bool pack_is_loaded() {
+    return self.is_loaded;
+}
+
+const char* pack_get_path() {
+    return self.path;
+}
+
+const PackHeader* pack_get_header() {
+    return self.header;
+}
+
+/* ------------------------------------------------------------------------- */
+
+const char* pack_string(u32 offset) {
+    return (const char*)(self.mapping + self.header->strings.offset + offset);
+}
+
+const void* pack_blob(u64 offset) {
+    return self.mapping + offset;
+}
+
+const void* pack_table(const PackSection* section) {
+    return self.mapping + section->offset;
+}
+
+const PackMeshFile* pack_find_mesh(const char* mesh_path) {
+    if (!self.is_loaded)  return NULL;
+
+    const PackMeshFile* mesh = map_get(self.meshes, (void*)mesh_path);
+    if (!mesh)  return NULL;
+
+    const char* full_path;
+    bool is_stale;
+    with_path_to_mesh(full_path, mesh_path, {
+        is_stale = _is_stale(full_path, mesh->source_mtime);
+    });
+    return is_stale ? NULL : mesh;
+}
+
+const PackMeshNode* pack_get_mesh_nodes(const PackMeshFile* mesh) {
+    const PackMeshNode* nodes = pack_table(&self.header->mesh_nodes);
+    return &nodes[mesh->first_node];
+}
+
+/* Fill `dds` with texture data pointing into the pack (not owned, nothing to free) */
+bool pack_read_texture(const char* texture_path, DDS_File* dds) {
+    if (!self.is_loaded)  return false;
+
+    const PackTexture* tex = map_get(self.textures, (void*)texture_path);
+    if (!tex)  return false;
+
+    const char* full_path;
+    bool is_stale;
+    with_path_to_texture(full_path, texture_path, {
+        is_stale = _is_stale(full_path, tex->source_mtime);
+    });
+    if (is_stale)  return false;
+
+    memset(dds, 0, sizeof(DDS_File));
+    dds->width = tex->width;
+    dds->height = tex->height;
+    dds->gl_format = tex->gl_format;
+    dds->block_size = tex->block_size;
+    dds->mipmap_cnt = tex->mipmap_cnt;
+    dds->faces = tex->faces;
+    dds->is_cubemap = tex->faces == 6;
+
+    dds->data_offset = tex->data_offset;
+    dds->data = self.mapping + tex->data_offset;
+    dds->is_packed = true;
+
+    return true;
+}
+
+void pack_log_startup(f64 load_time) {
+    if (!self.is_loaded)  return;
+
+    f64 source_time = self.header->source_load_time;
+    log_info(
+        "[pack] Startup data loaded in %.1f ms (from sources: %.1f ms, %.1fx faster)",
+        load_time * 1000.0, source_time * 1000.0, load_time > 0.0 ? source_time / load_time : 0.0
+    );
+}
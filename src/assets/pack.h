@@ -0,0 +1,102 @@
+#pragma once
+#include <stdbool.h>
+
+#include "assets/texture.h"
+#include "core/types.h"
+
+/*
+    Engine pack layout (little-endian, produced by `make cook`):
+
+        PackHeader
+        tables ....... PackMeshFile[], PackMeshNode[], PackTexture[]
+        strings ...... NUL-terminated, referenced by offset in strings block
+        blobs ........ vertex / index buffers, draw ranges and texture mip chains,
+                       each aligned to PACK_BLOB_ALIGN
+
+    Tables and blobs are used in place from the file mapping. Objects and
+    scenes are cooked separately into database snapshot (`database/snapshot.h`).
+*/
+
+#define PACK_MAGIC       "ILPK"
+#define PACK_VERSION     5
+#define PACK_BLOB_ALIGN  64
+#define PACK_NONE        0xFFFFFFFF
+
+
+typedef struct PackSection {
+    u64 offset;
+    u64 count;  // entries (bytes for strings)
+} PackSection;
+
+typedef struct PackHeader {
+    char magic[4];
+    u32 version;
+    u64 file_size;
+
+    f64 source_load_time;  // seconds spent by cooker to load the same data from sources
+    i64 source_mtime;      // newest mtime of objects/scenes .json
+
+    PackSection mesh_files;
+    PackSection mesh_nodes;
+    PackSection textures;
+    PackSection strings;
+} PackHeader;
+
+
+typedef struct PackMeshFile {
+    u32 path;
+    u32 first_node;
+    u32 nodes_count;
+    u32 _pad;
+    i64 source_mtime;  // of .glb, entry is skipped if source is newer
+} PackMeshFile;
+
+typedef struct PackMeshNode {
+    u32 name;
+    f32 position[3];
+    f32 rotation[3];
+    f32 aabb_min[3];
+    f32 aabb_max[3];
+    u32 has_mesh;
+
+    u64 vtx_offset;  // planar (pos, normal, uv) f32 vertices
+    u64 vtx_count;
+    u64 ind_offset;  // u16 or u32 indices, see `index_size`
+    u64 ind_count;
+    u64 ranges_offset;  // GfxMeshRange[]
+    u32 ranges_count;
+    u32 index_size;
+} PackMeshNode;
+
+typedef struct PackTexture {
+    u32 path;
+    u32 width;
+    u32 height;
+    u32 gl_format;
+    u32 block_size;
+    u32 mipmap_cnt;
+    u32 faces;
+    u32 _pad;
+
+    u64 data_offset;  // level 0 of face 0, levels and faces are tightly packed
+    u64 data_size;
+    i64 source_mtime;  // of .dds, entry is skipped if source is newer
+} PackTexture;
+
+bool pack_open(const char* path);
+void pack_close();
+
+bool pack_is_loaded();
+const char* pack_get_path();
+const PackHeader* pack_get_header();
+
+const char* pack_string(u32 offset);
+const void* pack_blob(u64 offset);
+const void* pack_table(const PackSection* section);
+
+const PackMeshFile* pack_find_mesh(const char* mesh_path);
+const PackMeshNode* pack_get_mesh_nodes(const PackMeshFile* mesh);
+
+bool pack_read_texture(const char* texture_path, DDS_File* dds);
+
+void pack_log_startup(f64 load_time);
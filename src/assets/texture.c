@@ -2,104 +2,250 @@
 	texture.c -- Textures Management
 
 	* Only .dds format is supported
+	* Files are memory-mapped, GPU upload reads straight from mapping
 */
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE  // madvise
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <GL/gl.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include "texture.h"
+#include "assets/pack.h"
+#include "assets/texture_stream.h"
 
+#include "core/cgm.h"
+#include "core/config.h"
 #include "core/log.h"
 #include "platform/file.h"
 
 
-typedef struct {
-	u8* data;
-	u32 width;
-	u32 height;
+/* ------ DDS Header ------ */
+/* ------------------------------------------------------------------------- */
+
+#define DDPF_FOURCC            0x4
+#define DDSCAPS2_CUBEMAP       0x200
+#define DDS_MISC_TEXTURECUBE   0x4
+
+#define DXGI_FORMAT_BC1_UNORM       71
+#define DXGI_FORMAT_BC1_UNORM_SRGB  72
+#define DXGI_FORMAT_BC2_UNORM       74
+#define DXGI_FORMAT_BC2_UNORM_SRGB  75
+#define DXGI_FORMAT_BC3_UNORM       77
+#define DXGI_FORMAT_BC3_UNORM_SRGB  78
+#define DXGI_FORMAT_BC7_UNORM       98
+#define DXGI_FORMAT_BC7_UNORM_SRGB  99
+
+static inline
+u32 _read_u32(const u8* buf, u32 offset) {
+	return buf[offset] | (buf[offset+1] << 8) | (buf[offset+2] << 16) | ((u32)buf[offset+3] << 24);
+}
+
+static inline
+bool _parse_dxgi_format(u32 dxgi_format, DDS_File* dds) {
+	switch (dxgi_format) {
+		case DXGI_FORMAT_BC1_UNORM:
+			dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;        dds->block_size = 8;   return true;
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			dds->gl_format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;  dds->block_size = 8;   return true;
+		case DXGI_FORMAT_BC2_UNORM:
+			dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;        dds->block_size = 16;  return true;
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			dds->gl_format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;  dds->block_size = 16;  return true;
+		case DXGI_FORMAT_BC3_UNORM:
+			dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;        dds->block_size = 16;  return true;
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			dds->gl_format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;  dds->block_size = 16;  return true;
+		case DXGI_FORMAT_BC7_UNORM:
+			dds->gl_format = GL_COMPRESSED_RGBA_BPTC_UNORM;           dds->block_size = 16;  return true;
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			dds->gl_format = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;     dds->block_size = 16;  return true;
+		default:
+			return false;
+	}
+}
+
+/* Parse DDS header (with "DDS " magic), `header_size` is amount of bytes available.
+   Supports DXT1/3/5 FourCC and DX10 extended header (BC1-3, BC7), 2D and cubemap.
+*/
+bool texture_parse_dds_header(const u8* header, u64 header_size, DDS_File* dds) {
+	if (header_size < DDS_HEADER_SIZE || memcmp(header, "DDS ", 4) != 0)
+		return false;
+
+	dds->height = _read_u32(header, 12);
+	dds->width = _read_u32(header, 16);
+	dds->mipmap_cnt = _read_u32(header, 28);
+	if (dds->mipmap_cnt == 0)  dds->mipmap_cnt = 1;
+
+	u32 pf_flags = _read_u32(header, 80);
+	u32 caps2 = _read_u32(header, 112);
+
+	dds->data_offset = DDS_HEADER_SIZE;
+	dds->is_cubemap = (caps2 & DDSCAPS2_CUBEMAP) != 0;
+	dds->faces = dds->is_cubemap ? 6 : 1;
+
+	if (!(pf_flags & DDPF_FOURCC))  return false;
+
+	/* --- DX10 Extended Header --- */
+	if (memcmp(header + 84, "DX10", 4) == 0) {
+		if (header_size < DDS_HEADER_SIZE_DX10)  return false;
+
+		u32 dxgi_format = _read_u32(header, 128);
+		u32 misc_flag = _read_u32(header, 136);
+		u32 array_size = _read_u32(header, 140);
 
-	u32 gl_format;
-	u32 mipmap_cnt;
-	u32 block_size;
-} DDS_File;
+		if (array_size > 1)  return false;  // texture arrays are not supported
 
+		dds->data_offset = DDS_HEADER_SIZE_DX10;
+		dds->is_cubemap = (misc_flag & DDS_MISC_TEXTURECUBE) != 0;
+		dds->faces = dds->is_cubemap ? 6 : 1;
 
+		return _parse_dxgi_format(dxgi_format, dds);
+	}
+
+	/* --- Legacy FourCC --- */
+	if (header[84] != 'D' || header[85] != 'X' || header[86] != 'T')
+		return false;
+
+	switch(header[87]) {
+		case '1': // DXT1
+			dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			dds->block_size = 8;
+			return true;
+		case '3': // DXT3
+			dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+			dds->block_size = 16;
+			return true;
+		case '5': // DXT5
+			dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			dds->block_size = 16;
+			return true;
+		default:
+			return false;
+	}
+}
+
+u32 texture_dds_level_size(const DDS_File* dds, u32 level) {
+	u32 w = max(1, dds->width >> level);
+	u32 h = max(1, dds->height >> level);
+	return ((w+3)/4) * ((h+3)/4) * dds->block_size;
+}
+
+static inline
+u64 _dds_face_size(const DDS_File* dds) {
+	u64 size = 0;
+	for (u32 i = 0; i < dds->mipmap_cnt; i++)
+		size += texture_dds_level_size(dds, i);
+	return size;
+}
+
+/* ------ DDS File ------ */
+/* ------------------------------------------------------------------------- */
+
+/* Map whole file, `data` points straight into mapping (no heap copy) */
 static
 void _open_dds_file(DDS_File* dds, const char* path) {
 	const char* full_path;
-	FILE* f;
-	
+	int fd;
+
 	with_path_to_texture(full_path, path, {
-		if((f = fopen(full_path, "rb")) == 0)
+		if ((fd = open(full_path, O_RDONLY)) < 0)
 			log_exit("Unable to open texture file: %s", path);
 	});
 
-	fseek(f, 0, SEEK_END);
-	long file_size = ftell(f);
-	fseek(f, 0, SEEK_SET);
-	
-    /* -- .dds Header Processing -- */
-	u8* header = malloc(128);
-	fread(header, 1, 128, f);
-	
-	if(memcmp(header, "DDS ", 4) != 0) {
-		free(header);
-	    fclose(f);
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < DDS_HEADER_SIZE) {
+		close(fd);
+		log_exit("Error while loading .dds: file is too small (%s)", path);
+	}
+
+	u8* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		log_exit("Unable to map texture file: %s", path);
+
+	madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+	/* -- .dds Header Processing -- */
+	if (memcmp(mapping, "DDS ", 4) != 0) {
+		munmap(mapping, st.st_size);
 		log_exit("Error while loading .dds: invalid signature");
-    }
-	
-	dds->height = (header[12]) | (header[13] << 8) | (header[14] << 16) | (header[15] << 24);
-	dds->width = (header[16]) | (header[17] << 8) | (header[18] << 16) | (header[19] << 24);
-	dds->mipmap_cnt = (header[28]) | (header[29] << 8) | (header[30] << 16) | (header[31] << 24);
-
-	if(header[84] == 'D') {
-		switch(header[87]) {
-			case '1': // DXT1
-				dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
-				dds->block_size = 8;
-				break;
-			case '3': // DXT3
-				dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
-				dds->block_size = 16;
-				break;
-			case '5': // DXT5
-				dds->gl_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
-				dds->block_size = 16;
-				break;
-			default:
-				free(header);
-				fclose(f);
-				log_exit("Unsupported .dds type: only DXT1-5 are supported!");
-		}
-	} else {
-		free(header);
-	    fclose(f);
-		log_exit("Unsupported .dds type: only DXT1-5 are supported!");
-    }
-    free(header);
-	
-    dds->data = malloc(file_size - 128);
-    fread(dds->data, 1, file_size - 128, f);
-	fclose(f);
+	}
+
+	if (!texture_parse_dds_header(mapping, st.st_size, dds)) {
+		munmap(mapping, st.st_size);
+		log_exit("Unsupported .dds type: only DXT1-5 / BC1-3, BC7 are supported!");
+	}
+
+	if (dds->data_offset + _dds_face_size(dds) * dds->faces > (u64)st.st_size) {
+		munmap(mapping, st.st_size);
+		log_exit("Error while loading .dds: truncated file (%s)", path);
+	}
+
+	dds->mapping = mapping;
+	dds->mapping_size = st.st_size;
+	dds->is_packed = false;
+	dds->data = mapping + dds->data_offset;
 }
 
 static
 void _close_dds_file(DDS_File* dds) {
-	free(dds->data);
+	if (dds->mapping)
+		munmap(dds->mapping, dds->mapping_size);
+	else if (!dds->is_packed)
+		free(dds->data);
+
+	dds->mapping = NULL;
+	dds->data = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* CPU part of loading, safe to call from worker threads */
+void texture_read(const char* texture_path, DDS_File* dds) {
+	if (Config.GRAPHICS_TEXTURE_STREAMING) {
+		texture_stream_read(texture_path, dds);
+		return;
+	}
+	if (!pack_read_texture(texture_path, dds))
+		_open_dds_file(dds, texture_path);
+	dds->base_level = 0;
+}
+
+/* GPU part of loading, main thread only */
+GfxTexture* texture_upload(const char* texture_path, DDS_File* dds) {
+	if (Config.GRAPHICS_TEXTURE_STREAMING)
+		return texture_stream_register(texture_path, dds);
+
+	return gfx_load_texture(
+		dds->data, dds->width, dds->height, dds->gl_format, dds->mipmap_cnt, dds->block_size
+	);
+}
+
+void texture_release(DDS_File* dds) {
+	_close_dds_file(dds);
 }
 
 GfxTexture* texture_load(const char* texture_path) {
 	DDS_File dds;
-	_open_dds_file(&dds, texture_path);
+	texture_read(texture_path, &dds);
 
-    GfxTexture* tex = gfx_load_texture(
-		dds.data, dds.width, dds.height, dds.gl_format, dds.mipmap_cnt, dds.block_size
-	);
+	GfxTexture* tex = texture_upload(texture_path, &dds);
 
-    _close_dds_file(&dds);
+	texture_release(&dds);
 	return tex;
 }
 
+void texture_unload(GfxTexture* texture) {
+	if (!texture_stream_unload(texture))
+		gfx_unload_texture(texture);
+}
+
 GfxSkybox* texture_load_skybox(
 	char* path_x, char* path_nx,
 	char* path_y, char* path_ny,
@@ -128,4 +274,28 @@ GfxSkybox* texture_load_skybox(
 	_close_dds_file(&dds_nz);
 
 	return skybox;
-}
\ No newline at end of file
+}
+
+/* Skybox from single cubemap .dds (faces order: +X, -X, +Y, -Y, +Z, -Z) */
+GfxSkybox* texture_load_skybox_cubemap(char* path) {
+	DDS_File dds;
+	_open_dds_file(&dds, path);
+
+	if (!dds.is_cubemap) {
+		_close_dds_file(&dds);
+		log_exit("Texture is not a cubemap: %s", path);
+	}
+
+	u64 face_size = _dds_face_size(&dds);
+	u8* faces[6];
+	for (int i = 0; i < 6; i++)
+		faces[i] = dds.data + face_size * i;
+
+	GfxSkybox* skybox = gfx_load_skybox(
+		faces[0], faces[1], faces[2], faces[3], faces[4], faces[5],
+		dds.width, dds.height, dds.gl_format, dds.block_size
+	);
+
+	_close_dds_file(&dds);
+	return skybox;
+}
@@ -1,9 +1,42 @@
+#pragma once
 #include "graphics/gfx.h"
 
 
+typedef struct {
+	u8* data;
+	u32 width;
+	u32 height;
+
+	u32 gl_format;
+	u32 mipmap_cnt;
+	u32 block_size;
+	u32 base_level;   // first mip level stored in `data`
+	u32 data_offset;  // file offset of level 0 (after DX10 header, if any)
+
+	bool is_cubemap;
+	u32 faces;        // 6 for cubemaps, each face holds all mip levels
+
+	void* mapping;    // set if `data` points into mapped file
+	u64 mapping_size;
+	bool is_packed;   // `data` points into engine pack (not owned)
+} DDS_File;
+
+#define DDS_HEADER_SIZE       128
+#define DDS_HEADER_SIZE_DX10  (DDS_HEADER_SIZE + 20)
+
+
+bool texture_parse_dds_header(const u8* header, u64 header_size, DDS_File* dds);
+u32 texture_dds_level_size(const DDS_File* dds, u32 level);
+
+void texture_read(const char* texture_path, DDS_File* dds);
+GfxTexture* texture_upload(const char* texture_path, DDS_File* dds);
+void texture_release(DDS_File* dds);
+
 GfxTexture* texture_load(const char* texture_path);
+void texture_unload(GfxTexture* texture);
 GfxSkybox* texture_load_skybox(
 	char* path_x, char* path_nx,
 	char* path_y, char* path_ny,
 	char* path_z, char* path_nz 
 );
+GfxSkybox* texture_load_skybox_cubemap(char* path);
@@ -0,0 +1,477 @@
+/*
+	texture_stream.c -- Mip-level Texture Streaming
+
+	* On load only the smallest mips (<= STREAM_INITIAL_SIZE px) are uploaded
+	* Higher mips are read from .dds in background thread, one level at a time,
+	  when projected screen size of objects using the texture requires them
+	* Resident levels are clamped with GL_TEXTURE_BASE_LEVEL; under memory
+	  pressure top levels of stale textures are dropped again
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <GL/gl.h>
+#include <cvector.h>
+#include <cvector_utils.h>
+
+#include "texture_stream.h"
+#include "assets/pack.h"
+#include "assets/texture.h"
+
+#include "core/cgm.h"
+#include "core/config.h"
+#include "core/containers/map.h"
+#include "core/log.h"
+#include "platform/file.h"
+
+
+#define STREAM_MAX_LEVELS       16
+#define STREAM_INITIAL_SIZE     64      // max texture dimension uploaded on load
+#define STREAM_MAX_PENDING      8       // max level reads in flight
+#define STREAM_PATH_LENGTH      256
+
+
+typedef struct TextureStreamEntry {
+	u32 stream_id;
+	GfxTexture* texture;
+	char path[STREAM_PATH_LENGTH];
+
+	DDS_File dds;
+	u64 level_offset[STREAM_MAX_LEVELS];
+	u32 level_size[STREAM_MAX_LEVELS];
+
+	u32 resident_base;      // highest resolution level uploaded
+	u32 wanted_base;        // level required by last requests
+	u32 min_resident_base;  // levels uploaded on load, never dropped
+	u64 last_request_frame;
+	bool pending;
+	bool failed;            // level read failed, no more levels are streamed
+} TextureStreamEntry;
+
+typedef struct StreamJob {
+	GfxTexture* texture;
+	u32 stream_id;
+	u32 level;
+	u64 offset;
+	u32 size;
+	char path[STREAM_PATH_LENGTH];
+	u8* data;
+} StreamJob;
+
+
+static struct TextureStream {
+	map(TextureStreamEntry) entries;
+	u32 next_stream_id;
+	u64 frame;
+
+	u64 resident_bytes;
+	u64 pending_bytes;
+	u64 budget_bytes;
+	u32 pending_count;
+
+	pthread_t worker;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	cvector(StreamJob) jobs;
+	cvector(StreamJob) done;
+	bool stop;
+} self = {};
+
+
+/* ------ Worker ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void _read_level(StreamJob* job) {
+	int fd = open(job->path, O_RDONLY);
+	if (fd < 0) {
+		log_error("[texture_stream] Unable to open texture file, higher levels are not streamed: %s", job->path);
+		return;
+	}
+
+	job->data = malloc(job->size);
+	if (pread(fd, job->data, job->size, job->offset) != job->size) {
+		log_error("[texture_stream] Unable to read level %u, higher levels are not streamed: %s", job->level, job->path);
+		free(job->data);
+		job->data = NULL;
+	}
+	close(fd);
+}
+
+static
+void* _stream_worker(void* _) {
+	pthread_mutex_lock(&self.lock);
+
+	while (true) {
+		while (!self.stop && cvector_empty(self.jobs))
+			pthread_cond_wait(&self.cond, &self.lock);
+
+		if (self.stop)  break;
+
+		StreamJob job = self.jobs[0];
+		cvector_erase(self.jobs, 0);
+		pthread_mutex_unlock(&self.lock);
+
+		_read_level(&job);
+
+		pthread_mutex_lock(&self.lock);
+		cvector_push_back(self.done, job);
+	}
+
+	pthread_mutex_unlock(&self.lock);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void texture_stream_init() {
+	self.entries = map_new(MHASH_INT);
+	self.next_stream_id = 1;
+	self.frame = 0;
+	self.budget_bytes = (u64)Config.GRAPHICS_TEXTURE_BUDGET_MB * 1024 * 1024;
+
+	if (!Config.GRAPHICS_TEXTURE_STREAMING)  return;
+
+	cvector_reserve(self.jobs, STREAM_MAX_PENDING);
+	cvector_reserve(self.done, STREAM_MAX_PENDING);
+
+	pthread_mutex_init(&self.lock, NULL);
+	pthread_cond_init(&self.cond, NULL);
+	self.stop = false;
+
+	if (pthread_create(&self.worker, NULL, _stream_worker, NULL) != 0)
+		log_exit("[texture_stream] Unable to start worker thread");
+}
+
+void texture_stream_destroy() {
+	if (Config.GRAPHICS_TEXTURE_STREAMING) {
+		pthread_mutex_lock(&self.lock);
+		self.stop = true;
+		pthread_cond_broadcast(&self.cond);
+		pthread_mutex_unlock(&self.lock);
+		pthread_join(self.worker, NULL);
+
+		StreamJob* job;
+		cvector_for_each_in(job, self.done) {
+			free(job->data);
+		}
+		cvector_free(self.jobs);
+		cvector_free(self.done);
+
+		pthread_cond_destroy(&self.cond);
+		pthread_mutex_destroy(&self.lock);
+	}
+
+	TextureStreamEntry* entry;
+	map_for_each(entry, self.entries) {
+		gfx_unload_texture(entry->texture);
+		free(entry);
+	}
+	map_free(self.entries);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline
+u32 _level_dim(u32 width, u32 height, u32 level) {
+	return max(1, max(width, height) >> level);
+}
+
+/* Smallest level set which covers STREAM_INITIAL_SIZE, returns offset of its first level */
+static inline
+u64 _select_initial_levels(DDS_File* dds, u64* tail_size) {
+	dds->mipmap_cnt = min(dds->mipmap_cnt, STREAM_MAX_LEVELS);
+
+	u32 base = dds->mipmap_cnt - 1;
+	while (base > 0 && _level_dim(dds->width, dds->height, base - 1) <= STREAM_INITIAL_SIZE)
+		base--;
+
+	u64 base_offset = dds->data_offset;
+	*tail_size = 0;
+	for (u32 i = 0; i < dds->mipmap_cnt; i++) {
+		if (i < base)  base_offset += texture_dds_level_size(dds, i);
+		else           *tail_size += texture_dds_level_size(dds, i);
+	}
+
+	dds->base_level = base;
+	return base_offset;
+}
+
+/* Read header and the lowest mips only (<= STREAM_INITIAL_SIZE).
+   Doesn't touch streamer state, so could be called from worker threads.
+*/
+void texture_stream_read(const char* texture_path, DDS_File* dds) {
+	u64 tail_size;
+
+	/* -- Cooked: lowest mips are used in place -- */
+	if (pack_read_texture(texture_path, dds)) {
+		if (dds->is_cubemap)
+			log_exit("Cubemap textures can't be streamed: %s", texture_path);
+
+		u64 base_offset = _select_initial_levels(dds, &tail_size);
+		dds->data += base_offset - dds->data_offset;
+		return;
+	}
+
+	const char* full_path;
+	int fd;
+	with_path_to_texture(full_path, texture_path, {
+		fd = open(full_path, O_RDONLY);
+	});
+	if (fd < 0)  log_exit("Unable to open texture file: %s", texture_path);
+
+	/* -- .dds Header Processing -- */
+	u8 header[DDS_HEADER_SIZE_DX10];
+	ssize_t header_size = pread(fd, header, DDS_HEADER_SIZE_DX10, 0);
+	if (header_size < DDS_HEADER_SIZE || memcmp(header, "DDS ", 4) != 0) {
+		close(fd);
+		log_exit("Error while loading .dds: invalid signature");
+	}
+	if (!texture_parse_dds_header(header, header_size, dds)) {
+		close(fd);
+		log_exit("Unsupported .dds type: only DXT1-5 / BC1-3, BC7 are supported!");
+	}
+	if (dds->is_cubemap) {
+		close(fd);
+		log_exit("Cubemap textures can't be streamed: %s", texture_path);
+	}
+	u64 base_offset = _select_initial_levels(dds, &tail_size);
+
+	dds->mapping = NULL;
+	dds->is_packed = false;
+	dds->data = malloc(tail_size);
+	if (pread(fd, dds->data, tail_size, base_offset) != tail_size) {
+		close(fd);
+		log_exit("Unable to read texture file: %s", texture_path);
+	}
+	close(fd);
+}
+
+/* Upload mips read by `texture_stream_read` and start tracking the texture */
+GfxTexture* texture_stream_register(const char* texture_path, DDS_File* dds) {
+	TextureStreamEntry* entry = malloc(sizeof(TextureStreamEntry));
+	memset(entry, 0, sizeof(TextureStreamEntry));
+
+	// higher levels are read later from the same file (pack or .dds)
+	if (dds->is_packed) {
+		strncpy(entry->path, pack_get_path(), STREAM_PATH_LENGTH - 1);
+	}
+	else {
+		const char* full_path;
+		with_path_to_texture(full_path, texture_path, {
+			strncpy(entry->path, full_path, STREAM_PATH_LENGTH - 1);
+		});
+	}
+
+	entry->dds = *dds;
+	entry->dds.data = NULL;
+
+	u64 offset = dds->data_offset;
+	u64 tail_size = 0;
+	for (u32 i = 0; i < dds->mipmap_cnt; i++) {
+		entry->level_offset[i] = offset;
+		entry->level_size[i] = texture_dds_level_size(dds, i);
+		offset += entry->level_size[i];
+
+		if (i >= dds->base_level)  tail_size += entry->level_size[i];
+	}
+
+	u32 base = dds->base_level;
+	entry->texture = gfx_load_texture_levels(
+		dds->data, dds->width, dds->height, dds->gl_format, dds->block_size, base, dds->mipmap_cnt
+	);
+
+	entry->stream_id = self.next_stream_id++;
+	entry->resident_base = base;
+	entry->wanted_base = base;
+	entry->min_resident_base = base;
+	entry->last_request_frame = self.frame;
+	self.resident_bytes += tail_size;
+
+	map_set(self.entries, entry, (void*)(intptr_t)entry->texture);
+	return entry->texture;
+}
+
+GfxTexture* texture_stream_load(const char* texture_path) {
+	DDS_File dds;
+	texture_stream_read(texture_path, &dds);
+
+	GfxTexture* texture = texture_stream_register(texture_path, &dds);
+
+	texture_release(&dds);
+	return texture;
+}
+
+bool texture_stream_unload(GfxTexture* texture) {
+	if (!texture || !self.entries)  return false;
+
+	TextureStreamEntry* entry = map_get(self.entries, (void*)(intptr_t)texture);
+	if (!entry)  return false;
+
+	for (u32 i = entry->resident_base; i < entry->dds.mipmap_cnt; i++)
+		self.resident_bytes -= entry->level_size[i];
+
+	// pending read (if any) is discarded on completion by `stream_id` mismatch
+	map_remove(self.entries, (void*)(intptr_t)texture);
+	gfx_unload_texture(entry->texture);
+	free(entry);
+	return true;
+}
+
+/* Register that texture is visible this frame with given projected size (px)
+*/
+void texture_stream_request(GfxTexture* texture, f32 screen_size) {
+	TextureStreamEntry* entry = map_get(self.entries, (void*)(intptr_t)texture);
+	if (!entry)  return;
+
+	// Pick the smallest level which still has at least one texel per pixel
+	DDS_File* dds = &entry->dds;
+	u32 level = 0;
+	while (level + 1 < dds->mipmap_cnt && _level_dim(dds->width, dds->height, level + 1) >= screen_size)
+		level++;
+
+	if (entry->last_request_frame != self.frame) {
+		entry->last_request_frame = self.frame;
+		entry->wanted_base = level;
+	}
+	else if (level < entry->wanted_base) {
+		entry->wanted_base = level;
+	}
+}
+
+/* ------ Update Cycle ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+void _process_completed() {
+	pthread_mutex_lock(&self.lock);
+	cvector(StreamJob) done = self.done;
+	self.done = NULL;
+	pthread_mutex_unlock(&self.lock);
+
+	StreamJob* job;
+	cvector_for_each_in(job, done) {
+		self.pending_bytes -= job->size;
+		self.pending_count--;
+
+		TextureStreamEntry* entry = map_get(self.entries, (void*)(intptr_t)job->texture);
+		bool valid = entry && entry->stream_id == job->stream_id;
+
+		if (valid) {
+			entry->pending = false;
+			entry->failed = !job->data;
+		}
+
+		if (valid && job->data && job->level + 1 == entry->resident_base) {
+			DDS_File* dds = &entry->dds;
+			gfx_texture_upload_level(
+				entry->texture, job->level,
+				max(1, dds->width >> job->level), max(1, dds->height >> job->level),
+				dds->gl_format, job->size, job->data
+			);
+			gfx_texture_set_base_level(entry->texture, job->level);
+
+			entry->resident_base = job->level;
+			self.resident_bytes += job->size;
+		}
+		free(job->data);
+	}
+	cvector_free(done);
+}
+
+static inline
+bool _drop_top_level(TextureStreamEntry* entry) {
+	if (entry->pending || entry->resident_base >= entry->min_resident_base)
+		return false;
+
+	u32 level = entry->resident_base;
+	gfx_texture_set_base_level(entry->texture, level + 1);
+	gfx_texture_drop_level(entry->texture, level, entry->dds.gl_format);
+
+	entry->resident_base = level + 1;
+	self.resident_bytes -= entry->level_size[level];
+	return true;
+}
+
+/* Drop levels while over budget: first textures holding more than they
+   need, then least recently requested ones
+*/
+static inline
+void _evict_under_pressure() {
+	while (self.resident_bytes > self.budget_bytes) {
+		TextureStreamEntry* entry;
+		TextureStreamEntry* victim = NULL;
+		u64 victim_score = 0;
+
+		map_for_each(entry, self.entries) {
+			if (entry->pending || entry->resident_base >= entry->min_resident_base)
+				continue;
+
+			u64 score = self.frame - entry->last_request_frame + 1;
+			if (entry->wanted_base > entry->resident_base)
+				score += (u64)1 << 32;
+
+			if (score > victim_score) {
+				victim = entry;
+				victim_score = score;
+			}
+		}
+
+		if (!victim || !_drop_top_level(victim))  break;
+	}
+}
+
+static inline
+void _schedule_loads() {
+	TextureStreamEntry* entry;
+
+	map_for_each(entry, self.entries) {
+		if (self.pending_count >= STREAM_MAX_PENDING)  break;
+		if (entry->pending || entry->failed || entry->wanted_base >= entry->resident_base)  continue;
+
+		u32 level = entry->resident_base - 1;
+		u32 size = entry->level_size[level];
+
+		if (self.resident_bytes + self.pending_bytes + size > self.budget_bytes)
+			continue;
+
+		StreamJob job = {0};
+		job.texture = entry->texture;
+		job.stream_id = entry->stream_id;
+		job.level = level;
+		job.offset = entry->level_offset[level];
+		job.size = size;
+		strcpy(job.path, entry->path);
+
+		entry->pending = true;
+		self.pending_bytes += size;
+		self.pending_count++;
+
+		pthread_mutex_lock(&self.lock);
+		cvector_push_back(self.jobs, job);
+		pthread_cond_signal(&self.cond);
+		pthread_mutex_unlock(&self.lock);
+	}
+}
+
+void texture_stream_update() {
+	if (!Config.GRAPHICS_TEXTURE_STREAMING)  return;
+
+	_process_completed();
+	_evict_under_pressure();
+	_schedule_loads();
+
+	self.frame++;
+}
+
+void texture_stream_print() {
+	log_debug(
+		"[texture_stream] resident: %.2f MB ; pending: %.2f MB ; budget: %.2f MB",
+		self.resident_bytes / (1024.0 * 1024.0),
+		self.pending_bytes / (1024.0 * 1024.0),
+		self.budget_bytes / (1024.0 * 1024.0)
+	);
+}
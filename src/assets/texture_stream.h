@@ -0,0 +1,18 @@
+#pragma once
+#include <stdbool.h>
+
+#include "assets/texture.h"
+#include "graphics/gfx.h"
+
+
+void texture_stream_init();
+void texture_stream_destroy();
+void texture_stream_update();
+
+void texture_stream_read(const char* texture_path, DDS_File* dds);
+GfxTexture* texture_stream_register(const char* texture_path, DDS_File* dds);
+GfxTexture* texture_stream_load(const char* texture_path);
+bool texture_stream_unload(GfxTexture* texture);
+
+void texture_stream_request(GfxTexture* texture, f32 screen_size);
+void texture_stream_print();
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+
+#include "arena.h"
+
+#include "core/log.h"
+
+
+static inline
+ArenaBlock* _block_new(ArenaBlock* prev, u64 size) {
+    // calloc of big blocks maps fresh zero pages, so zeroing is free
+    ArenaBlock* block = calloc(1, sizeof(ArenaBlock) + size);
+    if (!block)  log_exit("[arena] Out of memory (%llu bytes)", size);
+
+    block->prev = prev;
+    block->size = size;
+    return block;
+}
+
+
+Arena* arena_new() {
+    Arena* arena = calloc(1, sizeof(Arena));
+    arena->head = _block_new(NULL, ARENA_BLOCK_SIZE);
+    return arena;
+}
+
+void arena_free(Arena* arena) {
+    if (!arena)  return;
+
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    free(arena);
+}
+
+void* arena_alloc(Arena* arena, u64 size) {
+    size = (size + ARENA_ALIGN - 1) & ~(u64)(ARENA_ALIGN - 1);
+    arena->allocated += size;
+
+    ArenaBlock* head = arena->head;
+    if (head->used + size <= head->size) {
+        void* ptr = head->data + head->used;
+        head->used += size;
+        return ptr;
+    }
+
+    // Oversized allocation gets own block behind head, so head keeps its free space
+    if (size > ARENA_BLOCK_SIZE / 4) {
+        ArenaBlock* block = _block_new(head->prev, size);
+        block->used = size;
+        head->prev = block;
+        return block->data;
+    }
+
+    arena->head = _block_new(head, ARENA_BLOCK_SIZE);
+    arena->head->used = size;
+    return arena->head->data;
+}
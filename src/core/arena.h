@@ -0,0 +1,30 @@
+#pragma once
+#include "core/types.h"
+
+/*
+    Arena: bump allocator over linked blocks. Allocations are never freed
+    one by one, everything allocated from arena goes away with `arena_free`.
+*/
+
+#define ARENA_BLOCK_SIZE   (1024 * 1024)
+#define ARENA_ALIGN        16
+
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* prev;
+    u64 size;
+    u64 used;
+    _Alignas(ARENA_ALIGN) u8 data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* head;
+    u64 allocated;  // bytes handed out, for stats
+} Arena;
+
+
+Arena* arena_new();
+void arena_free(Arena*);
+
+/* Zero-initialized, aligned to ARENA_ALIGN */
+void* arena_alloc(Arena*, u64 size);
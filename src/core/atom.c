@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include <cvector.h>
+
+#include "atom.h"
+
+#include "core/containers/map.h"
+
+
+typedef struct AtomEntry {
+    Atom atom;
+    u32 hash;  // precomputed string hash
+    char str[];
+} AtomEntry;
+
+
+static struct AtomTable {
+    map(AtomEntry) by_str;
+    cvector(AtomEntry*) entries;  // index is atom, [0] is ATOM_NONE
+} self = {};
+
+
+void atom_init() {
+    self.by_str = map_new(MHASH_STR);
+    cvector_reserve(self.entries, 256);
+    cvector_push_back(self.entries, NULL);
+}
+
+void atom_destroy() {
+    map_free(self.by_str);
+
+    for (u32 i = 1; i < cvector_size(self.entries); i++)
+        free(self.entries[i]);
+    cvector_free(self.entries);
+    self.entries = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+Atom atom_intern(const char* str) {
+    AtomEntry* entry = map_get(self.by_str, (void*)str);
+    if (entry)  return entry->atom;
+
+    u64 len = strlen(str);
+    entry = malloc(sizeof(AtomEntry) + len + 1);
+    memcpy(entry->str, str, len + 1);
+    entry->atom = cvector_size(self.entries);
+    entry->hash = tommy_strhash_u32(0, str);
+
+    cvector_push_back(self.entries, entry);
+    map_set(self.by_str, entry, entry->str);
+    return entry->atom;
+}
+
+Atom atom_find(const char* str) {
+    AtomEntry* entry = map_get(self.by_str, (void*)str);
+    return entry ? entry->atom : ATOM_NONE;
+}
+
+const char* atom_str(Atom atom) {
+    if (atom == ATOM_NONE || atom >= cvector_size(self.entries))  return "";
+    return self.entries[atom]->str;
+}
+
+u32 atom_hash(Atom atom) {
+    if (atom == ATOM_NONE || atom >= cvector_size(self.entries))  return 0;
+    return self.entries[atom]->hash;
+}
+
+u32 atom_count() {
+    return cvector_size(self.entries) - 1;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "core/types.h"
+
+/*
+    Interned strings: every distinct string gets small integer id (atom),
+    so ids are compared and used as map keys without touching characters.
+    Atoms are valid until `atom_destroy`, table is not thread-safe.
+*/
+
+typedef u32 Atom;
+
+#define ATOM_NONE  0
+
+
+void atom_init();
+void atom_destroy();
+
+/* Return atom of string, registering it on first use */
+Atom atom_intern(const char* str);
+/* Return atom of already registered string, ATOM_NONE if not registered */
+Atom atom_find(const char* str);
+
+const char* atom_str(Atom);
+u32 atom_hash(Atom);
+u32 atom_count();
@@ -1,5 +1,12 @@
+#include <math.h>
+
 #include <cglm/cglm.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CGM_X86
+#endif
+
 #include "cgm.h"
 #include "core/config.h"
 #include "core/types.h"
@@ -62,3 +69,277 @@ void cgm_front_vec(f64 yaw, f64 pitch, vec3 dest) {
     );
     glm_normalize(dest);
 }
+
+
+/* ------ Batch model matrices ------ */
+
+/*
+    Matrix is T * Rx * Ry * Rz * S written in closed form, so each object
+    costs 3 sincos and a few multiplies instead of 4x4 products. Angles are
+    reduced in degrees to nearest quadrant (exact), remainder in [-45, 45]
+    goes through minimax polynomials (Cephes sinf/cosf), SIMD kernels
+    evaluate them for 4 (SSE2) or 8 (AVX2) objects at once.
+*/
+
+// Polynomial coefficients for x in [-pi/4, pi/4]
+#define SIN_P0  -1.9515295891e-4f
+#define SIN_P1   8.3321608736e-3f
+#define SIN_P2  -1.6666654611e-1f
+#define COS_P0   2.443315711809948e-5f
+#define COS_P1  -1.388731625493765e-3f
+#define COS_P2   4.166664568298827e-2f
+
+#define DEG_TO_RAD  ((f32)(GLM_PI / 180.0))
+
+/* Rotation terms & translation of one object, in SoA lanes before writing */
+enum { T_R00, T_R01, T_R02, T_R10, T_R11, T_R12, T_R20, T_R21, T_R22, T_X, T_Y, T_Z, T_COUNT };
+
+
+static inline
+void _sincos_deg(f32 deg, f32* s, f32* c) {
+    f32 q = nearbyintf(deg / 90.0f);
+    f32 x = (deg - q * 90.0f) * DEG_TO_RAD;
+    f32 x2 = x * x;
+
+    f32 sx = x + x * x2 * (SIN_P2 + x2 * (SIN_P1 + x2 * SIN_P0));
+    f32 cx = 1.0f - 0.5f * x2 + x2 * x2 * (COS_P2 + x2 * (COS_P1 + x2 * COS_P0));
+
+    i32 quad = (i32)q;
+    if (quad & 1) {
+        f32 tmp = sx;  sx = cx;  cx = tmp;
+    }
+    *s = (quad & 2) ? -sx : sx;
+    *c = ((quad + 1) & 2) ? -cx : cx;
+}
+
+/* Fill matrix from closed form rotation terms, scaled per column */
+static inline
+void _write_mat(const f32 t[T_COUNT], const f32* sc, mat4 dest) {
+    f32 sx = sc ? sc[0] : 1.0f, sy = sc ? sc[1] : 1.0f, sz = sc ? sc[2] : 1.0f;
+
+    dest[0][0] = t[T_R00] * sx;  dest[0][1] = t[T_R10] * sx;  dest[0][2] = t[T_R20] * sx;  dest[0][3] = 0.0f;
+    dest[1][0] = t[T_R01] * sy;  dest[1][1] = t[T_R11] * sy;  dest[1][2] = t[T_R21] * sy;  dest[1][3] = 0.0f;
+    dest[2][0] = t[T_R02] * sz;  dest[2][1] = t[T_R12] * sz;  dest[2][2] = t[T_R22] * sz;  dest[2][3] = 0.0f;
+    dest[3][0] = t[T_X];         dest[3][1] = t[T_Y];         dest[3][2] = t[T_Z];         dest[3][3] = 1.0f;
+}
+
+void cgm_model_mat_batch_scalar(const vec3* pos, const vec3* rot, const vec3* sc, mat4* dest, u64 n) {
+    for (u64 i = 0; i < n; i++) {
+        f32 sa = 0.0f, ca = 1.0f, sb = 0.0f, cb = 1.0f, sg = 0.0f, cg = 1.0f;
+        if (rot) {
+            _sincos_deg(rot[i][0], &sa, &ca);
+            _sincos_deg(rot[i][1], &sb, &cb);
+            _sincos_deg(rot[i][2], &sg, &cg);
+        }
+
+        f32 t[T_COUNT] = {
+            [T_R00] = cb * cg,
+            [T_R01] = -cb * sg,
+            [T_R02] = sb,
+            [T_R10] = ca * sg + sa * sb * cg,
+            [T_R11] = ca * cg - sa * sb * sg,
+            [T_R12] = -sa * cb,
+            [T_R20] = sa * sg - ca * sb * cg,
+            [T_R21] = sa * cg + ca * sb * sg,
+            [T_R22] = ca * cb,
+            [T_X] = pos ? pos[i][0] : 0.0f,
+            [T_Y] = pos ? pos[i][1] : 0.0f,
+            [T_Z] = pos ? pos[i][2] : 0.0f,
+        };
+        _write_mat(t, sc ? sc[i] : NULL, dest[i]);
+    }
+}
+
+#ifdef CGM_X86
+
+/* Transpose lanes of `t` (T_COUNT x width) into `width` matrices */
+static inline
+void _write_lanes(const f32* t, u32 width, const vec3* sc, mat4* dest) {
+    for (u32 l = 0; l < width; l++) {
+        f32 lane[T_COUNT];
+        for (u32 k = 0; k < T_COUNT; k++)  lane[k] = t[k * width + l];
+        _write_mat(lane, sc ? sc[l] : NULL, dest[l]);
+    }
+}
+
+__attribute__((target("sse2")))
+static inline
+void _sincos_deg_sse2(__m128 deg, __m128* s, __m128* c) {
+    __m128i quad = _mm_cvtps_epi32(_mm_mul_ps(deg, _mm_set1_ps(1.0f / 90.0f)));
+    __m128 q = _mm_cvtepi32_ps(quad);
+    __m128 x = _mm_mul_ps(_mm_sub_ps(deg, _mm_mul_ps(q, _mm_set1_ps(90.0f))), _mm_set1_ps(DEG_TO_RAD));
+    __m128 x2 = _mm_mul_ps(x, x);
+
+    __m128 ps = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(SIN_P0)), _mm_set1_ps(SIN_P1));
+    ps = _mm_add_ps(_mm_mul_ps(ps, x2), _mm_set1_ps(SIN_P2));
+    __m128 sx = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(ps, x2), x));
+
+    __m128 pc = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(COS_P0)), _mm_set1_ps(COS_P1));
+    pc = _mm_add_ps(_mm_mul_ps(pc, x2), _mm_set1_ps(COS_P2));
+    __m128 cx = _mm_add_ps(
+        _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, _mm_set1_ps(0.5f))),
+        _mm_mul_ps(_mm_mul_ps(x2, x2), pc)
+    );
+
+    // Odd quadrants swap sin & cos, signs come from quadrant bit 1
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quad, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 rs = _mm_or_ps(_mm_and_ps(swap, cx), _mm_andnot_ps(swap, sx));
+    __m128 rc = _mm_or_ps(_mm_and_ps(swap, sx), _mm_andnot_ps(swap, cx));
+    __m128 s_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quad, _mm_set1_epi32(2)), 30));
+    __m128 c_sign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(quad, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30
+    ));
+    *s = _mm_xor_ps(rs, s_sign);
+    *c = _mm_xor_ps(rc, c_sign);
+}
+
+__attribute__((target("sse2")))
+static
+void _model_mat_batch_sse2(const vec3* pos, const vec3* rot, const vec3* sc, mat4* dest, u64 n) {
+    _Alignas(16) f32 in[6][4];
+    _Alignas(16) f32 t[T_COUNT][4];
+
+    u64 i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (u32 l = 0; l < 4; l++) {
+            for (u32 k = 0; k < 3; k++) {
+                in[k][l] = rot ? rot[i + l][k] : 0.0f;
+                in[3 + k][l] = pos ? pos[i + l][k] : 0.0f;
+            }
+        }
+
+        __m128 sa, ca, sb, cb, sg, cg;
+        _sincos_deg_sse2(_mm_load_ps(in[0]), &sa, &ca);
+        _sincos_deg_sse2(_mm_load_ps(in[1]), &sb, &cb);
+        _sincos_deg_sse2(_mm_load_ps(in[2]), &sg, &cg);
+        __m128 sa_sb = _mm_mul_ps(sa, sb), ca_sb = _mm_mul_ps(ca, sb);
+
+        _mm_store_ps(t[T_R00], _mm_mul_ps(cb, cg));
+        _mm_store_ps(t[T_R01], _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cb, sg)));
+        _mm_store_ps(t[T_R02], sb);
+        _mm_store_ps(t[T_R10], _mm_add_ps(_mm_mul_ps(ca, sg), _mm_mul_ps(sa_sb, cg)));
+        _mm_store_ps(t[T_R11], _mm_sub_ps(_mm_mul_ps(ca, cg), _mm_mul_ps(sa_sb, sg)));
+        _mm_store_ps(t[T_R12], _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sa, cb)));
+        _mm_store_ps(t[T_R20], _mm_sub_ps(_mm_mul_ps(sa, sg), _mm_mul_ps(ca_sb, cg)));
+        _mm_store_ps(t[T_R21], _mm_add_ps(_mm_mul_ps(sa, cg), _mm_mul_ps(ca_sb, sg)));
+        _mm_store_ps(t[T_R22], _mm_mul_ps(ca, cb));
+        _mm_store_ps(t[T_X], _mm_load_ps(in[3]));
+        _mm_store_ps(t[T_Y], _mm_load_ps(in[4]));
+        _mm_store_ps(t[T_Z], _mm_load_ps(in[5]));
+
+        _write_lanes(&t[0][0], 4, sc ? sc + i : NULL, dest + i);
+    }
+
+    cgm_model_mat_batch_scalar(
+        pos ? pos + i : NULL, rot ? rot + i : NULL, sc ? sc + i : NULL, dest + i, n - i
+    );
+}
+
+__attribute__((target("avx2,fma")))
+static inline
+void _sincos_deg_avx2(__m256 deg, __m256* s, __m256* c) {
+    __m256 q = _mm256_round_ps(
+        _mm256_mul_ps(deg, _mm256_set1_ps(1.0f / 90.0f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC
+    );
+    __m256i quad = _mm256_cvtps_epi32(q);
+    __m256 x = _mm256_mul_ps(_mm256_fnmadd_ps(q, _mm256_set1_ps(90.0f), deg), _mm256_set1_ps(DEG_TO_RAD));
+    __m256 x2 = _mm256_mul_ps(x, x);
+
+    __m256 ps = _mm256_fmadd_ps(x2, _mm256_set1_ps(SIN_P0), _mm256_set1_ps(SIN_P1));
+    ps = _mm256_fmadd_ps(ps, x2, _mm256_set1_ps(SIN_P2));
+    __m256 sx = _mm256_fmadd_ps(_mm256_mul_ps(ps, x2), x, x);
+
+    __m256 pc = _mm256_fmadd_ps(x2, _mm256_set1_ps(COS_P0), _mm256_set1_ps(COS_P1));
+    pc = _mm256_fmadd_ps(pc, x2, _mm256_set1_ps(COS_P2));
+    __m256 cx = _mm256_fmadd_ps(
+        _mm256_mul_ps(x2, x2), pc, _mm256_fnmadd_ps(x2, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f))
+    );
+
+    // Odd quadrants swap sin & cos, signs come from quadrant bit 1
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(quad, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)
+    ));
+    __m256 rs = _mm256_blendv_ps(sx, cx, swap);
+    __m256 rc = _mm256_blendv_ps(cx, sx, swap);
+    __m256 s_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quad, _mm256_set1_epi32(2)), 30));
+    __m256 c_sign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(quad, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30
+    ));
+    *s = _mm256_xor_ps(rs, s_sign);
+    *c = _mm256_xor_ps(rc, c_sign);
+}
+
+__attribute__((target("avx2,fma")))
+static
+void _model_mat_batch_avx2(const vec3* pos, const vec3* rot, const vec3* sc, mat4* dest, u64 n) {
+    _Alignas(32) f32 in[6][8];
+    _Alignas(32) f32 t[T_COUNT][8];
+
+    u64 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (u32 l = 0; l < 8; l++) {
+            for (u32 k = 0; k < 3; k++) {
+                in[k][l] = rot ? rot[i + l][k] : 0.0f;
+                in[3 + k][l] = pos ? pos[i + l][k] : 0.0f;
+            }
+        }
+
+        __m256 sa, ca, sb, cb, sg, cg;
+        _sincos_deg_avx2(_mm256_load_ps(in[0]), &sa, &ca);
+        _sincos_deg_avx2(_mm256_load_ps(in[1]), &sb, &cb);
+        _sincos_deg_avx2(_mm256_load_ps(in[2]), &sg, &cg);
+        __m256 sa_sb = _mm256_mul_ps(sa, sb), ca_sb = _mm256_mul_ps(ca, sb);
+
+        _mm256_store_ps(t[T_R00], _mm256_mul_ps(cb, cg));
+        _mm256_store_ps(t[T_R01], _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(cb, sg)));
+        _mm256_store_ps(t[T_R02], sb);
+        _mm256_store_ps(t[T_R10], _mm256_fmadd_ps(sa_sb, cg, _mm256_mul_ps(ca, sg)));
+        _mm256_store_ps(t[T_R11], _mm256_fnmadd_ps(sa_sb, sg, _mm256_mul_ps(ca, cg)));
+        _mm256_store_ps(t[T_R12], _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(sa, cb)));
+        _mm256_store_ps(t[T_R20], _mm256_fnmadd_ps(ca_sb, cg, _mm256_mul_ps(sa, sg)));
+        _mm256_store_ps(t[T_R21], _mm256_fmadd_ps(ca_sb, sg, _mm256_mul_ps(sa, cg)));
+        _mm256_store_ps(t[T_R22], _mm256_mul_ps(ca, cb));
+        _mm256_store_ps(t[T_X], _mm256_load_ps(in[3]));
+        _mm256_store_ps(t[T_Y], _mm256_load_ps(in[4]));
+        _mm256_store_ps(t[T_Z], _mm256_load_ps(in[5]));
+
+        _write_lanes(&t[0][0], 8, sc ? sc + i : NULL, dest + i);
+    }
+
+    _model_mat_batch_sse2(pos ? pos + i : NULL, rot ? rot + i : NULL, sc ? sc + i : NULL, dest + i, n - i);
+}
+
+#endif
+
+typedef void (*ModelMatBatchFn)(const vec3*, const vec3*, const vec3*, mat4*, u64);
+
+static struct CgmDispatch {
+    ModelMatBatchFn model_mat_batch;
+    const char* name;
+} dispatch = {};
+
+static
+void _dispatch_init() {
+    dispatch.model_mat_batch = cgm_model_mat_batch_scalar;
+    dispatch.name = "scalar";
+#ifdef CGM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dispatch.model_mat_batch = _model_mat_batch_avx2;
+        dispatch.name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        dispatch.model_mat_batch = _model_mat_batch_sse2;
+        dispatch.name = "sse2";
+    }
+#endif
+}
+
+void cgm_model_mat_batch(const vec3* pos, const vec3* rot, const vec3* sc, mat4* dest, u64 n) {
+    if (!dispatch.model_mat_batch)  _dispatch_init();
+    dispatch.model_mat_batch(pos, rot, sc, dest, n);
+}
+
+const char* cgm_simd_name() {
+    if (!dispatch.model_mat_batch)  _dispatch_init();
+    return dispatch.name;
+}
@@ -19,4 +19,13 @@ void cgm_view_mat(vec3 pos, vec3 v_front, mat4 dest);
 void cgm_model_mat(vec3 pos, vec3 rot, vec3 sc, mat4 dest);
 void cgm_rotation_mat(vec3 rot, mat4 dest);
 
+/*
+    Same matrices as `cgm_model_mat` for `n` objects, any of `pos`, `rot`
+    and `sc` may be NULL. Runs SIMD kernel picked for CPU on first call
+    (AVX2, SSE2 or scalar), `cgm_simd_name` tells which one.
+*/
+void cgm_model_mat_batch(const vec3* pos, const vec3* rot, const vec3* sc, mat4* dest, u64 n);
+void cgm_model_mat_batch_scalar(const vec3* pos, const vec3* rot, const vec3* sc, mat4* dest, u64 n);
+const char* cgm_simd_name();
+
 void cgm_front_vec(f64 yaw, f64 pitch, vec3 dest);
@@ -72,12 +72,41 @@ void config_load(const char* config_path) {
     _read_double("window", "max_framerate", &Config.WINDOW_MAX_FRAMERATE);
 
     _read_bool("graphics", "wireframe", &Config.GRAPHICS_WIREFRAME);
+    _read_bool("graphics", "latency_mode", &Config.GRAPHICS_LATENCY_MODE);
+    _read_int("graphics", "frames_in_flight", &Config.GRAPHICS_FRAMES_IN_FLIGHT);
+    _read_bool("graphics", "latency_log", &Config.GRAPHICS_LATENCY_LOG);
+    _read_bool("graphics", "texture_streaming", &Config.GRAPHICS_TEXTURE_STREAMING);
+    _read_int("graphics", "texture_budget_mb", &Config.GRAPHICS_TEXTURE_BUDGET_MB);
+    _read_bool("graphics", "frustum_culling", &Config.GRAPHICS_FRUSTUM_CULLING);
+
+    _read_bool("assets", "async_loading", &Config.ASSETS_ASYNC_LOADING);
+    _read_int("assets", "workers", &Config.ASSETS_WORKERS);
+    _read_double("assets", "upload_budget_ms", &Config.ASSETS_UPLOAD_BUDGET_MS);
+
+    _read_double("world", "cell_size", &Config.WORLD_CELL_SIZE);
+    _read_double("world", "load_radius", &Config.WORLD_LOAD_RADIUS);
+    _read_double("world", "unload_radius", &Config.WORLD_UNLOAD_RADIUS);
+    _read_double("world", "stream_budget_ms", &Config.WORLD_STREAM_BUDGET_MS);
+
+    _read_double("physics", "step_rate", &Config.PHYSICS_STEP_RATE);
+    _read_int("physics", "max_substeps", &Config.PHYSICS_MAX_SUBSTEPS);
+    _read_bool("physics", "threaded", &Config.PHYSICS_THREADED);
+    _read_double("physics", "sleep_linear", &Config.PHYSICS_SLEEP_LINEAR);
+    _read_double("physics", "sleep_angular", &Config.PHYSICS_SLEEP_ANGULAR);
+    _read_int("physics", "sleep_steps", &Config.PHYSICS_SLEEP_STEPS);
+    _read_double("physics", "active_radius", &Config.PHYSICS_ACTIVE_RADIUS);
+    _read_double("physics", "ring_radius", &Config.PHYSICS_RING_RADIUS);
+    _read_int("physics", "ring_interval", &Config.PHYSICS_RING_INTERVAL);
+    _read_int("physics", "step_threads", &Config.PHYSICS_STEP_THREADS);
 
     _read_string("path", "shaders", Config.DIR_SHADERS);
     _read_string("path", "meshes", Config.DIR_MESHES);
     _read_string("path", "textures", Config.DIR_TEXTURES);
     _read_string("path", "objects_data", Config.PATH_OBJECTS_DATA);
     _read_string("path", "scenes_data", Config.PATH_SCENES_DATA);
+    _read_string("path", "pack", Config.PATH_PACK);
+    _read_string("path", "db_snapshot", Config.PATH_DB_SNAPSHOT);
+    _read_string("path", "cache", Config.DIR_CACHE);
 
     toml_free(toml_conf);
 }
\ No newline at end of file
@@ -16,12 +16,41 @@ typedef struct {
     double WINDOW_MAX_FRAMERATE;
     
     bool GRAPHICS_WIREFRAME;
+    bool GRAPHICS_LATENCY_MODE;
+    int GRAPHICS_FRAMES_IN_FLIGHT;
+    bool GRAPHICS_LATENCY_LOG;
+    bool GRAPHICS_TEXTURE_STREAMING;
+    int GRAPHICS_TEXTURE_BUDGET_MB;
+    bool GRAPHICS_FRUSTUM_CULLING;
+
+    bool ASSETS_ASYNC_LOADING;
+    int ASSETS_WORKERS;
+    double ASSETS_UPLOAD_BUDGET_MS;
+
+    double WORLD_CELL_SIZE;
+    double WORLD_LOAD_RADIUS;
+    double WORLD_UNLOAD_RADIUS;
+    double WORLD_STREAM_BUDGET_MS;
+
+    double PHYSICS_STEP_RATE;
+    int PHYSICS_MAX_SUBSTEPS;
+    bool PHYSICS_THREADED;
+    double PHYSICS_SLEEP_LINEAR;
+    double PHYSICS_SLEEP_ANGULAR;
+    int PHYSICS_SLEEP_STEPS;
+    double PHYSICS_ACTIVE_RADIUS;
+    double PHYSICS_RING_RADIUS;
+    int PHYSICS_RING_INTERVAL;
+    int PHYSICS_STEP_THREADS;
     
     char DIR_SHADERS[64];
     char DIR_MESHES[64];
     char DIR_TEXTURES[64];
     char PATH_OBJECTS_DATA[64];
     char PATH_SCENES_DATA[64];
+    char PATH_PACK[64];
+    char PATH_DB_SNAPSHOT[64];
+    char DIR_CACHE[64];
 } _Config;
 
 extern _Config Config;
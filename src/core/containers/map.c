@@ -55,7 +55,8 @@ void map_remove(map* mp, void* key) {
     auto compare_f = mp->htype == MHASH_STR ? _compare_str : _compare_int;
     u32 hash = mp->htype == MHASH_STR ? _hash_str(key) : _hash_int(key);
 
-    tommy_hashlin_remove(mp, compare_f, key, hash);
+    // Removed item is returned by tommy, it's owned by map
+    free(tommy_hashlin_remove(mp, compare_f, key, hash));
 }
 
 u64 map_size(map* mp) {
@@ -1,51 +1,88 @@
 #include <string.h>
+#include <sys/stat.h>
 
 #include "db.h"
 #include "database/loader.h"
+#include "database/snapshot.h"
 
 #include "core/config.h"
 #include "core/containers/tuple.h"
+#include "core/log.h"
 
 
 static Database self;
 
 
-void db_init() {
-    self.objects = db_load_objects_data(Config.PATH_OBJECTS_DATA);
-    self.scene = db_load_scene_data(Config.PATH_SCENES_DATA);
+static inline
+i64 _file_mtime(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0)  return 0;
+    return st.st_mtime;
 }
 
-void db_destroy() {
+/* Use cooked snapshot if it's up to date and contains current scene */
+static inline
+bool _load_snapshot() {
+    if (!db_snapshot_open(Config.PATH_DB_SNAPSHOT))  return false;
+
+    i64 source_mtime = _file_mtime(Config.PATH_OBJECTS_DATA);
+    i64 scene_mtime = _file_mtime(Config.PATH_SCENES_DATA);
+    if (scene_mtime > source_mtime)  source_mtime = scene_mtime;
+
+    char scene_id[MAX_ID_LENGTH];
+    db_scene_id_from_path(Config.PATH_SCENES_DATA, scene_id);
+
+    if (source_mtime > db_snapshot_source_mtime()) {
+        log_info("[db] Data files are newer than snapshot, loading from sources");
+    }
+    else if (!(self.scene = db_snapshot_find_scene(scene_id))) {
+        log_info("[db] Scene '%s' is not in snapshot, loading from sources", scene_id);
+    }
+    else {
+        self.objects = db_snapshot_objects();
+        return true;
+    }
+    db_snapshot_close();
+    return false;
+}
+
+
+static inline
+void _build_index() {
+    self.objects_index = map_new(MHASH_INT);
+
     ObjectInfo* obj;
     tuple_for_each(obj, self.objects) {
-        if (obj->model) {
-            free(obj->model->textures);
-            free(obj->model);
-        }
-        if (obj->physics) {
-            PhysicsInfo* physics_info;
-            tuple_for_each(physics_info, obj->physics) {
-                free(physics_info);
-            }
-            free(obj->physics);
-        }
-        free(obj);
+        map_set(self.objects_index, obj, (void*)(u64)obj->atom);
+    }
+}
+
+
+void db_init() {
+    if (!_load_snapshot()) {
+        self.arena = arena_new();
+        self.objects = db_load_objects_data(self.arena, Config.PATH_OBJECTS_DATA);
+        self.scene = db_load_scene_data(self.arena, Config.PATH_SCENES_DATA);
+
+        if (!self.objects || !self.scene)  log_exit("[db] Unable to load database");
     }
-    free(self.objects);  
-    free(self.scene->object_refs);
-    free(self.scene);
+    _build_index();
+}
+
+void db_destroy() {
+    map_free(self.objects_index);
+
+    // Snapshot data lives in mapping, JSON data in arena
+    if (db_snapshot_is_loaded())  db_snapshot_close();
+
+    arena_free(self.arena);
+    self = (Database){};
 }
 
 Database* db_get() {
     return &self;
 }
 
-ObjectInfo* db_find_object(char* id) {
-    ObjectInfo* obj = NULL;
-
-    tuple_for_each(obj, self.objects) {
-        // FIXME migrate to map struct
-        if (strcmp(obj->id, id) == 0)  return obj;
-    }
-    return NULL;
+ObjectInfo* db_find_object(Atom id) {
+    return map_get(self.objects_index, (void*)(u64)id);
 }
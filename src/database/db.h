@@ -2,12 +2,18 @@
 
 #include "database/schemas.h"
 
+#include "core/arena.h"
+#include "core/atom.h"
+#include "core/containers/map.h"
 #include "core/types.h"
 
 
 typedef struct Database {
     ObjectInfo** objects;
     SceneInfo* scene;
+
+    map(ObjectInfo) objects_index;  // atom -> object
+    Arena* arena;                   // owns data loaded from JSON, NULL for snapshot
 } Database;
 
 
@@ -15,4 +21,4 @@ void db_init();
 void db_destroy();
 
 Database* db_get();
-ObjectInfo* db_find_object(char* obj_id);
+ObjectInfo* db_find_object(Atom obj_id);
@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "json_stream.h"
+
+#include "core/log.h"
+
+
+// Powers of ten exactly representable in f64
+static const f64 POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+
+static
+int _line(JsonStream* js) {
+    int line = 1;
+    for (const char* p = js->buf; p < js->cur && (p = memchr(p, '\n', js->cur - p)); p++)
+        line++;
+    return line;
+}
+
+static
+void _fail(JsonStream* js, const char* msg) {
+    if (js->failed)  return;
+    js->failed = true;
+
+    log_error("[db] %s:%d: JSON error, %s", js->path, _line(js), msg);
+
+    // Padding is zeroed, every following read sees end of input
+    js->cur = js->end;
+}
+
+static inline
+bool _is_ws(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline
+bool _is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/* ------ Scanning ------ */
+/* ------------------------------------------------------------------------- */
+
+/* Loads may run up to 15 bytes past `end`, into zeroed padding */
+
+static inline
+const char* _skip_ws(const char* p) {
+    if (!_is_ws(*p))  return p;  // compact JSON, single space after ':'
+#ifdef __SSE2__
+    __m128i space = _mm_set1_epi8(' ');
+    __m128i nl = _mm_set1_epi8('\n');
+    __m128i cr = _mm_set1_epi8('\r');
+    __m128i tab = _mm_set1_epi8('\t');
+    for (;;) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, nl)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab))
+        );
+        u32 mask = ~_mm_movemask_epi8(ws) & 0xFFFF;
+        if (mask)  return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#else
+    while (_is_ws(*p))  p++;
+    return p;
+#endif
+}
+
+/* First '"' or '\' at or after `p`, `end` if string is not terminated */
+static inline
+const char* _scan_string(const char* p, const char* end) {
+#ifdef __SSE2__
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i slash = _mm_set1_epi8('\\');
+    while (p < end) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        u32 mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)));
+        if (mask)  return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return end;
+#else
+    while (p < end && *p != '"' && *p != '\\')  p++;
+    return p;
+#endif
+}
+
+/* First '"', '{', '}', '[' or ']' at or after `p`, `end` if there is none */
+static inline
+const char* _scan_structural(const char* p, const char* end) {
+#ifdef __SSE2__
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i open_brace = _mm_set1_epi8('{');
+    __m128i close_brace = _mm_set1_epi8('}');
+    __m128i open_bracket = _mm_set1_epi8('[');
+    __m128i close_bracket = _mm_set1_epi8(']');
+    while (p < end) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i hit = _mm_or_si128(
+            _mm_cmpeq_epi8(v, quote),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, open_brace), _mm_cmpeq_epi8(v, close_brace)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, open_bracket), _mm_cmpeq_epi8(v, close_bracket))
+            )
+        );
+        u32 mask = _mm_movemask_epi8(hit);
+        if (mask)  return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return end;
+#else
+    while (p < end && !strchr("\"{}[]", *p))  p++;
+    return p;
+#endif
+}
+
+static inline
+char _peek(JsonStream* js) {
+    js->cur = _skip_ws(js->cur);
+    return *js->cur;
+}
+
+static inline
+bool _expect(JsonStream* js, char c, const char* msg) {
+    if (_peek(js) != c) {
+        _fail(js, msg);
+        return false;
+    }
+    js->cur++;
+    return true;
+}
+
+/* ------ Values ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+int _hex(char c) {
+    if (c >= '0' && c <= '9')  return c - '0';
+    if (c >= 'a' && c <= 'f')  return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')  return c - 'A' + 10;
+    return -1;
+}
+
+/* Decode escape after '\', returns bytes written to `out` (max 3), 0 on error */
+static inline
+int _unescape(JsonStream* js, char* out) {
+    char c = *js->cur++;
+    switch (c) {
+        case '"': case '\\': case '/':  *out = c; return 1;
+        case 'b':  *out = '\b'; return 1;
+        case 'f':  *out = '\f'; return 1;
+        case 'n':  *out = '\n'; return 1;
+        case 'r':  *out = '\r'; return 1;
+        case 't':  *out = '\t'; return 1;
+        case 'u': {
+            u32 code = 0;
+            for (int i = 0; i < 4; i++) {
+                int h = _hex(*js->cur++);
+                if (h < 0)  return 0;
+                code = code << 4 | h;
+            }
+            // Basic plane only, ids and paths are expected to be plain
+            if (code < 0x80) {
+                out[0] = code;
+                return 1;
+            }
+            if (code < 0x800) {
+                out[0] = 0xC0 | code >> 6;
+                out[1] = 0x80 | (code & 0x3F);
+                return 2;
+            }
+            out[0] = 0xE0 | code >> 12;
+            out[1] = 0x80 | (code >> 6 & 0x3F);
+            out[2] = 0x80 | (code & 0x3F);
+            return 3;
+        }
+    }
+    return 0;
+}
+
+/* Read string body after opening quote, `dest` may be NULL to skip */
+static
+bool _read_string_body(JsonStream* js, char* dest, u64 cap) {
+    u64 len = 0;
+    for (;;) {
+        const char* seg_end = _scan_string(js->cur, js->end);
+        if (seg_end >= js->end) {
+            _fail(js, "unterminated string");
+            break;
+        }
+
+        u64 seg_len = seg_end - js->cur;
+        if (dest && len + 1 < cap) {
+            u64 n = seg_len < cap - 1 - len ? seg_len : cap - 1 - len;
+            memcpy(dest + len, js->cur, n);
+            len += n;
+        }
+        js->cur = seg_end + 1;
+        if (*seg_end == '"')  break;
+
+        char decoded[3];
+        int n = _unescape(js, decoded);
+        if (n == 0) {
+            _fail(js, "invalid escape sequence");
+            break;
+        }
+        for (int i = 0; i < n && dest && len + 1 < cap; i++)
+            dest[len++] = decoded[i];
+    }
+
+    if (dest && cap > 0)  dest[len] = '\0';
+    return !js->failed;
+}
+
+/*
+    Mantissa up to 19 digits and |exponent| <= 22 is exact in f64 math
+    (single correctly rounded multiply/divide), same result as `strtod`,
+    which handles everything else.
+*/
+static
+bool _read_number(JsonStream* js, f64* dest) {
+    const char* start = js->cur;
+    const char* p = start;
+
+    bool negative = *p == '-';
+    if (negative)  p++;
+    if (!_is_digit(*p)) {
+        _fail(js, "expected number");
+        return false;
+    }
+
+    u64 mantissa = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool is_fraction = false;
+    for (; _is_digit(*p) || (*p == '.' && !is_fraction); p++) {
+        if (*p == '.') {
+            is_fraction = true;
+            continue;
+        }
+        // Digits past 19 significant ones are dropped, `strtod` is used then
+        if (digits == 19)  continue;
+
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa > 0;  // leading zeros are not significant
+        exp10 -= is_fraction;
+    }
+
+    bool is_exact = digits < 19;
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        bool exp_negative = *p == '-';
+        if (*p == '-' || *p == '+')  p++;
+
+        int exp = 0;
+        for (; _is_digit(*p); p++)
+            if (exp < 10000)  exp = exp * 10 + (*p - '0');
+        exp10 += exp_negative ? -exp : exp;
+    }
+    js->cur = p;
+
+    if (is_exact && mantissa <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+        f64 value = (f64)mantissa;
+        value = exp10 < 0 ? value / POW10[-exp10] : value * POW10[exp10];
+        *dest = negative ? -value : value;
+    }
+    else {
+        *dest = strtod(start, NULL);
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+bool json_stream_open(JsonStream* js, const char* path) {
+    memset(js, 0, sizeof(JsonStream));
+    js->path = path;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        log_error("[db] Unable to read file: %s", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    js->buf = malloc(len + JSON_PADDING);
+    u64 read = fread(js->buf, 1, len, file);
+    fclose(file);
+    memset(js->buf + read, 0, JSON_PADDING);
+
+    js->cur = js->buf;
+    js->end = js->buf + read;
+    return true;
+}
+
+void json_stream_close(JsonStream* js) {
+    free(js->buf);
+    js->buf = NULL;
+}
+
+bool json_object_begin(JsonStream* js) {
+    return _expect(js, '{', "expected '{'");
+}
+
+bool json_object_next(JsonStream* js, char key[JSON_KEY_MAX]) {
+    char c = _peek(js);
+    if (c == ',') {
+        js->cur++;
+        c = _peek(js);
+    }
+    if (c == '}') {
+        js->cur++;
+        return false;
+    }
+    if (c != '"') {
+        _fail(js, "expected object key");
+        return false;
+    }
+
+    js->cur++;
+    return _read_string_body(js, key, JSON_KEY_MAX) && _expect(js, ':', "expected ':'");
+}
+
+bool json_object_read(JsonStream* js, const JsonField* schema, void* dest, char key[JSON_KEY_MAX]) {
+    while (json_object_next(js, key)) {
+        const JsonField* field = schema;
+        while (field->key && strcmp(field->key, key) != 0)  field++;
+
+        if (!field->key)  return true;
+
+        u8* value = (u8*)dest + field->offset;
+        switch (field->type) {
+            case JFIELD_STRING:
+                json_read_string(js, (char*)value, field->size);
+                break;
+
+            case JFIELD_F32:
+                json_read_f32(js, (f32*)value);
+                break;
+
+            case JFIELD_VEC: {
+                f32 vec[4];
+                if (json_read_f32_array(js, vec, 4) >= field->size)
+                    memcpy(value, vec, sizeof(f32) * field->size);
+                break;
+            }
+
+            case JFIELD_ENUM: {
+                char name[JSON_KEY_MAX];
+                json_read_string(js, name, sizeof(name));
+
+                i32 index = 0;
+                for (i32 i = 1; field->names[i]; i++) {
+                    if (strcmp(field->names[i], name) == 0) {
+                        index = i;
+                        break;
+                    }
+                }
+                *(i32*)value = index;
+                break;
+            }
+
+            case JFIELD_FLAGS: {
+                u32 flags = 0;
+                if (!json_array_begin(js))  break;
+
+                while (json_array_next(js)) {
+                    char name[JSON_KEY_MAX];
+                    json_read_string(js, name, sizeof(name));
+
+                    u32 i = 0;
+                    while (field->names[i] && strcmp(field->names[i], name) != 0)  i++;
+
+                    if (field->names[i])  flags |= 1u << i;
+                    else  log_error("[db] %s:%d: unknown '%s' flag \"%s\", ignored", js->path, _line(js), key, name);
+                }
+                *(u32*)value = flags;
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+bool json_array_begin(JsonStream* js) {
+    return _expect(js, '[', "expected '['");
+}
+
+bool json_array_next(JsonStream* js) {
+    char c = _peek(js);
+    if (c == ',') {
+        js->cur++;
+        c = _peek(js);
+    }
+    if (c == ']') {
+        js->cur++;
+        return false;
+    }
+    if (c == '\0') {
+        _fail(js, "unterminated array");
+        return false;
+    }
+    return true;
+}
+
+bool json_is_array(JsonStream* js) {
+    return _peek(js) == '[';
+}
+
+bool json_is_object(JsonStream* js) {
+    return _peek(js) == '{';
+}
+
+bool json_read_string(JsonStream* js, char* dest, u64 cap) {
+    if (!_expect(js, '"', "expected string"))  return false;
+    return _read_string_body(js, dest, cap);
+}
+
+bool json_read_f32(JsonStream* js, f32* dest) {
+    f64 value;
+    _peek(js);
+    if (!_read_number(js, &value))  return false;
+
+    *dest = (f32)value;
+    return true;
+}
+
+u32 json_read_f32_array(JsonStream* js, f32* dest, u32 max) {
+    if (!json_array_begin(js))  return 0;
+
+    u32 count = 0;
+    while (json_array_next(js)) {
+        if (count < max)  json_read_f32(js, &dest[count]);
+        else              json_skip_value(js);
+        count++;
+    }
+    return count;
+}
+
+void json_skip_value(JsonStream* js) {
+    char c = _peek(js);
+
+    if (c == '"') {
+        js->cur++;
+        _read_string_body(js, NULL, 0);
+        return;
+    }
+
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        for (;;) {
+            const char* p = _scan_structural(js->cur, js->end);
+            if (p >= js->end) {
+                _fail(js, "unterminated object or array");
+                return;
+            }
+            js->cur = p + 1;
+
+            if (*p == '"')                   _read_string_body(js, NULL, 0);
+            else if (*p == '{' || *p == '[')  depth++;
+            else if (--depth == 0)           return;
+        }
+    }
+
+    // Number or literal
+    while (*js->cur && !_is_ws(*js->cur) && *js->cur != ',' && *js->cur != '}' && *js->cur != ']')
+        js->cur++;
+}
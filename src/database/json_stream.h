@@ -0,0 +1,72 @@
+#pragma once
+#include <stdbool.h>
+
+#include "core/types.h"
+
+/*
+    Streaming JSON reader: single forward pass over file buffer, values are
+    written straight into destination structs, no DOM is built.
+
+    Objects are read against schema (table of JsonField terminated by
+    JSON_FIELD_END), keys missing from schema are handed back to caller,
+    which either reads their value or calls `json_skip_value`.
+
+    On first syntax error stream is marked `failed`, error is logged with
+    line number and all further reads return nothing.
+*/
+
+#define JSON_KEY_MAX   64
+#define JSON_PADDING   16   // zero bytes after buffer end, for 16-byte SIMD loads
+
+
+typedef enum JsonFieldType {
+    JFIELD_STRING,      // char[size], truncated
+    JFIELD_F32,
+    JFIELD_VEC,         // f32[size], assigned only if array has at least `size` numbers
+    JFIELD_ENUM,        // i32 index of string in `names`, 0 if not found
+    JFIELD_FLAGS,       // u32 with bit `i` set for each `names[i]` in array of strings, unknown are logged
+} JsonFieldType;
+
+typedef struct JsonField {
+    const char* key;
+    JsonFieldType type;
+    u32 offset;
+    u32 size;
+    const char* const* names;  // JFIELD_ENUM: NULL-terminated, [0] is default value
+                               // JFIELD_FLAGS: NULL-terminated, [i] is bit `i`
+} JsonField;
+
+#define JSON_FIELD_END  {NULL}
+
+
+typedef struct JsonStream {
+    const char* path;
+    char* buf;
+    const char* cur;
+    const char* end;
+    bool failed;
+} JsonStream;
+
+
+bool json_stream_open(JsonStream*, const char* path);
+void json_stream_close(JsonStream*);
+
+/* Objects: `while (json_object_next(js, key)) { read or skip value }` after `json_object_begin` */
+bool json_object_begin(JsonStream*);
+bool json_object_next(JsonStream*, char key[JSON_KEY_MAX]);
+/* Same as `json_object_next`, but values of schema keys are read into `dest` */
+bool json_object_read(JsonStream*, const JsonField* schema, void* dest, char key[JSON_KEY_MAX]);
+
+/* Arrays: `while (json_array_next(js)) { read or skip value }` after `json_array_begin` */
+bool json_array_begin(JsonStream*);
+bool json_array_next(JsonStream*);
+
+bool json_is_array(JsonStream*);
+bool json_is_object(JsonStream*);
+
+bool json_read_string(JsonStream*, char* dest, u64 cap);
+bool json_read_f32(JsonStream*, f32* dest);
+/* Read up to `max` numbers, returns count of array elements */
+u32 json_read_f32_array(JsonStream*, f32* dest, u32 max);
+
+void json_skip_value(JsonStream*);
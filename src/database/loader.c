@@ -1,272 +1,230 @@
+#include <stddef.h>
 #include <string.h>
-#include <cJSON.h>
+
+#include <cvector.h>
 
 #include "loader.h"
+#include "database/json_stream.h"
+
+#include "core/log.h"
+
+
+STATIC_ASSERT(sizeof(ObjectType) == sizeof(i32));
+STATIC_ASSERT(sizeof(PhysicsShape) == sizeof(i32));
+STATIC_ASSERT(JSON_KEY_MAX == MAX_ID_LENGTH);  // object ids are keys
+
+static const char* const OBJECT_TYPE_NAMES[] = {"NULL", "STATIC", "ITEM", NULL};
+static const char* const PHYSICS_SHAPE_NAMES[] = {"NULL", "BOX", "AABB", NULL};
+static const char* const PHYSICS_CATEGORY_NAMES[] = {"STATIC", "ITEM", "PLAYER", "RAY", "TRIGGER", NULL};
+
+
+/* ------ Schemas ------ */
+/* ------------------------------------------------------------------------- */
+
+static const JsonField OBJECT_SCHEMA[] = {
+    {"type", JFIELD_ENUM, offsetof(ObjectInfo, type), .names = OBJECT_TYPE_NAMES},
+    JSON_FIELD_END,
+};
+
+static const JsonField PHYSICS_SCHEMA[] = {
+    {"shape", JFIELD_ENUM, offsetof(PhysicsInfo, shape), .names = PHYSICS_SHAPE_NAMES},
+    {"size",  JFIELD_VEC,  offsetof(PhysicsInfo, size), 3},
+    {"pos",   JFIELD_VEC,  offsetof(PhysicsInfo, pos), 3},
+    {"mass",  JFIELD_F32,  offsetof(PhysicsInfo, mass)},
+    {"category", JFIELD_FLAGS, offsetof(PhysicsInfo, category), .names = PHYSICS_CATEGORY_NAMES},
+    {"collide",  JFIELD_FLAGS, offsetof(PhysicsInfo, collide), .names = PHYSICS_CATEGORY_NAMES},
+    JSON_FIELD_END,
+};
 
-#include "platform/file.h"
+static const JsonField PLAYER_INIT_SCHEMA[] = {
+    {"pos", JFIELD_VEC, offsetof(SceneInfo, player_init_pos), 3},
+    {"rot", JFIELD_VEC, offsetof(SceneInfo, player_init_rot), 2},
+    JSON_FIELD_END,
+};
 
+static const JsonField OBJECT_REF_SCHEMA[] = {
+    {"id",  JFIELD_STRING, offsetof(ObjectRefInfo, id), MAX_ID_LENGTH},
+    {"pos", JFIELD_VEC,    offsetof(ObjectRefInfo, pos), 3},
+    {"rot", JFIELD_VEC,    offsetof(ObjectRefInfo, rot), 3},
+    JSON_FIELD_END,
+};
+
+/* ------------------------------------------------------------------------- */
+
+/* Copy `count` items into one contiguous arena array, return NULL-terminated tuple of them */
 static
-ObjectType _parse_object_type(const char* type_str) {
-    if (strcmp(type_str, "STATIC") == 0) {
-        return OBJECT_STATIC;
-    }
-    if (strcmp(type_str, "ITEM") == 0) {
-        return OBJECT_ITEM;
-    }
-    return OBJECT_NULL;
+void* _arena_tuple(Arena* arena, const void* items, u64 count, u64 item_size) {
+    u8* data = arena_alloc(arena, count * item_size);
+    void** tuple = arena_alloc(arena, sizeof(void*) * (count + 1));
+
+    if (count > 0)  memcpy(data, items, count * item_size);
+    for (u64 i = 0; i < count; i++)
+        tuple[i] = data + i * item_size;
+    return tuple;
 }
 
 static
-PhysicsShape _parse_physics_shape(const char* shape_str) {
-    if (strcmp(shape_str, "BOX") == 0) {
-        return PHSHAPE_BOX;
-    }
-    if (strcmp(shape_str, "AABB") == 0) {
-        return PHSHAPE_AABB;
+void _read_textures(JsonStream* js, Arena* arena, ModelInfo* model) {
+    char textures[MAX_TEXTURES][MAX_TEXTURE_PATH_LENGTH];
+    int count = 0;
+
+    if (!json_array_begin(js))  return;
+    while (json_array_next(js)) {
+        if (count < MAX_TEXTURES)  json_read_string(js, textures[count++], MAX_TEXTURE_PATH_LENGTH);
+        else                       json_skip_value(js);
     }
-    return PHSHAPE_NULL;
+
+    model->textures = arena_alloc(arena, sizeof(textures[0]) * count);
+    model->texture_count = count;
+    memcpy(model->textures, textures, sizeof(textures[0]) * count);
 }
 
+/* Model keys may be in "model" object or at object root, returns false for other keys */
 static
-ModelInfo* _parse_model_info(cJSON* model_json) {
-    if (!model_json) return NULL;
-    
-    ModelInfo* model = malloc(sizeof(ModelInfo));
-    memset(model, 0, sizeof(ModelInfo));
-    
-    cJSON* mesh = cJSON_GetObjectItem(model_json, "mesh");
-    if (mesh && cJSON_IsString(mesh)) {
-        strncpy(model->mesh, mesh->valuestring, MAX_MESH_PATH_LENGTH - 1);
-        model->mesh[MAX_MESH_PATH_LENGTH - 1] = '\0';
-    }
-    
-    cJSON* textures = cJSON_GetObjectItem(model_json, "textures");
-    if (textures && cJSON_IsArray(textures)) {
-        int tex_count = cJSON_GetArraySize(textures);
-        if (tex_count > MAX_TEXTURES) tex_count = MAX_TEXTURES;
-        
-        model->textures = malloc(sizeof(char[MAX_TEXTURE_PATH_LENGTH]) * tex_count);
-        model->texture_count = tex_count;
-        
-        for (int i = 0; i < tex_count; i++) {
-            cJSON* texture = cJSON_GetArrayItem(textures, i);
-            if (cJSON_IsString(texture)) {
-                strncpy(model->textures[i], texture->valuestring, MAX_TEXTURE_PATH_LENGTH - 1);
-                model->textures[i][MAX_TEXTURE_PATH_LENGTH - 1] = '\0';
-            }
-        }
-    }
-    
-    return model;
+bool _read_model_key(JsonStream* js, Arena* arena, ObjectInfo* obj, const char* key) {
+    bool is_mesh = strcmp(key, "mesh") == 0;
+    if (!is_mesh && strcmp(key, "textures") != 0)  return false;
+
+    if (!obj->model)  obj->model = arena_alloc(arena, sizeof(ModelInfo));
+
+    if (is_mesh)  json_read_string(js, obj->model->mesh, MAX_MESH_PATH_LENGTH);
+    else          _read_textures(js, arena, obj->model);
+    return true;
 }
 
 static
-PhysicsInfo* _parse_physics_info(cJSON* physics_json) {
-    if (!physics_json) return NULL;
-    
-    PhysicsInfo* physics = malloc(sizeof(PhysicsInfo));
-    memset(physics, 0, sizeof(PhysicsInfo));
-    
-    cJSON* shape = cJSON_GetObjectItem(physics_json, "shape");
-    if (shape && cJSON_IsString(shape)) {
-        physics->shape = _parse_physics_shape(shape->valuestring);
-    }
-    
-    cJSON* size = cJSON_GetObjectItem(physics_json, "size");
-    if (size && cJSON_IsArray(size) && cJSON_GetArraySize(size) >= 3) {
-        physics->size[0] = cJSON_GetArrayItem(size, 0)->valuedouble;
-        physics->size[1] = cJSON_GetArrayItem(size, 1)->valuedouble;
-        physics->size[2] = cJSON_GetArrayItem(size, 2)->valuedouble;
-    }
-    
-    cJSON* pos = cJSON_GetObjectItem(physics_json, "pos");
-    if (pos && cJSON_IsArray(pos) && cJSON_GetArraySize(pos) >= 3) {
-        physics->pos[0] = cJSON_GetArrayItem(pos, 0)->valuedouble;
-        physics->pos[1] = cJSON_GetArrayItem(pos, 1)->valuedouble;
-        physics->pos[2] = cJSON_GetArrayItem(pos, 2)->valuedouble;
+void _read_physics_info(JsonStream* js, PhysicsInfo* dest) {
+    char key[JSON_KEY_MAX];
+    *dest = (PhysicsInfo){.category = PHCAT_DEFAULT, .collide = PHCAT_DEFAULT};
+
+    if (!json_object_begin(js))  return;
+    while (json_object_read(js, PHYSICS_SCHEMA, dest, key))
+        json_skip_value(js);
+}
+
+/* Physics is either single body or array of them, `scratch` is reused between objects */
+static
+PhysicsInfo** _read_physics(JsonStream* js, Arena* arena, cvector(PhysicsInfo)* scratch) {
+    cvector_clear(*scratch);
+
+    if (json_is_array(js)) {
+        json_array_begin(js);
+        while (json_array_next(js)) {
+            PhysicsInfo info;
+            _read_physics_info(js, &info);
+            cvector_push_back(*scratch, info);
+        }
     }
-    
-    cJSON* mass = cJSON_GetObjectItem(physics_json, "mass");
-    if (mass && cJSON_IsNumber(mass)) {
-        physics->mass = mass->valuedouble;
+    else {
+        PhysicsInfo info;
+        _read_physics_info(js, &info);
+        cvector_push_back(*scratch, info);
     }
-    
-    return physics;
+
+    return _arena_tuple(arena, *scratch, cvector_size(*scratch), sizeof(PhysicsInfo));
 }
 
-ObjectInfo** db_load_objects_data(char* path) {
-    const char* json_content = NULL;
-    ObjectInfo** objects = NULL;
+void db_scene_id_from_path(const char* path, char* dest) {
+    // Extract scene name from path (remove .json extension)
+    const char* filename = strrchr(path, '/');
+
+    if (filename)   filename++;  // Skip the '/'
+    else            filename = path;
     
-    with_file_read(path, json_content, {
-        cJSON* root = cJSON_Parse(json_content);
-        if (!root) {
-            printf("Error parsing JSON: %s\n", cJSON_GetErrorPtr());
-            return NULL;
-        }
-        
-        int object_count = cJSON_GetArraySize(root);
-        objects = malloc(sizeof(ObjectInfo*) * (object_count + 1));
-
-        int i = 0;
-        cJSON* object_json = NULL;
-        cJSON_ArrayForEach(object_json, root) {
-            ObjectInfo* obj = malloc(sizeof(ObjectInfo));
-            memset(obj, 0, sizeof(ObjectInfo));
-            
-            // Set object ID from JSON key
-            strncpy(obj->id, object_json->string, MAX_ID_LENGTH - 1);
-            obj->id[MAX_ID_LENGTH - 1] = '\0';
-            
-            // Parse object type
-            cJSON* type = cJSON_GetObjectItem(object_json, "type");
-            if (type && cJSON_IsString(type)) {
-                obj->type = _parse_object_type(type->valuestring);
-            }
-            
-            // Parse model info
-            cJSON* model = cJSON_GetObjectItem(object_json, "model");
-            if (!model) {
-                // Handle case where mesh/textures are at root level
-                cJSON* mesh = cJSON_GetObjectItem(object_json, "mesh");
-                cJSON* textures = cJSON_GetObjectItem(object_json, "textures");
-                if (mesh || textures) {
-                    obj->model = _parse_model_info(object_json);
+    strncpy(dest, filename, MAX_ID_LENGTH - 1);
+    dest[MAX_ID_LENGTH - 1] = '\0';
+    char* dot = strrchr(dest, '.');
+    if (dot) *dot = '\0'; // Remove extension
+}
+
+ObjectInfo** db_load_objects_data(Arena* arena, char* path) {
+    JsonStream js;
+    if (!json_stream_open(&js, path))  return NULL;
+
+    cvector(ObjectInfo) objects = NULL;
+    cvector(PhysicsInfo) physics = NULL;
+    char key[JSON_KEY_MAX];
+
+    json_object_begin(&js);
+    while (json_object_next(&js, key)) {
+        // Object ID is JSON key
+        ObjectInfo obj = {};
+        strcpy(obj.id, key);
+        obj.atom = atom_intern(obj.id);
+
+        json_object_begin(&js);
+        while (json_object_read(&js, OBJECT_SCHEMA, &obj, key)) {
+            if (strcmp(key, "model") == 0) {
+                json_object_begin(&js);
+                while (json_object_next(&js, key)) {
+                    if (!_read_model_key(&js, arena, &obj, key))  json_skip_value(&js);
                 }
-            } else {
-                obj->model = _parse_model_info(model);
             }
-            
-            // Parse physics info
-            cJSON* physics = cJSON_GetObjectItem(object_json, "physics");
-            if (physics) {
-                if (cJSON_IsArray(physics)) {
-                    // Handle array case
-                    int physics_count = cJSON_GetArraySize(physics);
-                    obj->physics = malloc(sizeof(PhysicsInfo*) * (physics_count + 1));
-                    
-                    for (int j = 0; j < physics_count; j++) {
-                        cJSON* physics_item = cJSON_GetArrayItem(physics, j);
-                        obj->physics[j] = _parse_physics_info(physics_item);
-                    }
-                    obj->physics[physics_count] = NULL;
-                } else {
-                    // Handle single physics body
-                    obj->physics = malloc(sizeof(PhysicsInfo*) * 2);
-                    obj->physics[0] = _parse_physics_info(physics);
-                    obj->physics[1] = NULL;
-                }
+            else if (strcmp(key, "physics") == 0) {
+                obj.physics = _read_physics(&js, arena, &physics);
+            }
+            else if (!_read_model_key(&js, arena, &obj, key)) {
+                json_skip_value(&js);
             }
-            
-            objects[i++] = obj;
         }
-        
-        objects[object_count] = NULL;
-        cJSON_Delete(root);
-    });
-    
-    return objects;
+
+        cvector_push_back(objects, obj);
+    }
+
+    ObjectInfo** result = NULL;
+    if (!js.failed)  result = _arena_tuple(arena, objects, cvector_size(objects), sizeof(ObjectInfo));
+
+    cvector_free(physics);
+    cvector_free(objects);
+    json_stream_close(&js);
+    return result;
 }
 
+SceneInfo* db_load_scene_data(Arena* arena, char* path) {
+    JsonStream js;
+    if (!json_stream_open(&js, path))  return NULL;
 
-SceneInfo* db_load_scene_data(char* path) {
-    const char* json_content = NULL;
-    SceneInfo* scene = NULL;
-    
-    with_file_read(path, json_content, {
-        cJSON* root = cJSON_Parse(json_content);
-        if (!root) {
-            printf("Error parsing JSON: %s\n", cJSON_GetErrorPtr());
-            return NULL;
-        }
-        
-        scene = malloc(sizeof(SceneInfo));
-        memset(scene, 0, sizeof(SceneInfo));
-        
-        // Extract scene name from path (remove .json extension)
-        char* filename = strrchr(path, '/');
-
-        if (filename)   filename++;  // Skip the '/'
-        else            filename = path;
-        
-        char scene_name[MAX_ID_LENGTH];
-        strncpy(scene_name, filename, MAX_ID_LENGTH - 1);
-        scene_name[MAX_ID_LENGTH - 1] = '\0';
-        char* dot = strrchr(scene_name, '.');
-        if (dot) *dot = '\0'; // Remove extension
-        strncpy(scene->id, scene_name, MAX_ID_LENGTH - 1);
-        scene->id[MAX_ID_LENGTH - 1] = '\0';
+    SceneInfo* scene = arena_alloc(arena, sizeof(SceneInfo));
+    db_scene_id_from_path(path, scene->id);
 
+    cvector(ObjectRefInfo) refs = NULL;
+    bool has_refs = false;
+    char key[JSON_KEY_MAX];
+
+    json_object_begin(&js);
+    while (json_object_next(&js, key)) {
         /* --- Player Init --- */
-        cJSON* player_init = cJSON_GetObjectItem(root, "player_init");
-        if (player_init) {
-            cJSON* pos = cJSON_GetObjectItem(player_init, "pos");
-            if (pos && cJSON_IsArray(pos) && cJSON_GetArraySize(pos) >= 3) {
-                scene->player_init_pos[0] = cJSON_GetArrayItem(pos, 0)->valuedouble;
-                scene->player_init_pos[1] = cJSON_GetArrayItem(pos, 1)->valuedouble;
-                scene->player_init_pos[2] = cJSON_GetArrayItem(pos, 2)->valuedouble;
-            }
-            
-            cJSON* rot = cJSON_GetObjectItem(player_init, "rot");
-            if (rot && cJSON_IsArray(rot) && cJSON_GetArraySize(rot) >= 2) {
-                scene->player_init_rot[0] = cJSON_GetArrayItem(rot, 0)->valuedouble;
-                scene->player_init_rot[1] = cJSON_GetArrayItem(rot, 1)->valuedouble;
-            }
+        if (strcmp(key, "player_init") == 0) {
+            json_object_begin(&js);
+            while (json_object_read(&js, PLAYER_INIT_SCHEMA, scene, key))
+                json_skip_value(&js);
         }
-        
         /* --- Object Refs --- */
-        cJSON* object_refs = cJSON_GetObjectItem(root, "object_refs");
-        if (!object_refs) {
-            printf("Warning: No object_refs found in scene JSON\n");
-            scene->object_refs = malloc(sizeof(ObjectRefInfo*));
-            scene->object_refs[0] = NULL;
-            cJSON_Delete(root);
-            return scene;
-        }
-        
-        int object_count = cJSON_GetArraySize(object_refs);
-        scene->object_refs = malloc(sizeof(ObjectRefInfo*) * (object_count + 1));
-
-        int i = 0;
-        cJSON* object_json = NULL;
-        cJSON_ArrayForEach(object_json, object_refs) {
-            ObjectRefInfo* obj_ref = malloc(sizeof(ObjectRefInfo));
-            memset(obj_ref, 0, sizeof(ObjectRefInfo));
-
-            // Parse object ID
-            cJSON* id = cJSON_GetObjectItem(object_json, "id");
-            if (id && cJSON_IsString(id)) {
-                strncpy(obj_ref->id, id->valuestring, MAX_ID_LENGTH - 1);
-                obj_ref->id[MAX_ID_LENGTH - 1] = '\0';
-            }
-            
-            // Parse position
-            cJSON* pos = cJSON_GetObjectItem(object_json, "pos");
-            if (pos && cJSON_IsArray(pos) && cJSON_GetArraySize(pos) >= 3) {
-                obj_ref->pos[0] = cJSON_GetArrayItem(pos, 0)->valuedouble;
-                obj_ref->pos[1] = cJSON_GetArrayItem(pos, 1)->valuedouble;
-                obj_ref->pos[2] = cJSON_GetArrayItem(pos, 2)->valuedouble;
-            }
-            
-            // Parse rotation (optional, defaults to 0)
-            cJSON* rot = cJSON_GetObjectItem(object_json, "rot");
-            if (rot && cJSON_IsArray(rot) && cJSON_GetArraySize(rot) >= 3) {
-                obj_ref->rot[0] = cJSON_GetArrayItem(rot, 0)->valuedouble;
-                obj_ref->rot[1] = cJSON_GetArrayItem(rot, 1)->valuedouble;
-                obj_ref->rot[2] = cJSON_GetArrayItem(rot, 2)->valuedouble;
-            } else {
-                // Default rotation to 0
-                obj_ref->rot[0] = 0.0f;
-                obj_ref->rot[1] = 0.0f;
-                obj_ref->rot[2] = 0.0f;
+        else if (strcmp(key, "object_refs") == 0) {
+            has_refs = true;
+
+            json_array_begin(&js);
+            while (json_array_next(&js)) {
+                ObjectRefInfo ref = {};  // rotation defaults to 0
+
+                json_object_begin(&js);
+                while (json_object_read(&js, OBJECT_REF_SCHEMA, &ref, key))
+                    json_skip_value(&js);
+
+                ref.atom = atom_intern(ref.id);
+                cvector_push_back(refs, ref);
             }
-            
-            scene->object_refs[i++] = obj_ref;
         }
+        else {
+            json_skip_value(&js);
+        }
+    }
 
-        scene->object_refs[object_count] = NULL;
-        cJSON_Delete(root);
-    });
-    
-    return scene;
+    if (!has_refs)  log_info("[db] No object_refs found in scene: %s", path);
+    scene->object_refs = _arena_tuple(arena, refs, cvector_size(refs), sizeof(ObjectRefInfo));
+
+    bool failed = js.failed;
+    cvector_free(refs);
+    json_stream_close(&js);
+    return failed ? NULL : scene;
 }
@@ -2,7 +2,12 @@
 
 #include "database/schemas.h"
 
+#include "core/arena.h"
 
-// WARNING: these functions requiring explicit `free` call after usage
-ObjectInfo** db_load_objects_data(char* path);
-SceneInfo* db_load_scene_data(char* path);
+
+// Loaded data is allocated from `arena`, it's freed together with arena
+ObjectInfo** db_load_objects_data(Arena*, char* path);
+SceneInfo* db_load_scene_data(Arena*, char* path);
+
+// Scene id is file name without extension
+void db_scene_id_from_path(const char* path, char* dest);
@@ -1,6 +1,7 @@
 #pragma once
 #include "cglm/cglm.h"
 
+#include "core/atom.h"
 #include "core/types.h"
 
 #define MAX_ID_LENGTH 64
@@ -21,6 +22,17 @@ typedef enum {
     PHSHAPE_AABB,
 } PhysicsShape;
 
+/* Bits of collision category & collide masks, same as `PxCategory` */
+typedef enum {
+    PHCAT_STATIC   = 1 << 0,
+    PHCAT_ITEM     = 1 << 1,
+    PHCAT_PLAYER   = 1 << 2,
+    PHCAT_RAY      = 1 << 3,
+    PHCAT_TRIGGER  = 1 << 4,
+} PhysicsCategory;
+
+#define PHCAT_DEFAULT  0xFFFFFFFF  // mask not given, default of object type is kept
+
 // ------
 
 typedef struct ModelInfo {
@@ -37,11 +49,14 @@ typedef struct PhysicsInfo {
     vec3 size;
     vec3 pos;
     f32 mass;
+    u32 category;   // PhysicsCategory bits or PHCAT_DEFAULT, 0 is valid (no bits)
+    u32 collide;
 } PhysicsInfo;
 
 
 typedef struct ObjectInfo {
     char id[MAX_ID_LENGTH];
+    Atom atom;  // interned `id`
     ObjectType type;
 
     ModelInfo* model;
@@ -51,6 +66,7 @@ typedef struct ObjectInfo {
 
 typedef struct ObjectRefInfo {
     char id[MAX_ID_LENGTH];
+    Atom atom;  // interned `id` of referenced object
     vec3 pos;
     vec3 rot;
 } ObjectRefInfo;
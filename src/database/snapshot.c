@@ -0,0 +1,337 @@
+/*
+    snapshot.c -- Binary Database Snapshot
+
+    * Writer lays out database structures into single image, recording
+      offset of every pointer field
+    * Reader maps the image and fixes up recorded pointers, so database is
+      ready without parsing and with no per-record allocations
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cvector.h>
+
+#include "snapshot.h"
+
+#include "core/containers/map.h"
+#include "core/containers/tuple.h"
+#include "core/log.h"
+
+
+#define IMAGE_ALIGN  16
+
+
+static struct DbSnapshot {
+    bool is_loaded;
+
+    u8* mapping;
+    u64 size;
+    DbSnapshotHeader* header;
+} self = {};
+
+
+/* ------ Writer ------ */
+/* ------------------------------------------------------------------------- */
+
+typedef struct SnapshotBuilder {
+    cvector(u8) image;
+    cvector(u64) relocs;
+
+    cvector(u64) atoms;        // offset of string for each local atom index
+    cvector(u64) atom_relocs;
+    map(void) atoms_index;     // atom -> local atom
+} SnapshotBuilder;
+
+
+static inline
+u64 _align(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/* Reserve zeroed block in image and return its offset */
+static
+u64 _alloc(SnapshotBuilder* b, u64 size) {
+    u64 offset = _align(cvector_size(b->image), IMAGE_ALIGN);
+    u64 new_size = offset + size;
+
+    if (cvector_capacity(b->image) < new_size) {
+        u64 capacity = cvector_capacity(b->image) * 2;
+        cvector_reserve(b->image, capacity > new_size ? capacity : new_size);
+    }
+    memset(b->image + cvector_size(b->image), 0, new_size - cvector_size(b->image));
+    cvector_set_size(b->image, new_size);
+    return offset;
+}
+
+static inline
+u64 _push(SnapshotBuilder* b, const void* data, u64 size) {
+    u64 offset = _alloc(b, size);
+    memcpy(b->image + offset, data, size);
+    return offset;
+}
+
+/* Store `target` offset into pointer field at `field` and register it for fix-up */
+static inline
+void _set_ptr(SnapshotBuilder* b, u64 field, u64 target) {
+    memcpy(b->image + field, &target, sizeof(u64));
+    cvector_push_back(b->relocs, field);
+}
+
+/*
+    Store local atom (1-based index into atoms table) into field at `field`,
+    `str` is offset of its string in image. Atoms are numbered the same way
+    as atom table does, so in fresh process remap on load is identity.
+*/
+static inline
+void _set_atom(SnapshotBuilder* b, u64 field, Atom atom, u64 str) {
+    Atom local = (u64)map_get(b->atoms_index, (void*)(u64)atom);
+    if (local == ATOM_NONE) {
+        cvector_push_back(b->atoms, str);
+        local = cvector_size(b->atoms);
+        map_set(b->atoms_index, (void*)(u64)local, (void*)(u64)atom);
+    }
+    memcpy(b->image + field, &local, sizeof(Atom));
+    cvector_push_back(b->atom_relocs, field);
+}
+
+/* NULL-terminated tuple of pointers, returns offset of pointers array */
+static inline
+u64 _alloc_tuple(SnapshotBuilder* b, u64 count) {
+    return _alloc(b, sizeof(void*) * (count + 1));
+}
+
+static
+u64 _write_object(SnapshotBuilder* b, ObjectInfo* obj) {
+    u64 obj_off = _push(b, obj, sizeof(ObjectInfo));
+    _set_atom(b, obj_off + offsetof(ObjectInfo, atom), obj->atom, obj_off + offsetof(ObjectInfo, id));
+
+    if (obj->model) {
+        u64 model_off = _push(b, obj->model, sizeof(ModelInfo));
+        _set_ptr(b, obj_off + offsetof(ObjectInfo, model), model_off);
+
+        if (obj->model->textures) {
+            u64 size = sizeof(char[MAX_TEXTURE_PATH_LENGTH]) * obj->model->texture_count;
+            u64 textures_off = _push(b, obj->model->textures, size);
+            _set_ptr(b, model_off + offsetof(ModelInfo, textures), textures_off);
+        }
+    }
+
+    if (obj->physics) {
+        u64 count = tuple_size(obj->physics);
+        u64 tuple_off = _alloc_tuple(b, count);
+        _set_ptr(b, obj_off + offsetof(ObjectInfo, physics), tuple_off);
+
+        for (u64 i = 0; i < count; i++) {
+            u64 info_off = _push(b, obj->physics[i], sizeof(PhysicsInfo));
+            _set_ptr(b, tuple_off + i * sizeof(void*), info_off);
+        }
+    }
+    return obj_off;
+}
+
+static
+void _write_scene(SnapshotBuilder* b, SceneInfo* scene, u64 scene_off) {
+    memcpy(b->image + scene_off, scene, sizeof(SceneInfo));
+
+    u64 count = tuple_size(scene->object_refs);
+    u64 tuple_off = _alloc_tuple(b, count);
+    _set_ptr(b, scene_off + offsetof(SceneInfo, object_refs), tuple_off);
+
+    // Refs are contiguous, so scene walk is sequential over mapping
+    u64 refs_off = _alloc(b, sizeof(ObjectRefInfo) * count);
+    for (u64 i = 0; i < count; i++) {
+        u64 ref_off = refs_off + i * sizeof(ObjectRefInfo);
+        memcpy(b->image + ref_off, scene->object_refs[i], sizeof(ObjectRefInfo));
+        _set_ptr(b, tuple_off + i * sizeof(void*), ref_off);
+        _set_atom(
+            b, ref_off + offsetof(ObjectRefInfo, atom),
+            scene->object_refs[i]->atom, ref_off + offsetof(ObjectRefInfo, id)
+        );
+    }
+}
+
+bool db_snapshot_write(const char* path, ObjectInfo** objects, SceneInfo** scenes, i64 source_mtime) {
+    SnapshotBuilder b = {};
+    cvector_reserve(b.image, 1024 * 1024);
+    b.atoms_index = map_new(MHASH_INT);
+
+    u64 header_off = _alloc(&b, sizeof(DbSnapshotHeader));
+
+    /* --- Objects --- */
+    u64 objects_count = tuple_size(objects);
+    u64 objects_off = _alloc_tuple(&b, objects_count);
+    _set_ptr(&b, header_off + offsetof(DbSnapshotHeader, objects), objects_off);
+
+    for (u64 i = 0; i < objects_count; i++) {
+        u64 obj_off = _write_object(&b, objects[i]);
+        _set_ptr(&b, objects_off + i * sizeof(void*), obj_off);
+    }
+
+    /* --- Scenes --- */
+    u64 scenes_count = tuple_size(scenes);
+    u64 scenes_off = _alloc(&b, sizeof(SceneInfo) * scenes_count);
+    if (scenes_count > 0)
+        _set_ptr(&b, header_off + offsetof(DbSnapshotHeader, scenes), scenes_off);
+
+    for (u64 i = 0; i < scenes_count; i++)
+        _write_scene(&b, scenes[i], scenes_off + i * sizeof(SceneInfo));
+
+    /* --- Relocations --- */
+    u64 relocs_count = cvector_size(b.relocs);
+    u64 relocs_off = _alloc(&b, sizeof(u64) * relocs_count);
+    if (relocs_count > 0)
+        memcpy(b.image + relocs_off, b.relocs, sizeof(u64) * relocs_count);
+
+    u64 atoms_count = cvector_size(b.atoms);
+    u64 atoms_off = _alloc(&b, sizeof(u64) * atoms_count);
+    if (atoms_count > 0)
+        memcpy(b.image + atoms_off, b.atoms, sizeof(u64) * atoms_count);
+
+    u64 atom_relocs_count = cvector_size(b.atom_relocs);
+    u64 atom_relocs_off = _alloc(&b, sizeof(u64) * atom_relocs_count);
+    if (atom_relocs_count > 0)
+        memcpy(b.image + atom_relocs_off, b.atom_relocs, sizeof(u64) * atom_relocs_count);
+
+    DbSnapshotHeader* header = (DbSnapshotHeader*)(b.image + header_off);
+    memcpy(header->magic, DB_SNAPSHOT_MAGIC, 4);
+    header->version = DB_SNAPSHOT_VERSION;
+    header->file_size = cvector_size(b.image);
+    header->source_mtime = source_mtime;
+    header->scenes_count = scenes_count;
+    header->relocs_offset = relocs_off;
+    header->relocs_count = relocs_count;
+    header->atoms_offset = atoms_off;
+    header->atoms_count = atoms_count;
+    header->atom_relocs_offset = atom_relocs_off;
+    header->atom_relocs_count = atom_relocs_count;
+
+    FILE* f = fopen(path, "wb");
+    bool ok = f && fwrite(b.image, 1, cvector_size(b.image), f) == cvector_size(b.image);
+    if (f)  fclose(f);
+
+    if (!ok)  log_error("[db] Unable to write snapshot: %s", path);
+
+    cvector_free(b.image);
+    cvector_free(b.relocs);
+    cvector_free(b.atoms);
+    cvector_free(b.atom_relocs);
+    map_free(b.atoms_index);
+    return ok;
+}
+
+/* ------ Reader ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+bool _validate_header(const DbSnapshotHeader* header, u64 size, const char* path) {
+    if (size < sizeof(DbSnapshotHeader) || memcmp(header->magic, DB_SNAPSHOT_MAGIC, 4) != 0) {
+        log_error("[db] Invalid snapshot file: %s", path);
+        return false;
+    }
+    if (header->version != DB_SNAPSHOT_VERSION) {
+        log_info("[db] Snapshot version %d is not supported (expected %d), re-cook it", header->version, DB_SNAPSHOT_VERSION);
+        return false;
+    }
+    if (
+        header->file_size != size
+        || header->relocs_offset + header->relocs_count * sizeof(u64) > size
+        || header->atoms_offset + header->atoms_count * sizeof(u64) > size
+        || header->atom_relocs_offset + header->atom_relocs_count * sizeof(u64) > size
+    ) {
+        log_error("[db] Snapshot file is truncated: %s", path);
+        return false;
+    }
+    return true;
+}
+
+bool db_snapshot_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)  return false;  // not cooked, nothing to report
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // Private writable mapping: only pages with fixed-up pointers get copied
+    u8* mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        log_error("[db] Unable to map snapshot file: %s", path);
+        return false;
+    }
+
+    DbSnapshotHeader* header = (DbSnapshotHeader*)mapping;
+    if (!_validate_header(header, st.st_size, path)) {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+
+    const u64* relocs = (const u64*)(mapping + header->relocs_offset);
+    for (u64 i = 0; i < header->relocs_count; i++) {
+        u64* field = (u64*)(mapping + relocs[i]);
+        *field += (u64)mapping;
+    }
+
+    // Local atoms -> atoms of this process
+    const u64* atoms = (const u64*)(mapping + header->atoms_offset);
+    Atom* remap = malloc(sizeof(Atom) * (header->atoms_count + 1));
+    bool is_identity = true;
+
+    remap[ATOM_NONE] = ATOM_NONE;
+    for (u64 i = 0; i < header->atoms_count; i++) {
+        remap[i + 1] = atom_intern((const char*)(mapping + atoms[i]));
+        is_identity &= remap[i + 1] == i + 1;
+    }
+
+    // Skipped when possible: writes would copy every page holding refs
+    if (!is_identity) {
+        const u64* atom_relocs = (const u64*)(mapping + header->atom_relocs_offset);
+        for (u64 i = 0; i < header->atom_relocs_count; i++) {
+            Atom* field = (Atom*)(mapping + atom_relocs[i]);
+            *field = remap[*field];
+        }
+    }
+    free(remap);
+
+    self.mapping = mapping;
+    self.size = st.st_size;
+    self.header = header;
+    self.is_loaded = true;
+    return true;
+}
+
+void db_snapshot_close() {
+    if (!self.is_loaded)  return;
+
+    munmap(self.mapping, self.size);
+    self.mapping = NULL;
+    self.header = NULL;
+    self.is_loaded = false;
+}
+
+bool db_snapshot_is_loaded() {
+    return self.is_loaded;
+}
+
+i64 db_snapshot_source_mtime() {
+    return self.header->source_mtime;
+}
+
+ObjectInfo** db_snapshot_objects() {
+    return self.header->objects;
+}
+
+SceneInfo* db_snapshot_find_scene(const char* scene_id) {
+    for (u64 i = 0; i < self.header->scenes_count; i++) {
+        if (strcmp(self.header->scenes[i].id, scene_id) == 0)
+            return &self.header->scenes[i];
+    }
+    return NULL;
+}
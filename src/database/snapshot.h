@@ -0,0 +1,56 @@
+#pragma once
+#include <stdbool.h>
+
+#include "database/schemas.h"
+
+#include "core/types.h"
+
+/*
+    Database snapshot (produced by `make cook`):
+
+        DbSnapshotHeader
+        image ........ ObjectInfo, ModelInfo, PhysicsInfo, SceneInfo, ObjectRefInfo
+                       and their tuples, in the same layout as in memory
+        relocs ....... u64 offsets of every non-NULL pointer in header and image
+        atoms ........ u64 offsets of id strings (in image), one per distinct id
+        atom relocs .. u64 offsets of every `Atom` field in image
+
+    Pointers are stored as offsets from file start. After mapping, each
+    relocated pointer gets mapping address added, and structures are used
+    in place (copy-on-write private mapping, nothing to parse or free).
+    Atom fields are stored as 1-based index into atoms table and are
+    re-interned on load, since atom values are local to process.
+*/
+
+#define DB_SNAPSHOT_MAGIC    "ILDB"
+#define DB_SNAPSHOT_VERSION  4
+
+
+typedef struct DbSnapshotHeader {
+    char magic[4];
+    u32 version;
+    u64 file_size;
+    i64 source_mtime;  // newest mtime of objects/scenes .json
+
+    ObjectInfo** objects;
+    SceneInfo* scenes;
+    u64 scenes_count;
+
+    u64 relocs_offset;
+    u64 relocs_count;
+    u64 atoms_offset;
+    u64 atoms_count;
+    u64 atom_relocs_offset;
+    u64 atom_relocs_count;
+} DbSnapshotHeader;
+
+
+bool db_snapshot_write(const char* path, ObjectInfo** objects, SceneInfo** scenes, i64 source_mtime);
+
+bool db_snapshot_open(const char* path);
+void db_snapshot_close();
+
+bool db_snapshot_is_loaded();
+i64 db_snapshot_source_mtime();
+ObjectInfo** db_snapshot_objects();
+SceneInfo* db_snapshot_find_scene(const char* scene_id);
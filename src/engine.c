@@ -1,5 +1,12 @@
+#include <GLFW/glfw3.h>
+
 #include "engine.h"
 
+#include "assets/asset_cache.h"
+#include "assets/asset_loader.h"
+#include "assets/pack.h"
+#include "assets/texture_stream.h"
+#include "core/atom.h"
 #include "core/config.h"
 #include "core/log.h"
 #include "database/db.h"
@@ -40,14 +47,22 @@ void _validate_engine_callbacks() {
 void engine_run() {
     _validate_engine_callbacks();
     config_load("econfig.toml");
+    atom_init();
 
     window_init();
     input_init();
     gfx_init();
+    texture_stream_init();
+    asset_cache_init();
+    asset_loader_init();
     px_init();
     ui_init();
 
+    f64 load_start = glfwGetTime();
+    pack_open(Config.PATH_PACK);
     db_init();
+    pack_log_startup(glfwGetTime() - load_start);
+
     world_init();
     __on_init__();
 
@@ -57,11 +72,14 @@ void engine_run() {
         /* --- Engine Update --- */
         time_update();
         input_update();
-        px_update();
+        px_update(time_get_dt());
+        asset_loader_update();
         world_update();
+        texture_stream_update();
         __on_update__();
+        px_dispatch();
         
-        /* --- Engine Draw --- */
+        /* --- Engine Draw (physics steps meanwhile) --- */
         world_draw();
         ui_draw();
         __on_draw__();
@@ -72,14 +90,19 @@ void engine_run() {
     }
     __on_destroy__();
 
+    asset_loader_destroy();
     world_destroy();
+    asset_cache_destroy();
     db_destroy();
+    pack_close();
 
     ui_destroy();
     px_destroy();
+    texture_stream_destroy();
     gfx_destroy();
     input_destroy();
     window_destroy();
+    atom_destroy();
 }
 
 
@@ -1,5 +1,6 @@
 #include "player.h"
 
+#include "core/atom.h"
 #include "core/cgm.h"
 #include "core/log.h"
 #include "core/config.h"
@@ -24,6 +25,12 @@
 
 Player self = {};
 
+/* ------------------------------------------------------------------------- */
+
+static void _late_latch_camera();
+
+/* ------------------------------------------------------------------------- */
+
 void player_init(vec3 position, vec2 direction) {
     glm_vec3_copy(position, self.position);
     glm_vec2_copy(direction, self.direction);
@@ -39,12 +46,14 @@ void player_init(vec3 position, vec2 direction) {
         self.direction
     );
     gfx_set_camera(self.camera);
+    gfx_set_late_latch(_late_latch_camera);
 
     px_player_init(position, (vec3){0.0, 0.0, 0.0}, PLAYER_WIDTH, PLAYER_HEIGHT);
     px_player_set_interact_ray(self.camera->position, self.camera->v_front);
 }
 
 void player_destroy() {
+    gfx_set_late_latch(NULL);
     camera_free(self.camera);
     px_player_destroy();
 }
@@ -61,10 +70,7 @@ void player_set_colliding(bool value) { self.is_colliding = value; }
 
 
 static inline
-void _update_camera_rotation() {
-    vec2 mouse_delta;
-    input_get_mouse_delta(mouse_delta);
-
+void _rotate_camera(vec2 mouse_delta) {
     self.direction[0] += mouse_delta[0] * PLAYER_CAM_SENSIVITY;
     self.direction[1] += -mouse_delta[1] * PLAYER_CAM_SENSIVITY;
 
@@ -78,6 +84,23 @@ void _update_camera_rotation() {
     camera_set_rotation(self.camera, self.direction);
 }
 
+static inline
+void _update_camera_rotation() {
+    vec2 mouse_delta;
+    input_get_mouse_delta(mouse_delta);
+    _rotate_camera(mouse_delta);
+}
+
+/* Called by gfx right before the view matrix upload (latency mode) */
+static
+void _late_latch_camera() {
+    if (!self.is_active)  return;
+
+    vec2 mouse_delta;
+    input_resample_mouse(mouse_delta);
+    _rotate_camera(mouse_delta);
+}
+
 static inline
 void _calc_movement_vec() {
     glm_vec2_zero(self.v_input);
@@ -177,12 +200,13 @@ void player_update_physics() {
 
 void player_interact() {
     ui_enable_interaction(true);
-    ui_set_interaction_text(self.interactor_oref->obj->base_id);
+    ui_set_interaction_text((char*)atom_str(self.interactor_oref->obj->base_id));
 
     bool activate = input_is_keyp(IN_KEY_E);
     if (activate) {
+        // Frees ref together with its physics
         world_remove_oref(self.interactor_oref);
-        px_delete_object(self.interactor_oref->physics[0]);
+        self.interactor_oref = NULL;
     }
 }
 
@@ -202,6 +226,7 @@ void player_update_interaction() {
 
     cvector_for_each_in(target, px_targets) {
         ObjectRef* oref = world_get_oref_by_physics(target->obj);
+        if (!oref)  continue;
 
         if (oref->obj->type == OBJECT_ITEM && target->dist < min_dist) {
             self.interactor_oref = oref;
@@ -214,11 +239,28 @@ void player_update_interaction() {
 }
 
 
+void player_update_triggers() {
+    ObjectRef* entered = NULL;
+    cvector(PxObject*) px_triggers = px_player_get_triggers();
+
+    PxObject** px_trigger;
+    cvector_for_each_in(px_trigger, px_triggers) {
+        entered = world_get_oref_by_physics(*px_trigger);
+        if (entered)  break;
+    }
+
+    if (entered && entered != self.trigger_oref)
+        log_debug("[player] Entered trigger: %s", atom_str(entered->obj->base_id));
+    self.trigger_oref = entered;
+}
+
+
 void player_update() {
     if (!self.is_active)  return;
 
     player_update_physics();
     player_update_interaction();
+    player_update_triggers();
 }
 
 Player* player_get() {
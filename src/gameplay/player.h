@@ -23,6 +23,7 @@ typedef struct Player {
     bool is_ceiled;
 
     ObjectRef* interactor_oref;
+    ObjectRef* trigger_oref;    // trigger volume player stands in, if any
 } Player;
 
 
@@ -35,3 +36,5 @@ void player_set_colliding(bool);
 
 void player_update_physics();
 void player_update();
+
+Player* player_get();
@@ -53,3 +53,13 @@ void camera_set_rotation(Camera* cam, vec2 direction) {
     cgm_front_vec(cam->direction[0], cam->direction[1], cam->v_front);
     _update_view_mat(cam);
 }
+
+
+/* Approximate on-screen height (px) of a bounding sphere */
+f32 camera_get_projected_size(Camera* cam, vec3 center, f32 radius) {
+    f32 dist = glm_vec3_distance(cam->position, center);
+    if (dist <= radius)  return Config.WINDOW_HEIGHT;
+
+    f32 half_fov = radian(CAMERA_DEFAULT_FOV) / 2.0;
+    return radius / (dist * tan(half_fov)) * Config.WINDOW_HEIGHT;
+}
@@ -19,3 +19,5 @@ void camera_free(Camera*);
 
 void camera_set_position(Camera*, vec3 pos);
 void camera_set_rotation(Camera*, vec2 direction);
+
+f32 camera_get_projected_size(Camera*, vec3 center, f32 radius);
@@ -18,9 +18,14 @@
 #include "core/config.h"
 #include "core/log.h"
 #include "core/types.h"
+#include "platform/input.h"
 #include "platform/window.h"
 
 
+#define MAX_FRAMES_IN_FLIGHT  8
+#define UI_TEXT_SIZE          24.0f  // px, drawn from SDF atlas of `FONT_SDF_SIZE`
+
+
 typedef struct DrawObjectCommand {
     GfxMesh* mesh;
     GfxTexture* texture;
@@ -46,6 +51,14 @@ static struct _Gfx {
     bool _stop;
     GfxSkybox* skybox;
 
+    struct LatencyState {
+        GfxCallback late_latch;
+        GLsync fences[MAX_FRAMES_IN_FLIGHT];
+        u32 frames_in_flight;
+        u32 frame_idx;
+        f64 input_to_submit;
+    } latency;
+
     struct ShaderStorage {
         Shader* sky;
         Shader* object;
@@ -112,6 +125,70 @@ void _clear_command_storage() {
     cvector_clear(self.commands.geometry);
 }
 
+/* ------ Latency Mode ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+void _init_latency_state() {
+    memset(&self.latency, 0, sizeof(self.latency));
+    if (!Config.GRAPHICS_LATENCY_MODE)  return;
+
+    i32 depth = Config.GRAPHICS_FRAMES_IN_FLIGHT;
+    if (depth < 1)                     depth = 1;
+    if (depth > MAX_FRAMES_IN_FLIGHT)  depth = MAX_FRAMES_IN_FLIGHT;
+    self.latency.frames_in_flight = depth;
+
+    log_info("LATENCY MODE: %i frame(s) in flight", depth);
+}
+
+static inline
+void _destroy_latency_state() {
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        if (self.latency.fences[i])  glDeleteSync(self.latency.fences[i]);
+    }
+    memset(&self.latency, 0, sizeof(self.latency));
+}
+
+/* Block until GPU has finished the frame which used the current fence slot,
+   so there are never more than `frames_in_flight` frames queued in driver
+*/
+static inline
+void _wait_frame_slot() {
+    if (!self.latency.frames_in_flight)  return;
+
+    GLsync* fence = &self.latency.fences[self.latency.frame_idx];
+    if (!*fence)  return;
+
+    GLenum res;
+    do {
+        res = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+    } while (res == GL_TIMEOUT_EXPIRED);
+
+    if (res == GL_WAIT_FAILED)  log_error("glClientWaitSync failed");
+
+    glDeleteSync(*fence);
+    *fence = NULL;
+}
+
+static inline
+void _signal_frame_slot() {
+    if (!self.latency.frames_in_flight)  return;
+
+    self.latency.fences[self.latency.frame_idx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    self.latency.frame_idx = (self.latency.frame_idx + 1) % self.latency.frames_in_flight;
+}
+
+static inline
+void _measure_input_latency() {
+    self.latency.input_to_submit = glfwGetTime() - input_get_sample_time();
+
+    if (Config.GRAPHICS_LATENCY_LOG)
+        log_debug("input-to-submit: %.3f ms", self.latency.input_to_submit * 1000.0);
+}
+
+void gfx_set_late_latch(GfxCallback func) { self.latency.late_latch = func; }
+f64 gfx_get_input_latency() { return self.latency.input_to_submit; }
+
 /* ------------------------------------------------------------------------- */
 
 static inline
@@ -141,9 +218,12 @@ void gfx_init() {
 
     glPolygonMode(GL_FRONT_AND_BACK, Config.GRAPHICS_WIREFRAME ? GL_LINE : GL_POLYGON);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    _init_latency_state();
 }
 
 void gfx_destroy() {
+    _destroy_latency_state();
     _destroy_shaders();
     _destroy_command_storage();
 
@@ -162,6 +242,7 @@ void gfx_stop() {
 }
 
 void gfx_set_camera(Camera* camera) { self.camera = camera; }
+Camera* gfx_get_camera() { return self.camera; }
 void gfx_set_skybox(GfxSkybox* skybox) { self.skybox = skybox; }
 
 
@@ -239,7 +320,16 @@ void gfx_draw_objects() {
         glBindTexture(GL_TEXTURE_2D, cmd->texture->id);
         
         glFrontFace(cmd->mesh->cw ? GL_CW : GL_CCW);
-        glDrawElements(GL_TRIANGLES, cmd->mesh->ind_count, GL_UNSIGNED_INT, NULL);
+        GfxMesh* mesh = cmd->mesh;
+        GLenum index_type = mesh->index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        for (u32 r = 0; r < mesh->ranges_count; r++) {
+            GfxMeshRange* range = &mesh->ranges[r];
+            glDrawElementsBaseVertex(
+                GL_TRIANGLES, range->ind_count, index_type,
+                (void*)((u64)range->ind_offset * mesh->index_size), range->base_vertex
+            );
+        }
         
         glBindTexture(GL_TEXTURE_2D, 0);
     }
@@ -252,9 +342,13 @@ void gfx_draw_ui_elements() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     Font* font = font_get_default();
-    f32 scale = 0.5;
+    f32 scale = UI_TEXT_SIZE / FONT_SDF_SIZE;
+    font_begin_frame();
+
+    glActiveTexture(GL_TEXTURE0);
 
     DrawUIElementCommand* cmd;
+    f32 vertices[GFX_UI_MAX_GLYPHS][6][4];
 
     cvector_for_each_in(cmd, self.commands.ui_element) {
         f32 screen_x = cmd->pos[0] * Config.WINDOW_WIDTH;
@@ -262,37 +356,44 @@ void gfx_draw_ui_elements() {
     
         shader_set_mat4(self.shaders.ui, "projection", cmd->ui_data->persp_mat);
         shader_set_vec3(self.shaders.ui, "text_color", cmd->color);
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(cmd->ui_data->vao);
 
-        for (int i = 0; i < strlen(cmd->text); i++) {
-            char ch = cmd->text[i];
-            Glyph* glyph = &font->chars[(unsigned char)ch];
+        // Whole text is single draw, glyphs are quads in the same atlas
+        u32 count = 0;
+        const char* text = cmd->text;
+        u32 code;
+
+        while ((code = font_utf8_next(&text)) && count < GFX_UI_MAX_GLYPHS) {
+            Glyph* glyph = font_get_glyph(font, code);
             
             f32 xpos = screen_x + glyph->bearing[0] * scale;
             f32 ypos = screen_y - (glyph->size[1] - glyph->bearing[1]) * scale;
             
             f32 w = glyph->size[0] * scale;
             f32 h = glyph->size[1] * scale;
+            f32 u0 = glyph->uv[0], v0 = glyph->uv[1];
+            f32 u1 = glyph->uv[2], v1 = glyph->uv[3];
             
-            f32 verticles[6][4] = {
-                {xpos,      ypos + h,   0.0, 0.0},
-                {xpos,      ypos,       0.0, 1.0},
-                {xpos + w,  ypos,       1.0, 1.0},
+            f32 quad[6][4] = {
+                {xpos,      ypos + h,   u0, v0},
+                {xpos,      ypos,       u0, v1},
+                {xpos + w,  ypos,       u1, v1},
                 
-                {xpos,      ypos + h,   0.0, 0.0},
-                {xpos + w,  ypos,       1.0, 1.0},
-                {xpos + w,  ypos + h,   1.0, 0.0}
+                {xpos,      ypos + h,   u0, v0},
+                {xpos + w,  ypos,       u1, v1},
+                {xpos + w,  ypos + h,   u1, v0}
             };
-            glBindTexture(GL_TEXTURE_2D, glyph->texture->id);
-            glBindBuffer(GL_ARRAY_BUFFER, cmd->ui_data->vbo);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verticles), verticles);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            screen_x += (glyph->advance >> 6) * scale;
+            memcpy(vertices[count++], quad, sizeof(quad));
+            screen_x += glyph->advance * scale;
         }
+        if (count == 0)  continue;
+
+        glBindVertexArray(cmd->ui_data->vao);
+        glBindTexture(GL_TEXTURE_2D, font->atlas->id);
+        glBindBuffer(GL_ARRAY_BUFFER, cmd->ui_data->vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices[0]) * count, vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        
+        glDrawArrays(GL_TRIANGLES, 0, 6 * count);
     }
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -338,10 +439,18 @@ void gfx_draw() {
     glEnable(GL_CULL_FACE);
     glEnable(GL_DEPTH_TEST);
 
+    _wait_frame_slot();
+
+    // Late latch: refresh camera right before view matrix is uploaded
+    if (self.latency.frames_in_flight && self.latency.late_latch)
+        self.latency.late_latch();
+
     gfx_draw_sky();
     gfx_draw_objects();
     gfx_draw_geometry();
     gfx_draw_ui_elements();
 
+    _signal_frame_slot();
+    _measure_input_latency();
     _clear_command_storage();
 }
@@ -9,13 +9,18 @@
 #include "core/types.h"
 
 
+typedef void (*GfxCallback)(void);
+
 void gfx_init();
 void gfx_destroy();
 bool gfx_need_stop();
 void gfx_stop();
 
 void gfx_set_camera(Camera* camera);
+Camera* gfx_get_camera();
 void gfx_set_skybox(GfxSkybox* skybox);
+void gfx_set_late_latch(GfxCallback func);
+f64 gfx_get_input_latency();
 
 void gfx_enqueue_object(GfxMesh* mesh, GfxTexture* texture, mat4 m_model);
 void gfx_enqueue_ui_element(char* text, GfxMesh2D* ui_data, vec2 pos, vec3 color);
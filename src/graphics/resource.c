@@ -7,6 +7,7 @@
 #include "resource.h"
 #include "graphics/meshes.h"
 
+#include "core/cgm.h"
 #include "core/config.h"
 #include "core/log.h"
 
@@ -18,8 +19,10 @@
 /* ------ GfxMesh ------ */
 /* ------------------------------------------------------------------------- */
 
+/* `ranges` are copied, NULL means whole index buffer is drawn at once */
 GfxMesh* gfx_load_mesh(
-    const char* name, f32* vtx_buf, u32* ind_buf, u64 vtx_count, u64 ind_count, bool cw
+    const char* name, f32* vtx_buf, void* ind_buf, u64 vtx_count, u64 ind_count, u32 index_size,
+    GfxMeshRange* ranges, u32 ranges_count, bool cw
 ) {
     GfxMesh* mesh = malloc(sizeof(GfxMesh));
     if (!mesh) {
@@ -30,8 +33,18 @@ GfxMesh* gfx_load_mesh(
 
     mesh->vtx_count = vtx_count;
     mesh->ind_count = ind_count;
+    mesh->index_size = index_size;
     mesh->cw = cw;
 
+    GfxMeshRange whole = {.ind_offset = 0, .ind_count = ind_count, .base_vertex = 0};
+    if (!ranges) {
+        ranges = &whole;
+        ranges_count = 1;
+    }
+    mesh->ranges_count = ranges_count;
+    mesh->ranges = malloc(sizeof(GfxMeshRange) * ranges_count);
+    memcpy(mesh->ranges, ranges, sizeof(GfxMeshRange) * ranges_count);
+
     /* ------ VAO ------ */
     glGenVertexArrays(1, &(mesh->vao));
     glBindVertexArray(mesh->vao);
@@ -48,7 +61,7 @@ GfxMesh* gfx_load_mesh(
     /* ------ IBO ------ */
     glGenBuffers(1, &(mesh->ibo));
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * ind_count, ind_buf, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_size * ind_count, ind_buf, GL_STATIC_DRAW);
 
     /* ------ Vertex Attributes ------ */
     // Vertex buffer format is planar: (PPP...NNN...TTT...)
@@ -84,6 +97,7 @@ void gfx_unload_mesh(GfxMesh* mesh){
     glDeleteBuffers(1, &mesh->vbo);
     glDeleteBuffers(1, &mesh->ibo);
 
+    free(mesh->ranges);
     free(mesh);
 }
 
@@ -99,7 +113,7 @@ GfxMesh2D* gfx_load_mesh_2d() {
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4 * GFX_UI_MAX_GLYPHS, NULL, GL_DYNAMIC_DRAW);
 
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
     glEnableVertexAttribArray(0);
@@ -167,6 +181,64 @@ GfxTexture* gfx_load_texture(u8* data, u32 width, u32 height, i32 gl_format, u32
     return texture;
 }
 
+/* Partially resident texture: only levels [base_level, mipmap_cnt) are uploaded,
+   `data` points to the first of them. Sampling is clamped by BASE_LEVEL.
+*/
+GfxTexture* gfx_load_texture_levels(
+    u8* data, u32 width, u32 height, i32 gl_format, u32 block_size, u32 base_level, u32 mipmap_cnt
+) {
+    GfxTexture* texture = malloc(sizeof(GfxTexture));
+    if (!texture) {
+        log_error("Failed to allocate memory for GfxTexture (DDS, streamed)");
+        return NULL;
+    }
+
+    glGenTextures(1, &(texture->id));
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base_level);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmap_cnt-1);
+
+    u32 offset = 0;
+    for (u32 i = base_level; i < mipmap_cnt; i++) {
+        u32 w = max(1, width >> i);
+        u32 h = max(1, height >> i);
+        u32 size = ((w+3)/4) * ((h+3)/4) * block_size;
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, gl_format, w, h, 0, size, data + offset);
+        offset += size;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+void gfx_texture_upload_level(
+    GfxTexture* texture, u32 level, u32 width, u32 height, i32 gl_format, u32 size, u8* data
+) {
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, gl_format, width, height, 0, size, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* Respecify level with empty image, so driver could release its storage */
+void gfx_texture_drop_level(GfxTexture* texture, u32 level, i32 gl_format) {
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, gl_format, 0, 0, 0, 0, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void gfx_texture_set_base_level(GfxTexture* texture, u32 level) {
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 static inline
 GfxTexture* _load_cubemap_texture(
     u8* tex_x, u8* tex_nx, u8* tex_y, u8* tex_ny, u8* tex_z, u8* tex_nz,
@@ -235,6 +307,12 @@ GfxTexture* gfx_load_font_texture(u32 width, u32 height, void* data) {
     return texture;
 }
 
+void gfx_font_texture_update(GfxTexture* texture, u32 x, u32 y, u32 width, u32 height, void* data) {
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RED, GL_UNSIGNED_BYTE, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void gfx_unload_texture(GfxTexture* texture) {
     if (!texture)  return;
 
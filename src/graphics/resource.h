@@ -4,6 +4,13 @@
 #include "core/types.h"
 
 
+/* Sub-range of mesh buffers drawn by single call (one per glTF primitive) */
+typedef struct {
+    u32 ind_offset;
+    u32 ind_count;
+    u32 base_vertex;
+} GfxMeshRange;
+
 typedef struct {
     // const char* name;
     u32 vao;
@@ -12,6 +19,10 @@ typedef struct {
 
     u64 vtx_count;
     u64 ind_count;
+    u32 index_size;  // 2 (u16) or 4 (u32)
+
+    GfxMeshRange* ranges;
+    u32 ranges_count;
     
     bool cw;  // vertex ordering (1 = clockwise ; 0 = counterwise)
 } GfxMesh;
@@ -27,6 +38,8 @@ typedef struct {
     vec3 color;
 } GfxGeometry;
 
+#define GFX_UI_MAX_GLYPHS  128  // per single text element
+
 typedef struct {
     u32 vao;
     u32 vbo;
@@ -40,11 +53,23 @@ typedef struct {
 } GfxSkybox;
 
 
-GfxMesh* gfx_load_mesh(const char* id, f32* vtx_buf, u32* ind_buf, u64 vtx_count, u64 ind_count, bool cw);
+GfxMesh* gfx_load_mesh(
+    const char* id, f32* vtx_buf, void* ind_buf, u64 vtx_count, u64 ind_count, u32 index_size,
+    GfxMeshRange* ranges, u32 ranges_count, bool cw
+);
 void gfx_unload_mesh(GfxMesh*);
 
 GfxTexture* gfx_load_texture(u8* data, u32 width, u32 height, i32 gl_format, u32 mipmap_cnt, u32 block_size);
+GfxTexture* gfx_load_texture_levels(
+    u8* data, u32 width, u32 height, i32 gl_format, u32 block_size, u32 base_level, u32 mipmap_cnt
+);
+void gfx_texture_upload_level(
+    GfxTexture* texture, u32 level, u32 width, u32 height, i32 gl_format, u32 size, u8* data
+);
+void gfx_texture_drop_level(GfxTexture* texture, u32 level, i32 gl_format);
+void gfx_texture_set_base_level(GfxTexture* texture, u32 level);
 GfxTexture* gfx_load_font_texture(u32 width, u32 height, void* data);
+void gfx_font_texture_update(GfxTexture* texture, u32 x, u32 y, u32 width, u32 height, void* data);
 void gfx_unload_texture(GfxTexture*);
 
 GfxGeometry* gfx_load_geometry(f32* lines_buf, u64 vtx_count, vec3 color);
@@ -1,10 +1,20 @@
+#define _POSIX_C_SOURCE 200809L
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <string.h>
 #include <ode/ode.h>
+#include <cvector.h>
+#include <cvector_utils.h>
 
 #include "px.h"
 #include "physics/px_object.h"
+#include "physics/px_query.h"
 
+#include "core/config.h"
 #include "core/containers/map.h"
 #include "core/types.h"
 #include "core/log.h"
@@ -12,18 +22,85 @@
 
 // Documentation: https://ode.org/wiki/index.php/Manual
 
+#define PX_STATIC_EXTENT     512.0   // half size of static space until scene is loaded
+#define PX_STATIC_LEAF       16.0    // smallest quadtree block side, meters
+#define PX_STATIC_MAX_DEPTH  8       // quadtree preallocates 4^depth blocks
 
-const i32 MAX_RATE = 120;
-static dReal TIMESTEP = 1.0 / MAX_RATE;
+
+typedef enum {
+    PXCMD_SPAWN,
+    PXCMD_DELETE,
+    PXCMD_SET_POSITION,
+} PxCommandType;
+
+typedef struct PxCommand {
+    PxCommandType type;
+    PxObject* obj;
+    vec3 pos;
+
+    struct PxCommand* next;  // command stack link
+} PxCommand;
+
+/* Active body held still (kinematic, no velocity) while ring is stepped */
+typedef struct PxPinned {
+    PxObject* obj;
+    dVector3 lvel;
+    dVector3 avel;
+} PxPinned;
 
 
 static struct PxStorage {
     dWorldID world;
-    dSpaceID space;
+    dSpaceID static_space;      // quadtree, never collided with itself
+    dSpaceID dynamic_space;
     dJointGroupID contact_group;
 
     map(PxObject) objects;
-    u32 next_id;
+    PxObject** bodies;      // cvector, simulated (rigid) bodies
+    _Atomic u32 next_id;
+
+    f64 step;               // fixed step, sec
+    f64 accumulator;        // real time not simulated yet
+    u32 frame_steps;        // steps in last published batch
+    f64 alpha;              // of last published batch
+    PxStats stats;          // of last published batch
+    PxStats batch_stats;    // counted by batch in flight
+
+    /* --- Regions around focus (player), ODE XY plane --- */
+    bool regions;           // `active_radius` set
+    bool has_focus;
+    dReal focus[2];
+    f64 active_radius2;
+    f64 ring_radius2;       // 0 without ring
+    u32 ring_interval;
+    u32 step_count;
+    bool ring_pass;         // stepping ring, active bodies are pinned
+    PxPinned* pinned;       // cvector, reused by ring passes
+
+    /* --- Step batch, scheduled by `px_update` --- */
+    bool scheduled;         // not published yet
+    u32 batch_steps;
+    f64 batch_alpha;
+
+    /* --- Snapshot, by body index: physics writes back, main reads front --- */
+    PxBodyState* states[2]; // cvectors
+    u32 front;
+
+    /* --- Physics thread --- */
+    bool threaded;
+    pthread_t thread;
+    pthread_t main_thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool run;               // batch handed to thread, guarded by `lock`
+    bool stop;
+    bool busy;              // main thread only, batch dispatched & not joined yet
+
+    /* --- Step threads (ODE pool), NULL when stepping single threaded --- */
+    dThreadingImplementationID threading;
+    dThreadingThreadPoolID pool;
+
+    _Atomic(PxCommand*) commands;
 } self;
 
 
@@ -38,131 +115,727 @@ void custom_message_handler(int num, const char *msg, va_list args) {
 }
 
 
+/* ------------------------------------------------------------------------- */
+
+// For kinematic bodies, create contact only for the kinematic body
+// (player gets blocked, cube doesn't move)
+static inline
+void _kinematic_contact_surface_params(dContact* contact) {
+    contact->surface.mode = dContactBounce | dContactSoftERP | dContactSoftCFM;
+    contact->surface.mu = 0.0;  // No friction
+    contact->surface.mu2 = 0;
+    contact->surface.bounce = 0.001;  // Almost no bounce
+    contact->surface.bounce_vel = 0.001;
+    contact->surface.soft_erp = 0.15;  // Strong enough to block player
+    contact->surface.soft_cfm = 0.02;
+}
+
+// Normal contact for rigid-rigid collisions
+static inline
+void _rigid_contact_surface_params(dContact* contact) {
+    contact->surface.mode = dContactBounce | dContactSoftERP | dContactSoftCFM;
+    contact->surface.mu = dInfinity;
+    contact->surface.mu2 = 0;
+    contact->surface.bounce = 0.1;
+    contact->surface.bounce_vel = 0.1;
+    contact->surface.soft_erp = 0.2;
+    contact->surface.soft_cfm = 0.001;
+}
+
+static const int MAX_CONTACTS = 8;
+
+/* Body if current pass steps it, 0 if it stands still (held by region, or
+   active body pinned while ring is stepped) */
+static inline
+dBodyID _stepped_body(dBodyID body) {
+    if (!body || !self.regions)  return body;
+
+    PxObject* obj = dBodyGetData(body);
+    if (self.ring_pass)  return obj->region == PXREGION_RING ? body : 0;
+    return obj->held ? 0 : body;
+}
+
+static
+void collision_callback(void* data, dGeomID geom1, dGeomID geom2) {
+    dBodyID body1 = dGeomGetBody(geom1);
+    dBodyID body2 = dGeomGetBody(geom2);
+    
+    /* --- Collision Validation --- */
+    // Skip self-collisions for the same body
+    if (body1 && body2 && body1 == body2) return;
+
+    // Skip collisions between two static objects (both without bodies)
+    if (!body1 && !body2) {
+        self.batch_stats.dropped_pairs++;
+        return;
+    }
+
+    if (body1 && body2)  self.batch_stats.dynamic_pairs++;
+    else                 self.batch_stats.static_pairs++;
+
+    // Sensors only overlap, player collects them (`px_player_get_triggers`)
+    if ((dGeomGetCategoryBits(geom1) | dGeomGetCategoryBits(geom2)) & PXCAT_TRIGGER)  return;
+
+    // Bodies not stepped by this pass stand still like statics, pairs
+    // without awake body (e.g. sleeping on ground) need no contacts
+    dBodyID step_body1 = _stepped_body(body1);
+    dBodyID step_body2 = _stepped_body(body2);
+    bool awake1 = step_body1 && dBodyIsEnabled(step_body1);
+    bool awake2 = step_body2 && dBodyIsEnabled(step_body2);
+    if (!awake1 && !awake2)  return;
+
+    bool is_kinematic = false;
+    if (step_body1 && dBodyIsKinematic(step_body1))  is_kinematic = true;
+    if (step_body2 && dBodyIsKinematic(step_body2))  is_kinematic = true;
+
+    /* --- Collision Handling --- */
+    dContact contact[MAX_CONTACTS];
+    i32 n = dCollide(geom1, geom2, MAX_CONTACTS, &contact[0].geom, sizeof(dContact));
+    self.batch_stats.contacts += n;
+
+    for (int i = 0; i < n; i++) {        
+        if (is_kinematic) {
+            _kinematic_contact_surface_params(&contact[i]);
+        }
+        else {
+            _rigid_contact_surface_params(&contact[i]);
+            dJointID c = dJointCreateContact(self.world, self.contact_group, &contact[i]);
+            dJointAttach(c, step_body1, step_body2);
+        }
+    }
+}
+
+/* ------ Step ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+bool _is_simulated(PxObject* obj) {
+    return obj->body && !dBodyIsKinematic(obj->body);
+}
+
+static inline
+void _copy_state(PxObject* obj, dReal* pos, dReal* rot) {
+    memcpy(pos, dBodyGetPosition(obj->body), sizeof(dReal) * 3);
+    memcpy(rot, dBodyGetQuaternion(obj->body), sizeof(dQuaternion));
+}
+
+/* ------ Regions ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void _init_regions() {
+    // ODE puts bodies to sleep by itself, contact with awake body wakes them
+    if (Config.PHYSICS_SLEEP_STEPS > 0) {
+        dWorldSetAutoDisableFlag(self.world, 1);
+        dWorldSetAutoDisableLinearThreshold(self.world, Config.PHYSICS_SLEEP_LINEAR);
+        dWorldSetAutoDisableAngularThreshold(self.world, Config.PHYSICS_SLEEP_ANGULAR);
+        dWorldSetAutoDisableSteps(self.world, Config.PHYSICS_SLEEP_STEPS);
+        dWorldSetAutoDisableTime(self.world, 0.0);
+    }
+
+    f64 active = Config.PHYSICS_ACTIVE_RADIUS;
+    f64 ring = Config.PHYSICS_RING_RADIUS;
+
+    self.regions = active > 0.0;
+    self.has_focus = false;
+    self.active_radius2 = active * active;
+    self.ring_radius2 = (self.regions && ring > active && Config.PHYSICS_RING_INTERVAL > 1) ? ring * ring : 0.0;
+    self.ring_interval = Config.PHYSICS_RING_INTERVAL;
+    self.step_count = 0;
+    self.ring_pass = false;
+    self.pinned = NULL;
+}
+
+/* Hold bodies away from focus (disabled, not asleep), release ones back in range */
+static
+void _assign_regions() {
+    if (!self.regions || !self.has_focus)  return;
+
+    u32 count = cvector_size(self.bodies);
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.bodies[i];
+        const dReal* pos = dBodyGetPosition(obj->body);
+        f64 dx = pos[0] - self.focus[0];
+        f64 dy = pos[1] - self.focus[1];
+        f64 dist2 = dx * dx + dy * dy;
+
+        if (dist2 <= self.active_radius2)     obj->region = PXREGION_ACTIVE;
+        else if (dist2 <= self.ring_radius2)  obj->region = PXREGION_RING;
+        else                                  obj->region = PXREGION_FAR;
+
+        if (obj->region == PXREGION_ACTIVE) {
+            if (obj->held) {
+                dBodyEnable(obj->body);
+                obj->held = false;
+            }
+        }
+        else if (dBodyIsEnabled(obj->body)) {
+            dBodyDisable(obj->body);
+            obj->held = true;
+        }
+    }
+}
+
+static inline
+bool _is_idle(dBodyID body) {
+    if (Config.PHYSICS_SLEEP_STEPS <= 0)  return false;
+    if (dBodyGetNumJoints(body) == 0)     return false;  // don't freeze mid-air
+
+    return dCalcVectorLengthSquare3(dBodyGetLinearVel(body)) < Config.PHYSICS_SLEEP_LINEAR * Config.PHYSICS_SLEEP_LINEAR
+        && dCalcVectorLengthSquare3(dBodyGetAngularVel(body)) < Config.PHYSICS_SLEEP_ANGULAR * Config.PHYSICS_SLEEP_ANGULAR;
+}
+
+/*
+    Ring bodies catch up `ring_interval` steps at once. Active bodies are
+    pinned instead of disabled for it: enabling resets ODE idle counters,
+    so they would never fall asleep. Ring bodies are held again afterwards,
+    or left asleep if they came to rest (their counters restart each pass).
+*/
+static
+void _step_ring() {
+    u32 count = cvector_size(self.bodies);
+    u32 ring = 0;
+    cvector_clear(self.pinned);
+
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.bodies[i];
+        dBodyID body = obj->body;
+
+        if (obj->region == PXREGION_RING && obj->held) {
+            dBodyEnable(body);
+            obj->held = false;
+            ring++;
+        }
+        else if (obj->region == PXREGION_ACTIVE && dBodyIsEnabled(body)) {
+            PxPinned pinned = {.obj = obj};
+            memcpy(pinned.lvel, dBodyGetLinearVel(body), sizeof(dReal) * 3);
+            memcpy(pinned.avel, dBodyGetAngularVel(body), sizeof(dReal) * 3);
+            cvector_push_back(self.pinned, pinned);
+
+            dBodySetLinearVel(body, 0.0, 0.0, 0.0);
+            dBodySetAngularVel(body, 0.0, 0.0, 0.0);
+            dBodySetKinematic(body);
+        }
+    }
+    if (!ring)  return;
+
+    self.ring_pass = true;
+    px_collide(NULL, collision_callback);
+    dWorldQuickStep(self.world, self.step * self.ring_interval);
+    self.ring_pass = false;
+
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.bodies[i];
+        if (obj->region != PXREGION_RING || !dBodyIsEnabled(obj->body))  continue;
+
+        obj->held = !_is_idle(obj->body);
+        dBodyDisable(obj->body);
+    }
+    dJointGroupEmpty(self.contact_group);
+
+    PxPinned* pinned;
+    cvector_for_each_in(pinned, self.pinned) {
+        dBodyID body = pinned->obj->body;
+        dBodySetDynamic(body);
+        dBodySetLinearVel(body, pinned->lvel[0], pinned->lvel[1], pinned->lvel[2]);
+        dBodySetAngularVel(body, pinned->avel[0], pinned->avel[1], pinned->avel[2]);
+    }
+}
+
+/* Body counts by state at end of batch */
+static
+void _count_bodies(PxStats* stats) {
+    u32 count = cvector_size(self.bodies);
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.bodies[i];
+
+        if (!obj->held) {
+            if (dBodyIsEnabled(obj->body))  stats->active_bodies++;
+            else                            stats->sleeping_bodies++;
+        }
+        else if (obj->region == PXREGION_RING)  stats->ring_bodies++;
+        else                                    stats->held_bodies++;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Run batch writing back snapshot, on physics thread or inline */
+static
+void _simulate(u32 steps) {
+    if (!steps)  return;
+
+    PxBodyState* back = self.states[self.front ^ 1];
+    u32 count = cvector_size(self.bodies);
+    memset(&self.batch_stats, 0, sizeof(PxStats));
+
+    for (u32 s = 0; s < steps; s++) {
+        // Interpolation blends between last two steps only
+        if (s == steps - 1) {
+            for (u32 i = 0; i < count; i++)
+                _copy_state(self.bodies[i], back[i].prev_pos, back[i].prev_rot);
+        }
+
+        _assign_regions();
+
+        px_collide(NULL, collision_callback);
+        dWorldQuickStep(self.world, self.step);
+        dJointGroupEmpty(self.contact_group);
+
+        self.step_count++;
+        if (self.ring_radius2 > 0.0 && self.has_focus && self.step_count % self.ring_interval == 0)
+            _step_ring();
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        _copy_state(self.bodies[i], back[i].pos, back[i].rot);
+        px_query_move(self.bodies[i]);
+    }
+    _count_bodies(&self.batch_stats);
+}
+
+static inline
+void _publish() {
+    if (self.batch_steps) {
+        self.front ^= 1;
+        self.stats = self.batch_stats;
+    }
+    self.frame_steps = self.batch_steps;
+    self.alpha = self.batch_alpha;
+    self.scheduled = false;
+}
+
+/* ------ Physics thread ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void* _worker(void* _) {
+    dAllocateODEDataForThread(dAllocateMaskAll);
+    pthread_mutex_lock(&self.lock);
+
+    while (true) {
+        while (!self.stop && !self.run)
+            pthread_cond_wait(&self.cond, &self.lock);
+
+        if (self.stop)  break;
+        pthread_mutex_unlock(&self.lock);
+
+        _simulate(self.batch_steps);
+
+        pthread_mutex_lock(&self.lock);
+        self.run = false;
+        pthread_cond_broadcast(&self.cond);
+    }
+
+    pthread_mutex_unlock(&self.lock);
+    return NULL;
+}
+
+static inline
+void _join() {
+    if (!self.busy)  return;
+
+    pthread_mutex_lock(&self.lock);
+    while (self.run)
+        pthread_cond_wait(&self.cond, &self.lock);
+    pthread_mutex_unlock(&self.lock);
+
+    self.busy = false;
+}
+
+/* ODE pool threads serve world step: islands and quick step stages are
+   split among them, thread calling step waits for them */
+static
+void _init_step_threads() {
+    self.threading = NULL;
+    self.pool = NULL;
+    if (Config.PHYSICS_STEP_THREADS <= 1)  return;
+
+    // Pool threads must not take signals meant for engine
+    sigset_t all, prev;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &prev);
+
+    self.threading = dThreadingAllocateMultiThreadedImplementation();
+    self.pool = dThreadingAllocateThreadPool(Config.PHYSICS_STEP_THREADS, 0, dAllocateFlagBasicData, NULL);
+
+    pthread_sigmask(SIG_SETMASK, &prev, NULL);
+
+    if (!self.threading || !self.pool)
+        log_exit("[physics] Unable to start %d step threads", Config.PHYSICS_STEP_THREADS);
+
+    dThreadingThreadPoolServeMultiThreadedImplementation(self.pool, self.threading);
+    dWorldSetStepIslandsProcessingMaxThreadCount(self.world, Config.PHYSICS_STEP_THREADS);
+    dWorldSetStepThreadingImplementation(self.world, dThreadingImplementationGetFunctions(self.threading), self.threading);
+}
+
+static
+void _free_step_threads() {
+    if (!self.threading)  return;
+
+    dThreadingImplementationShutdownProcessing(self.threading);
+    dThreadingFreeThreadPool(self.pool);
+    dWorldSetStepThreadingImplementation(self.world, NULL, NULL);
+    dThreadingFreeImplementation(self.threading);
+}
+
+/* ------ Commands ------ */
+/* ------------------------------------------------------------------------- */
+
+/* ODE may be used directly: main thread, no batch in flight */
+static inline
+bool _in_window() {
+    return pthread_equal(pthread_self(), self.main_thread) && !self.busy;
+}
+
+static inline
+void _push_command(PxCommandType type, PxObject* obj, vec3 pos) {
+    PxCommand* cmd = malloc(sizeof(PxCommand));
+    cmd->type = type;
+    cmd->obj = obj;
+    if (pos)  glm_vec3_copy(pos, cmd->pos);
+
+    PxCommand* head = atomic_load_explicit(&self.commands, memory_order_relaxed);
+    do {
+        cmd->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &self.commands, &head, cmd, memory_order_release, memory_order_relaxed
+    ));
+}
+
+/* Take all queued commands at once, restoring submission order */
+static inline
+PxCommand* _pop_commands() {
+    PxCommand* head = atomic_exchange_explicit(&self.commands, NULL, memory_order_acquire);
+    PxCommand* reversed = NULL;
+
+    while (head) {
+        PxCommand* next = head->next;
+        head->next = reversed;
+        reversed = head;
+        head = next;
+    }
+    return reversed;
+}
+
+static
+void _delete(PxObject* obj) {
+    if (_is_simulated(obj)) {
+        u32 last_index = cvector_size(self.bodies) - 1;
+        PxObject* last = self.bodies[last_index];
+        self.bodies[obj->body_index] = last;
+        last->body_index = obj->body_index;
+        cvector_pop_back(self.bodies);
+
+        for (int b = 0; b < 2; b++) {
+            self.states[b][obj->body_index] = self.states[b][last_index];
+            cvector_pop_back(self.states[b]);
+        }
+    }
+
+    map_remove(self.objects, (void*)(intptr_t)obj->id);
+    px_query_remove(obj);
+    px_object_free(obj);
+}
+
+static
+void _set_position(PxObject* obj, vec3 pos) {
+    px_object_apply_position(obj, pos);
+    px_query_move(obj);
+    if (!_is_simulated(obj))  return;
+
+    // Sleeping body may be moved mid-air, region is assigned again next step
+    dBodyEnable(obj->body);
+    obj->held = false;
+
+    // Teleport, don't interpolate from old position
+    PxBodyState* state = &self.states[self.front][obj->body_index];
+    _copy_state(obj, state->pos, state->rot);
+    _copy_state(obj, state->prev_pos, state->prev_rot);
+}
+
+static
+void _apply_commands() {
+    PxCommand* cmd = _pop_commands();
+
+    while (cmd) {
+        PxObject* obj = cmd->obj;
+        switch (cmd->type) {
+            case PXCMD_SPAWN:
+                px_object_build(obj, obj->pending);
+                free(obj->pending);
+                obj->pending = NULL;
+                break;
+
+            case PXCMD_DELETE:        _delete(obj);                break;
+            case PXCMD_SET_POSITION:  _set_position(obj, cmd->pos);  break;
+        }
+
+        PxCommand* next = cmd->next;
+        free(cmd);
+        cmd = next;
+    }
+}
+
+/* Bring physics to sync window: join dispatched batch (or run undispatched
+   one inline), publish it and apply commands queued meanwhile */
+static
+void _sync() {
+    if (self.busy)            _join();
+    else if (self.scheduled)  _simulate(self.batch_steps);
+
+    if (self.scheduled)  _publish();
+    _apply_commands();
+}
+
+/* ------------------------------------------------------------------------- */
+
 void px_init() {
+    if (Config.PHYSICS_STEP_RATE <= 0.0)
+        log_exit("[physics] Invalid step rate: %.2f", Config.PHYSICS_STEP_RATE);
+    if (Config.PHYSICS_MAX_SUBSTEPS < 1)
+        log_exit("[physics] Max substeps must be at least 1");
+
     dSetMessageHandler(custom_message_handler);
     dInitODE();
 
     self.world = dWorldCreate();
-    self.space = dHashSpaceCreate(0);
+    self.static_space = NULL;
+    self.dynamic_space = dHashSpaceCreate(0);
+    px_build_static_space((vec3){0.0, 0.0, 0.0}, (vec3){PX_STATIC_EXTENT, PX_STATIC_EXTENT, PX_STATIC_EXTENT});
     self.contact_group = dJointGroupCreate(0);
+    px_query_init();
     
     self.objects = map_new(MHASH_INT);
-    self.next_id = 1;
+    self.bodies = NULL;
+    atomic_store(&self.next_id, 1);
+
+    self.step = 1.0 / Config.PHYSICS_STEP_RATE;
+    _init_regions();
+    self.accumulator = 0.0;
+    self.frame_steps = 0;
+    self.alpha = 0.0;
+    self.scheduled = false;
+    memset(&self.stats, 0, sizeof(PxStats));
+
+    self.states[0] = NULL;
+    self.states[1] = NULL;
+    self.front = 0;
 
     dWorldSetGravity(self.world, 0.0, 0.0, (dReal)PHYSICS_GRAVITY);
 
     // Set global physics parameters for stability
     dWorldSetERP(self.world, 0.2);  // Error reduction parameter
     dWorldSetCFM(self.world, 1e-5); // Constraint force mixing
+
+    _init_step_threads();
+
+    self.main_thread = pthread_self();
+    self.threaded = Config.PHYSICS_THREADED;
+    self.busy = false;
+    atomic_store(&self.commands, NULL);
+
+    if (!self.threaded)  return;
+
+    pthread_mutex_init(&self.lock, NULL);
+    pthread_cond_init(&self.cond, NULL);
+    self.run = false;
+    self.stop = false;
+
+    if (pthread_create(&self.thread, NULL, _worker, NULL) != 0)
+        log_exit("[physics] Unable to start physics thread");
 }
 
 void px_destroy() {
+    _sync();
+
+    if (self.threaded) {
+        pthread_mutex_lock(&self.lock);
+        self.stop = true;
+        pthread_cond_broadcast(&self.cond);
+        pthread_mutex_unlock(&self.lock);
+
+        pthread_join(self.thread, NULL);
+        pthread_cond_destroy(&self.cond);
+        pthread_mutex_destroy(&self.lock);
+    }
+
     PxObject* obj;
 
     map_for_each(obj, self.objects) {
         px_object_free(obj);
     }
     map_free(self.objects);
+    px_query_destroy();
+    cvector_free(self.bodies);
+    cvector_free(self.pinned);
+    cvector_free(self.states[0]);
+    cvector_free(self.states[1]);
 
     dJointGroupDestroy(self.contact_group);
-    dSpaceDestroy(self.space);
+    dSpaceDestroy(self.dynamic_space);
+    dSpaceDestroy(self.static_space);
+    _free_step_threads();
     dWorldDestroy(self.world);
     
     dCloseODE();
 }
 
-void px_add_object(PxObject* obj) {
-    map_set(self.objects, obj, (void*)(intptr_t)obj->id);
-}
+void px_update(f64 dt) {
+    _sync();
 
-void px_delete_object(PxObject* obj) {
-    if (!obj)  return;
+    self.accumulator += dt;
+    u32 steps = 0;
 
-    map_remove(self.objects, (void*)(intptr_t)obj->id);
-    px_object_free(obj);
+    while (self.accumulator >= self.step && steps < (u32)Config.PHYSICS_MAX_SUBSTEPS) {
+        self.accumulator -= self.step;
+        steps++;
+    }
+
+    // Too far behind (hitch, loading), drop the rest instead of spiraling
+    if (self.accumulator >= self.step)
+        self.accumulator = fmod(self.accumulator, self.step);
+
+    self.batch_steps = steps;
+    self.batch_alpha = self.accumulator / self.step;
+    self.scheduled = true;
+
+    if (!self.threaded) {
+        _simulate(steps);
+        _publish();
+    }
 }
 
-// FIXME
-PxObject* px_get_object_by_geom(dGeomID geom) {
-    PxObject* obj;
-    map_for_each(obj, self.objects) {
-        if (geom == obj->geom)  return obj;
+void px_dispatch() {
+    if (!self.threaded || !self.scheduled || self.busy)  return;
+
+    if (!self.batch_steps) {
+        _publish();
+        return;
     }
 
-    return NULL;
+    self.busy = true;
+    pthread_mutex_lock(&self.lock);
+    self.run = true;
+    pthread_cond_broadcast(&self.cond);
+    pthread_mutex_unlock(&self.lock);
 }
 
-u32 px_next_id() { return self.next_id++; }
-dWorldID px_get_world() { return self.world; }
-dSpaceID px_get_space() { return self.space; }
+f64 px_get_alpha() { return self.alpha; }
+u32 px_get_frame_steps() { return self.frame_steps; }
 
+const PxBodyState* px_get_body_state(PxObject* obj) {
+    return &self.states[self.front][obj->body_index];
+}
+
+PxStats px_get_stats() { return self.stats; }
+
+void px_print() {
+    log_debug(
+        "total PxObject: %i (static geoms %i, dynamic geoms %i)", map_size(self.objects),
+        dSpaceGetNumGeoms(self.static_space), dSpaceGetNumGeoms(self.dynamic_space)
+    );
+    log_debug(
+        "physics pairs last batch: dynamic %u, static %u, dropped %u (contacts %u)",
+        self.stats.dynamic_pairs, self.stats.static_pairs, self.stats.dropped_pairs, self.stats.contacts
+    );
+    log_debug(
+        "physics bodies last batch: active %u, ring %u, sleeping %u, held %u",
+        self.stats.active_bodies, self.stats.ring_bodies, self.stats.sleeping_bodies, self.stats.held_bodies
+    );
+}
+
+void px_set_focus(vec3 pos) {
+    self.focus[0] = pos[0];
+    self.focus[1] = -pos[2];
+    self.has_focus = true;
+}
 
 /* ------------------------------------------------------------------------- */
 
-// For kinematic bodies, create contact only for the kinematic body
-// (player gets blocked, cube doesn't move)
-static inline
-void _kinematic_contact_surface_params(dContact contact) {
-    contact.surface.mode = dContactBounce | dContactSoftERP | dContactSoftCFM;
-    contact.surface.mu = 0.0;  // No friction
-    contact.surface.mu2 = 0;
-    contact.surface.bounce = 0.001;  // Almost no bounce
-    contact.surface.bounce_vel = 0.001;
-    contact.surface.soft_erp = 0.15;  // Strong enough to block player
-    contact.surface.soft_cfm = 0.02;
+void px_build_static_space(vec3 center, vec3 extent) {
+    dVector3 center_ = {center[0], -center[2], center[1]};
+    dVector3 extent_ = {extent[0], extent[2], extent[1]};
+
+    // Quadtree splits ODE X/Y (engine XZ) plane, blocks halve per level
+    int depth = 1;
+    for (f64 side = 2.0 * fmax(extent_[0], extent_[1]); side > PX_STATIC_LEAF && depth < PX_STATIC_MAX_DEPTH; side /= 2.0)
+        depth++;
+
+    dSpaceID space = dQuadTreeSpaceCreate(0, center_, extent_, depth);
+
+    // Keep statics created before scene load
+    if (self.static_space) {
+        while (dSpaceGetNumGeoms(self.static_space)) {
+            dGeomID geom = dSpaceGetGeom(self.static_space, 0);
+            dSpaceRemove(self.static_space, geom);
+            dSpaceAdd(space, geom);
+        }
+        dSpaceDestroy(self.static_space);
+    }
+    self.static_space = space;
 }
 
-// Normal contact for rigid-rigid collisions
-static inline
-void _rigid_contact_surface_params(dContact contact) {
-    contact.surface.mode = dContactBounce | dContactSoftERP | dContactSoftCFM;
-    contact.surface.mu = dInfinity;
-    contact.surface.mu2 = 0;
-    contact.surface.bounce = 0.1;
-    contact.surface.bounce_vel = 0.1;
-    contact.surface.soft_erp = 0.2;
-    contact.surface.soft_cfm = 0.001;
+void px_collide(void* data, dNearCallback* callback) {
+    dSpaceCollide(self.dynamic_space, data, callback);
+    dSpaceCollide2((dGeomID)self.static_space, (dGeomID)self.dynamic_space, data, callback);
 }
 
-static const int MAX_CONTACTS = 8;
+void px_collide_geom(dGeomID geom, void* data, dNearCallback* callback) {
+    dSpaceCollide2(geom, (dGeomID)self.static_space, data, callback);
+    dSpaceCollide2(geom, (dGeomID)self.dynamic_space, data, callback);
+}
 
-static
-void collision_callback(void* data, dGeomID geom1, dGeomID geom2) {
-    dBodyID body1 = dGeomGetBody(geom1);
-    dBodyID body2 = dGeomGetBody(geom2);
-    
-    /* --- Collision Validation --- */
-    // Skip self-collisions for the same body
-    if (body1 && body2 && body1 == body2) return;
-    
-    // Skip collisions between two static objects (both without bodies)
-    if (!body1 && !body2) return;
-    
-    // Skip rigid-ray interactions
-    if (dGeomGetClass(geom1) == dRayClass || dGeomGetClass(geom2) == dRayClass) return;
+/* ------------------------------------------------------------------------- */
 
-    bool is_kinematic = false;
-    if (body1 && dBodyIsKinematic(body1))  is_kinematic = true;
-    if (body2 && dBodyIsKinematic(body2))  is_kinematic = true;
+void px_submit_spawn(PxObject* obj, const PxObjectDesc* desc) {
+    if (_in_window()) {
+        px_object_build(obj, desc);
+        return;
+    }
 
-    /* --- Collision Handling --- */
-    dContact contact[MAX_CONTACTS];
-    i32 n = dCollide(geom1, geom2, MAX_CONTACTS, &contact[0].geom, sizeof(dContact));
+    obj->pending = malloc(sizeof(PxObjectDesc));
+    *obj->pending = *desc;
+    _push_command(PXCMD_SPAWN, obj, NULL);
+}
 
-    for (int i = 0; i < n; i++) {        
-        if (is_kinematic) {
-            _kinematic_contact_surface_params(contact[i]);
-        }
-        else {
-            // _rigid_contact_surface_params(contact[i]);
-            dJointID c = dJointCreateContact(self.world, self.contact_group, &contact[i]);
-            dJointAttach(c, dGeomGetBody(geom1), dGeomGetBody(geom2));
-        }
+void px_submit_position(PxObject* obj, vec3 pos) {
+    if (_in_window() && !obj->pending)  _set_position(obj, pos);
+    else                                _push_command(PXCMD_SET_POSITION, obj, pos);
+}
+
+void px_delete_object(PxObject* obj) {
+    if (!obj)  return;
+
+    if (_in_window() && !obj->pending)  _delete(obj);
+    else                                _push_command(PXCMD_DELETE, obj, NULL);
+}
+
+void px_add_object(PxObject* obj) {
+    map_set(self.objects, obj, (void*)(intptr_t)obj->id);
+
+    dGeomSetData(obj->geom, obj);
+    if (obj->body)  dBodySetData(obj->body, obj);
+    px_query_insert(obj);
+
+    if (_is_simulated(obj)) {
+        obj->body_index = cvector_size(self.bodies);
+        cvector_push_back(self.bodies, obj);
+
+        PxBodyState state;
+        _copy_state(obj, state.pos, state.rot);
+        _copy_state(obj, state.prev_pos, state.prev_rot);
+        cvector_push_back(self.states[0], state);
+        cvector_push_back(self.states[1], state);
     }
 }
 
-void px_update() {
-    dSpaceCollide(self.space, 0, collision_callback);
-    dWorldQuickStep(self.world, TIMESTEP);
-    dJointGroupEmpty(self.contact_group);
+/* Geoms not owned by PxObject (e.g. query probes) have no user data */
+PxObject* px_get_object_by_geom(dGeomID geom) {
+    return geom ? dGeomGetData(geom) : NULL;
 }
+
+u32 px_next_id() { return atomic_fetch_add(&self.next_id, 1); }
+dWorldID px_get_world() { return self.world; }
+dSpaceID px_get_static_space() { return self.static_space; }
+dSpaceID px_get_dynamic_space() { return self.dynamic_space; }
@@ -7,18 +7,83 @@
 
 #define PHYSICS_GRAVITY -9.81
 
+/*
+    With `[physics] threaded`, physics thread owns ODE world while stepping:
+    steps scheduled by `px_update` run between `px_dispatch` and next
+    `px_update`, overlapping with frame draw. Between `px_update` and
+    `px_dispatch` (the sync window) main thread may use ODE directly
+    (player queries, getters), outside of it (or from other threads)
+    spawn / delete / set position are queued, rigid transforms are read
+    from published snapshot. Each world step is further split across
+    `step_threads` threads of ODE pool (independent islands in parallel).
+
+    Static geoms live in quadtree space sized to scene once at load, rigid
+    & kinematic bodies in dynamic hash space. Broadphase runs over dynamic
+    geoms only, static pairs are never generated. Scene queries (rays,
+    casts, overlaps) go through `px_query` and never add geoms to spaces.
+
+    Resting bodies fall asleep (ODE auto-disable). With `active_radius`,
+    bodies farther from focus (player) are held still, ones in ring up to
+    `ring_radius` are stepped at lower rate, so step cost follows what's
+    around the player rather than scene size.
+*/
+
+/* Rigid body state around last published step batch, ODE space */
+typedef struct PxBodyState {
+    dReal prev_pos[3];
+    dQuaternion prev_rot;
+    dReal pos[3];
+    dQuaternion rot;
+} PxBodyState;
+
+/* Broadphase pairs of last published step batch */
+typedef struct PxStats {
+    u32 dynamic_pairs;      // dynamic vs dynamic
+    u32 static_pairs;       // dynamic vs static
+    u32 dropped_pairs;      // static vs static, stays 0 with split spaces
+    u32 contacts;
+
+    u32 active_bodies;      // stepped every step
+    u32 ring_bodies;        // stepped every `ring_interval` steps
+    u32 sleeping_bodies;    // at rest until hit
+    u32 held_bodies;        // out of range, frozen
+} PxStats;
+
 /* ------------------------------------------------------------------------- */
 
 void px_init();
 void px_destroy();
-void px_update();
+/* Wait for dispatched steps, publish their snapshot, apply queued commands,
+   then schedule real `dt` in fixed steps (0..max_substeps per call) */
+void px_update(f64 dt);
+/* Start scheduled steps on physics thread, they run until next `px_update` */
+void px_dispatch();
+/* Fraction of step accumulated since last published step, to blend last two states */
+f64 px_get_alpha();
+u32 px_get_frame_steps();
+const PxBodyState* px_get_body_state(PxObject* obj);
+PxStats px_get_stats();
+void px_print();
+/* Center of active region (engine space), within sync window */
+void px_set_focus(vec3 pos);
 
-// FIXME
-void px_add_object(PxObject* obj);
-// void px_create_object(PxObject* obj);
+/* Rebuild static space around scene bounds (engine space), within sync window */
+void px_build_static_space(vec3 center, vec3 extent);
+/* Broadphase over dynamic geoms: dynamic vs dynamic, then vs static */
+void px_collide(void* data, dNearCallback* callback);
+/* Broadphase of single geom (may be in no space) against geoms near it */
+void px_collide_geom(dGeomID geom, void* data, dNearCallback* callback);
+
+/* Build now within sync window, otherwise queue */
+void px_submit_spawn(PxObject* obj, const PxObjectDesc* desc);
+void px_submit_position(PxObject* obj, vec3 pos);
 void px_delete_object(PxObject* obj);
+
+/* Called by `px_object_build` */
+void px_add_object(PxObject* obj);
 PxObject* px_get_object_by_geom(dGeomID geom);
 
 u32 px_next_id();
 dWorldID px_get_world();
-dSpaceID px_get_space();
+dSpaceID px_get_static_space();
+dSpaceID px_get_dynamic_space();
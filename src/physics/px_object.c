@@ -6,31 +6,75 @@
 #define RCOMP  (M_PI / 180.0)
 
 
-void px_object_free(PxObject* obj) {
-    if (obj->geom) {
-        dGeomSetBody(obj->geom, 0);
-        dGeomDestroy(obj->geom);
-    }
-    if (obj->body) {
-        dBodyDisable(obj->body);
-        dBodySetData(obj->body, NULL);
-        dBodyDestroy(obj->body);
-    }
-    free(obj);
+/* ODE rotation matrix to engine euler angles (degrees) */
+static inline
+void _rotation_to_euler(const dReal* R, vec3 dest) {
+    mat3 rot_ = {R[0], R[1], R[2], R[4], R[5], R[6], R[8], R[9], R[10]};
+    
+    float rot_x = atan2(rot_[2][1], rot_[2][2]) * (180.0 / M_PI);
+    float rot_y = atan2(-rot_[2][0], sqrt(pow(rot_[2][1], 2) + pow(rot_[2][2], 2))) * (180.0 / M_PI);
+    float rot_z = atan2(rot_[1][0], rot_[0][0]) * (180.0 / M_PI);
+    
+    dest[0] = rot_x;
+    dest[1] = rot_z;
+    dest[2] = -rot_y;
 }
 
-/* ------ px_static ------ */
-/* ------------------------------------------------------------------------- */
+/* ODE space position to engine */
+static inline
+void _position_to_vec3(const dReal* pos, vec3 dest) {
+    glm_vec3_copy((vec3){pos[0], pos[2], -pos[1]}, dest);
+}
 
-PxObject* px_static_create(PxBodyType type, vec3 pos, vec3 rot,vec3 size) {
+/* Statics meet only what moves, player is left out of stepping (no contacts
+   with kinematic body) and meets world through its own queries */
+static inline
+void _default_masks(PxObject* obj, PxObjectType object_type) {
+    switch (object_type) {
+        case PXOBJ_STATIC:
+            obj->category = PXCAT_STATIC;
+            obj->collide = PXCAT_ITEM | PXCAT_RAY;
+            break;
+        case PXOBJ_RIGID:
+            obj->category = PXCAT_ITEM;
+            obj->collide = PXCAT_STATIC | PXCAT_ITEM | PXCAT_RAY;
+            break;
+        case PXOBJ_KINEMATIC:
+            obj->category = PXCAT_PLAYER;
+            obj->collide = 0;
+            break;
+    }
+}
+
+/* Allocate object, geom & body are built now or by queued spawn */
+static
+PxObject* _spawn(PxObjectType object_type, PxBodyType type, vec3 pos, vec3 rot, vec3 size, f32 mass) {
     PxObject* obj = malloc(sizeof(PxObject));
     memset(obj, 0, sizeof(PxObject));
+    obj->id = px_next_id();
+    obj->type = type;
+    _default_masks(obj, object_type);
+
+    PxObjectDesc desc = {.object_type = object_type, .type = type, .mass = mass};
+    glm_vec3_copy(pos, desc.pos);
+    glm_vec3_copy(rot, desc.rot);
+    glm_vec3_copy(size, desc.size);
 
-    if (type == PXBODY_BOX) {
-        obj->geom = dCreateBox(px_get_space(), size[0], size[2], size[1]);
+    px_submit_spawn(obj, &desc);
+    return obj;
+}
+
+static
+void _build_static(PxObject* obj, const PxObjectDesc* desc) {
+    const f32* pos = desc->pos;
+    const f32* rot = desc->rot;
+    const f32* size = desc->size;
+
+    if (desc->type == PXBODY_BOX) {
+        obj->geom = dCreateBox(0, size[0], size[2], size[1]);
     }
-    else if (type == PXBODY_CAPSULE) {
-        obj->geom = dCreateCapsule(px_get_space(), size[0], size[1]);
+    else if (desc->type == PXBODY_CAPSULE) {
+        obj->geom = dCreateCapsule(0, size[0], size[1]);
     }
 
     dGeomSetPosition(obj->geom, pos[0], -pos[2], pos[1]);
@@ -38,44 +82,21 @@ PxObject* px_static_create(PxBodyType type, vec3 pos, vec3 rot,vec3 size) {
     dRFromEulerAngles(R, rot[0]*RCOMP, rot[2]*RCOMP, rot[1]*RCOMP);
     dGeomSetRotation(obj->geom, R);
 
-    obj->id = px_next_id();
-    obj->type = type;
-    obj->body = NULL;  // Static objects don't have bodies
-
-    px_add_object(obj);
-    return obj;
-}
-
-void px_static_get_position(PxObject* obj, vec3 dest) {
-    const dReal* pos = dGeomGetPosition(obj->geom);
-    glm_vec3_copy((vec3){pos[0], pos[2], -pos[1]}, dest);
-}
-
-void px_static_set_position(PxObject* obj, vec3 pos) {
-    dGeomSetPosition(obj->geom, pos[0], -pos[2], pos[1]);
-}
+    // Quadtree files geom by its AABB on add, unplaced geoms would pile up
+    // in root block and be moved out one by one on first collide
+    dReal aabb[6];
+    dGeomGetAABB(obj->geom, aabb);
+    dSpaceAdd(px_get_static_space(), obj->geom);
 
-void px_static_get_rotation(PxObject* obj, vec3 dest) {
-    const dReal* R = dGeomGetRotation(obj->geom);
-    
-    mat3 rot_ = {R[0], R[1], R[2], R[4], R[5], R[6], R[8], R[9], R[10]};
-    
-    float rot_x = atan2(rot_[2][1], rot_[2][2]) * (180.0 / M_PI);
-    float rot_y = atan2(-rot_[2][0], sqrt(pow(rot_[2][1], 2) + pow(rot_[2][2], 2))) * (180.0 / M_PI);
-    float rot_z = atan2(rot_[1][0], rot_[0][0]) * (180.0 / M_PI);
-    
-    dest[0] = rot_x;
-    dest[1] = rot_z;
-    dest[2] = -rot_y;
+    obj->body = NULL;  // Static objects don't have bodies
 }
 
-/* ------ px_rigid ------ */
-/* ------------------------------------------------------------------------- */
+static
+void _build_rigid(PxObject* obj, const PxObjectDesc* desc) {
+    const f32* pos = desc->pos;
+    const f32* rot = desc->rot;
+    const f32* size = desc->size;
 
-PxObject* px_rigid_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size, f32 mass) {
-    PxObject* obj = malloc(sizeof(PxObject));
-    memset(obj, 0, sizeof(PxObject));
-    
     // Create the body
     obj->body = dBodyCreate(px_get_world());
     dBodySetPosition(obj->body, pos[0], -pos[2], pos[1]);
@@ -88,62 +109,32 @@ PxObject* px_rigid_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size, f32 ma
     // Set mass and type-specific properties
     dMass mass_;
     
-    switch (type) {
+    switch (desc->type) {
         case PXBODY_BOX:
-            dMassSetBoxTotal(&mass_, mass, size[0], size[2], size[1]);
-            obj->geom = dCreateBox(px_get_space(), size[0], size[2], size[1]);
+            dMassSetBoxTotal(&mass_, desc->mass, size[0], size[2], size[1]);
+            obj->geom = dCreateBox(px_get_dynamic_space(), size[0], size[2], size[1]);
             break;
 
         case PXBODY_CAPSULE:
-            dMassSetCapsuleTotal(&mass_, mass, 3, size[0], size[1]);
-            obj->geom = dCreateCapsule(px_get_space(), size[0], size[1]);
+            dMassSetCapsuleTotal(&mass_, desc->mass, 3, size[0], size[1]);
+            obj->geom = dCreateCapsule(px_get_dynamic_space(), size[0], size[1]);
             break;
 
         default:
             dBodyDestroy(obj->body);
-            log_exit("Physics error: Unsupported body type %d", type);
+            log_exit("Physics error: Unsupported body type %d", desc->type);
     }
     
     dBodySetMass(obj->body, &mass_);
     dGeomSetBody(obj->geom, obj->body);
-
-    obj->id = px_next_id();
-    obj->type = type;
-    
-    px_add_object(obj);
-    return obj;
 }
 
-void px_rigid_get_position(PxObject* obj, vec3 dest) {
-    const dReal* pos = dBodyGetPosition(obj->body);
-    glm_vec3_copy((vec3){pos[0], pos[2], -pos[1]}, dest);
-}
+static
+void _build_kinematic(PxObject* obj, const PxObjectDesc* desc) {
+    const f32* pos = desc->pos;
+    const f32* rot = desc->rot;
+    const f32* size = desc->size;
 
-void px_rigid_set_position(PxObject* obj, vec3 pos) {
-    dBodySetPosition(obj->body, pos[0], -pos[2], pos[1]);
-}
-
-void px_rigid_get_rotation(PxObject* obj, vec3 dest) {
-    const dReal* R = dBodyGetRotation(obj->body);
-    
-    mat3 rot_ = {R[0], R[1], R[2], R[4], R[5], R[6], R[8], R[9], R[10]};
-    
-    float rot_x = atan2(rot_[2][1], rot_[2][2]) * (180.0 / M_PI);
-    float rot_y = atan2(-rot_[2][0], sqrt(pow(rot_[2][1], 2) + pow(rot_[2][2], 2))) * (180.0 / M_PI);
-    float rot_z = atan2(rot_[1][0], rot_[0][0]) * (180.0 / M_PI);
-    
-    dest[0] = rot_x;
-    dest[1] = rot_z;
-    dest[2] = -rot_y;
-}
-
-/* ------ px_kinematic ------ */
-/* ------------------------------------------------------------------------- */
-
-PxObject* px_kinematic_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size) {
-    PxObject* obj = malloc(sizeof(PxObject));
-    memset(obj, 0, sizeof(PxObject));
-    
     // Create the body
     obj->body = dBodyCreate(px_get_world());
     dBodySetPosition(obj->body, pos[0], -pos[2], pos[1]);
@@ -157,45 +148,175 @@ PxObject* px_kinematic_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size) {
     dBodySetKinematic(obj->body);
     
     // Create geometry based on type
-    if (type == PXBODY_BOX) {
-        obj->geom = dCreateBox(px_get_space(), size[0], size[2], size[1]);
+    if (desc->type == PXBODY_BOX) {
+        obj->geom = dCreateBox(px_get_dynamic_space(), size[0], size[2], size[1]);
+    }
+    else {
+        obj->geom = dCreateCapsule(px_get_dynamic_space(), size[0], size[1] - size[0]);
+    }
+    dGeomSetBody(obj->geom, obj->body);
+}
+
+void px_object_build(PxObject* obj, const PxObjectDesc* desc) {
+    switch (desc->object_type) {
+        case PXOBJ_STATIC:     _build_static(obj, desc);     break;
+        case PXOBJ_RIGID:      _build_rigid(obj, desc);      break;
+        case PXOBJ_KINEMATIC:  _build_kinematic(obj, desc);  break;
     }
-    else if (type == PXBODY_CAPSULE) {
-        obj->geom = dCreateCapsule(px_get_space(), size[0], size[1] - size[0]);
+    dGeomSetCategoryBits(obj->geom, obj->category);
+    dGeomSetCollideBits(obj->geom, obj->collide);
+
+    px_add_object(obj);
+}
+
+void px_object_set_masks(PxObject* obj, u32 category, u32 collide) {
+    obj->category = category;
+    obj->collide = collide;
+    if (!obj->geom)  return;  // applied on build
+
+    dGeomSetCategoryBits(obj->geom, category);
+    dGeomSetCollideBits(obj->geom, collide);
+}
+
+void px_object_apply_position(PxObject* obj, vec3 pos) {
+    if (!obj->body) {
+        dGeomSetPosition(obj->geom, pos[0], -pos[2], pos[1]);
     }
     else {
-        log_error("Physics error: Unsupported body type %d", type);
+        dBodySetPosition(obj->body, pos[0], -pos[2], pos[1]);
+    }
+}
+
+void px_object_free(PxObject* obj) {
+    if (obj->geom) {
+        dGeomSetData(obj->geom, NULL);
+        dGeomSetBody(obj->geom, 0);
+        dGeomDestroy(obj->geom);
+    }
+    if (obj->body) {
+        dBodyDisable(obj->body);
+        dBodySetData(obj->body, NULL);
         dBodyDestroy(obj->body);
-        free(obj);
+    }
+    free(obj->pending);
+    free(obj);
+}
+
+/* ------ px_static ------ */
+/* ------------------------------------------------------------------------- */
+
+PxObject* px_static_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size) {
+    return _spawn(PXOBJ_STATIC, type, pos, rot, size, 0.0);
+}
+
+void px_static_get_position(PxObject* obj, vec3 dest) {
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->pos, dest);
+        return;
+    }
+    _position_to_vec3(dGeomGetPosition(obj->geom), dest);
+}
+
+void px_static_set_position(PxObject* obj, vec3 pos) {
+    px_submit_position(obj, pos);
+}
+
+void px_static_get_rotation(PxObject* obj, vec3 dest) {
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->rot, dest);
+        return;
+    }
+    _rotation_to_euler(dGeomGetRotation(obj->geom), dest);
+}
+
+/* ------ px_rigid ------ */
+/* ------------------------------------------------------------------------- */
+
+PxObject* px_rigid_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size, f32 mass) {
+    return _spawn(PXOBJ_RIGID, type, pos, rot, size, mass);
+}
+
+/* Rigid bodies are read from snapshot, physics thread may be stepping them */
+void px_rigid_get_position(PxObject* obj, vec3 dest) {
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->pos, dest);
+        return;
+    }
+    _position_to_vec3(px_get_body_state(obj)->pos, dest);
+}
+
+void px_rigid_set_position(PxObject* obj, vec3 pos) {
+    px_submit_position(obj, pos);
+}
+
+void px_rigid_get_rotation(PxObject* obj, vec3 dest) {
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->rot, dest);
+        return;
+    }
+    dMatrix3 R;
+    dQtoR(px_get_body_state(obj)->rot, R);
+    _rotation_to_euler(R, dest);
+}
+
+void px_rigid_get_render_transform(PxObject* obj, vec3 pos, vec3 rot) {
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->pos, pos);
+        glm_vec3_copy(obj->pending->rot, rot);
+        return;
+    }
+
+    const PxBodyState* state = px_get_body_state(obj);
+    dReal alpha = px_get_alpha();
+
+    dReal p[3];
+    for (int i = 0; i < 3; i++) {
+        p[i] = state->prev_pos[i] + (state->pos[i] - state->prev_pos[i]) * alpha;
+    }
+
+    // Normalized lerp along shorter arc, rotation within one step is small
+    dReal dot = 0.0;
+    for (int i = 0; i < 4; i++)  dot += state->prev_rot[i] * state->rot[i];
+    dReal sign = dot < 0.0 ? -1.0 : 1.0;
+
+    dQuaternion q;
+    for (int i = 0; i < 4; i++) {
+        q[i] = state->prev_rot[i] + (sign * state->rot[i] - state->prev_rot[i]) * alpha;
+    }
+    dNormalize4(q);
+
+    dMatrix3 R;
+    dQtoR(q, R);
+    _position_to_vec3(p, pos);
+    _rotation_to_euler(R, rot);
+}
+
+/* ------ px_kinematic ------ */
+/* ------------------------------------------------------------------------- */
+
+PxObject* px_kinematic_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size) {
+    if (type != PXBODY_BOX && type != PXBODY_CAPSULE) {
+        log_error("Physics error: Unsupported body type %d", type);
         return NULL;
     }
-    dGeomSetBody(obj->geom, obj->body);
-    
-    obj->id = px_next_id();
-    obj->type = type;
-    
-    px_add_object(obj);
-    return obj;
+    return _spawn(PXOBJ_KINEMATIC, type, pos, rot, size, 0.0);
 }
 
 void px_kinematic_get_position(PxObject* obj, vec3 dest) {
-    const dReal* pos = dBodyGetPosition(obj->body);
-    glm_vec3_copy((vec3){pos[0], pos[2], -pos[1]}, dest);
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->pos, dest);
+        return;
+    }
+    _position_to_vec3(dBodyGetPosition(obj->body), dest);
 }
 void px_kinematic_set_position(PxObject* obj, vec3 pos) {
-    dBodySetPosition(obj->body, pos[0], -pos[2], pos[1]);
+    px_submit_position(obj, pos);
 }
 
 void px_kinematic_get_rotation(PxObject* obj, vec3 dest) {
-    const dReal* R = dBodyGetRotation(obj->body);
-    
-    mat3 rot_ = {R[0], R[1], R[2], R[4], R[5], R[6], R[8], R[9], R[10]};
-    
-    float rot_x = atan2(rot_[2][1], rot_[2][2]) * (180.0 / M_PI);
-    float rot_y = atan2(-rot_[2][0], sqrt(pow(rot_[2][1], 2) + pow(rot_[2][2], 2))) * (180.0 / M_PI);
-    float rot_z = atan2(rot_[1][0], rot_[0][0]) * (180.0 / M_PI);
-    
-    dest[0] = rot_x;
-    dest[1] = rot_z;
-    dest[2] = -rot_y;
+    if (obj->pending) {
+        glm_vec3_copy(obj->pending->rot, dest);
+        return;
+    }
+    _rotation_to_euler(dBodyGetRotation(obj->body), dest);
 }
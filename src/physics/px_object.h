@@ -4,22 +4,64 @@
 
 #include "core/types.h"
 
-// typedef enum {
-//     PXOBJ_STATIC,
-//     PXOBJ_RIGID,
-//     PX_OBJ_KINEMATIC,
-// } PxObjectType;
+typedef enum {
+    PXOBJ_STATIC,
+    PXOBJ_RIGID,
+    PXOBJ_KINEMATIC,
+} PxObjectType;
 
 typedef enum {
     PXBODY_BOX,
     PXBODY_CAPSULE,
 } PxBodyType;
 
+/*
+    Collision categories: geom pair is tested only if category of either
+    one is in collide mask of the other (ODE broadphase skips the rest).
+    Queries (`px_query`) are of PXCAT_RAY category and find only objects
+    with PXCAT_RAY in their collide mask.
+*/
+typedef enum {
+    PXCAT_STATIC   = 1 << 0,    // static world
+    PXCAT_ITEM     = 1 << 1,    // dynamic items
+    PXCAT_PLAYER   = 1 << 2,
+    PXCAT_RAY      = 1 << 3,    // interaction ray & other queries
+    PXCAT_TRIGGER  = 1 << 4,    // sensor volumes (collide with player), pairs get no contacts
+} PxCategory;
+
+/* Distance band around player (`px_set_focus`) a rigid body is in */
+typedef enum {
+    PXREGION_ACTIVE,    // stepped every step
+    PXREGION_RING,      // stepped every `ring_interval` steps
+    PXREGION_FAR,       // frozen
+} PxRegion;
+
+/* Creation parameters, kept until queued spawn is built */
+typedef struct {
+    PxObjectType object_type;
+    PxBodyType type;
+    vec3 pos;
+    vec3 rot;
+    vec3 size;
+    f32 mass;
+} PxObjectDesc;
+
+// Geom & body user data point back to their PxObject (`px_get_object_by_geom`)
 typedef struct {
     u32 id;
     PxBodyType type;
     dBodyID body;
     dGeomID geom;
+    u32 owner;  // id of ObjectRef owning object, 0 if none
+    PxObjectDesc* pending;  // spawn is queued, geom & body not created yet
+
+    u32 body_index;  // in list of simulated (rigid) bodies & snapshot
+    u32 proxy;       // leaf in query BVH (`px_query`)
+    PxRegion region;
+    bool held;       // disabled by region, not asleep
+
+    u32 category;    // PxCategory bits, defaults by object type
+    u32 collide;
 } PxObject;
 
 PxObject* px_static_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size);
@@ -31,10 +73,18 @@ PxObject* px_rigid_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size, f32 ma
 void px_rigid_get_position(PxObject* obj, vec3 dest);
 void px_rigid_set_position(PxObject* obj, vec3 pos);
 void px_rigid_get_rotation(PxObject* obj, vec3 dest);
+/* Transform between last two published steps by `px_get_alpha`, for rendering */
+void px_rigid_get_render_transform(PxObject* obj, vec3 pos, vec3 rot);
 
 PxObject* px_kinematic_create(PxBodyType type, vec3 pos, vec3 rot, vec3 size);
 void px_kinematic_get_position(PxObject* obj, vec3 dest);
 void px_kinematic_set_position(PxObject* obj, vec3 pos);
 void px_kinematic_get_rotation(PxObject* obj, vec3 dest);
 
+/* Right after create, or within sync window once built */
+void px_object_set_masks(PxObject* obj, u32 category, u32 collide);
+
+/* Create geom & body, applied by `px_submit_*` within sync window */
+void px_object_build(PxObject* obj, const PxObjectDesc* desc);
+void px_object_apply_position(PxObject* obj, vec3 pos);
 void px_object_free(PxObject* obj);
@@ -3,19 +3,39 @@
 #include "px_player.h"
 #include "physics/px.h"
 #include "physics/px_object.h"
+#include "physics/px_query.h"
 #include "physics/px_ray.h"
 
 #include "core/log.h"
 
 
+#define PX_PLAYER_MAX_CONTACTS  4
+#define PX_PLAYER_WALL_NORMAL   0.1   // max |normal.y| of wall contact
+#define PX_PLAYER_GROUND_NORMAL 0.7   // min |normal.y| of ground / ceiling contact
+#define PX_PLAYER_STEP_HEIGHT   0.1   // contacts below are floor edges, not walls
+#define PX_PLAYER_MAX_TARGETS   8
+
+
+/*
+    Player queries only geoms near its capsule (`px_collide_geom`): static
+    quadtree is walked down to blocks overlapping the capsule, so cost
+    doesn't grow with scene size. Player's own geom is left out of
+    broadphase (PXCAT_PLAYER, empty collide mask), all its tests go through
+    probe: static world & items block it, trigger volumes it overlaps are
+    only collected (`px_player_get_triggers`). Interaction ray is a
+    `px_raycast`.
+*/
 static struct PxPlayer {
-    dSpaceID space;
     PxObject* obj;
+    dGeomID probe;          // capsule of player size in no space, for ground & move tests
     PxRay* interact_ray;
+    cvector(PxObject*) triggers;  // overlapped by probe on last update
 
     bool is_grounded;
     bool is_ceiled;
-    bool near_wall;
+
+    vec2 slide;             // horizontal move being clipped by walls
+    f32 feet_y;             // of probe, ODE space
 
     f32 y_offset;
 } self = {};
@@ -23,24 +43,29 @@ static struct PxPlayer {
 
 void px_player_init(vec3 pos, vec3 rot, f32 width, f32 height) {
     self.y_offset = height / 2;
-    
-    self.space = px_get_space();
+
     self.obj = px_kinematic_create(
         PXBODY_CAPSULE,
         (vec3){pos[0], pos[1] + self.y_offset, pos[2]},
         rot,
         (vec3){width / 2, height, 0.0}
     );
+    self.probe = dCreateCapsule(0, width / 2, height - width / 2);
+    dGeomSetCategoryBits(self.probe, PXCAT_PLAYER);
+    dGeomSetCollideBits(self.probe, PXCAT_STATIC | PXCAT_ITEM);
     self.interact_ray = px_ray_new(2.0);
 }
 
 void px_player_destroy() {
+    dGeomDestroy(self.probe);
     px_ray_free(self.interact_ray);
+    cvector_free(self.triggers);
 }
 
 bool px_player_get_grounded()  { return self.is_grounded; }
 bool px_player_get_ceiled()    { return self.is_ceiled; }
 cvector(PxRayTarget) px_player_get_interact_target() { return self.interact_ray->targets; }
+cvector(PxObject*) px_player_get_triggers() { return self.triggers; }
 
 void px_player_set_position(vec3 pos) {
     px_kinematic_set_position(
@@ -53,129 +78,105 @@ void px_player_set_interact_ray(vec3 pos, vec3 dir) {
     px_ray_set(self.interact_ray, pos, dir);
 }
 
+static inline
+dGeomID _other_geom(dGeomID query, dGeomID geom1, dGeomID geom2) {
+    return geom1 == query ? geom2 : geom1;
+}
+
+/* Pairs come also from triggers (their mask has PXCAT_PLAYER), only geoms
+   of probe's collide mask block it */
+static inline
+bool _is_solid(dGeomID geom) {
+    return dGeomGetCategoryBits(geom) & dGeomGetCollideBits(self.probe);
+}
+
 /* ------------------------------------------------------------------------- */
 
+// Contacts of probe at destination: horizontal move is projected onto
+// every wall it runs into, so player slides along walls instead of stopping
 static
-void _wall_collision_callback(void* data, dGeomID geom1, dGeomID geom2) {
-    dGeomID player_geom = self.obj->geom;
+void _slide_callback(void* data, dGeomID geom1, dGeomID geom2) {
+    dGeomID other = _other_geom(self.probe, geom1, geom2);
+    if (!_is_solid(other))  return;
 
-    if (geom1 != player_geom && geom2 != player_geom)  return;
-    
-    dGeomID wall_geom = (geom1 == player_geom ? geom2 : geom1);
+    dContactGeom contacts[PX_PLAYER_MAX_CONTACTS];
+    int n = dCollide(self.probe, other, PX_PLAYER_MAX_CONTACTS, contacts, sizeof(dContactGeom));
 
-    if (wall_geom == self.interact_ray->geom)  return;
+    for (int i = 0; i < n; i++) {
+        dContactGeom* contact = &contacts[i];
+        if (fabs(contact->normal[2]) > PX_PLAYER_WALL_NORMAL)               continue;
+        if (contact->pos[2] - self.feet_y <= PX_PLAYER_STEP_HEIGHT)          continue;
 
-    vec3 player_pos;
-    px_kinematic_get_position(self.obj, player_pos);
-
-    dContactGeom contact;
-    int n = dCollide(player_geom, wall_geom, 1, &contact, sizeof(dContactGeom));
-    if (n > 0) {
-        f32 normal_y = contact.normal[2];
-        f32 pos_y = contact.pos[2];
-        f32 player_pos_y = player_pos[1];
+        // Normal pushes probe out of wall, engine XZ is ODE (x, -y)
+        vec2 normal = {contact->normal[0], -contact->normal[1]};
+        if (glm_vec2_norm2(normal) < 1e-6)  continue;
+        glm_vec2_normalize(normal);
 
-        bool contact_near_floor = (pos_y - (player_pos_y - 1.7 / 2)) > 0.1;
+        f32 into = glm_vec2_dot(self.slide, normal);
+        if (into >= 0.0)  continue;
 
-        if (normal_y > -0.1 && normal_y < 0.1 && contact_near_floor) {
-            self.near_wall = true;
-        }
+        vec2 clip;
+        glm_vec2_scale(normal, into, clip);
+        glm_vec2_sub(self.slide, clip, self.slide);
     }
 }
 
-static inline
-bool _check_wall_collision(vec3 orig_pos, vec3 test_pos) {
-    // Move body to test position
-    dBodySetPosition(self.obj->body, test_pos[0], -test_pos[2], test_pos[1]);
-
-    // Check for collisions
-    self.near_wall = false;
-    dSpaceCollide(self.space, 0, _wall_collision_callback);
-    
-    // Restore original positions
-    dBodySetPosition(self.obj->body, orig_pos[0], -orig_pos[2], orig_pos[1]);
-    return self.near_wall;
-}
-
 void px_player_translate(vec3 dest_pos) {
-    vec3 orig_pos, x_test_pos, z_test_pos;
-
+    vec3 orig_pos;
     px_kinematic_get_position(self.obj, orig_pos);
-    glm_vec3_copy(orig_pos, x_test_pos);
-    glm_vec3_copy(orig_pos, z_test_pos);
-    x_test_pos[0] += dest_pos[0];
-    z_test_pos[2] += dest_pos[2];
-
-    if (_check_wall_collision(orig_pos, x_test_pos))
-        dest_pos[0] = 0.0f;
-    
-    if (_check_wall_collision(orig_pos, z_test_pos))
-        dest_pos[2] = 0.0f;
-}
 
-/* ------------------------------------------------------------------------- */
+    self.slide[0] = dest_pos[0];
+    self.slide[1] = dest_pos[2];
+    self.feet_y = orig_pos[1] - self.y_offset;
 
-static inline
-void on_px_player_interact_ray_collision(dGeomID geom) {
-    PxObject* obj = px_get_object_by_geom(geom);
-    if (!obj) return;
-    
-    vec3 obj_pos;
-    vec3 ray_pos;
-    vec3 v_dist;
-
-    if (obj->body)  px_rigid_get_position(obj, obj_pos);
-    else            px_static_get_position(obj, obj_pos);
-    
-    px_ray_get(self.interact_ray, ray_pos, NULL);
-
-    glm_vec3_sub(ray_pos, obj_pos, v_dist);
-    f64 dist = cbrt(fabs(v_dist[0] * v_dist[1] * v_dist[2]));
-
-    PxRayTarget ray_target;
-    ray_target.obj = obj;
-    ray_target.dist = dist;
-    px_ray_add_target(self.interact_ray, ray_target);
-}
+    dGeomSetPosition(self.probe, orig_pos[0] + dest_pos[0], -(orig_pos[2] + dest_pos[2]), orig_pos[1]);
+    px_collide_geom(self.probe, NULL, _slide_callback);
 
+    dest_pos[0] = self.slide[0];
+    dest_pos[2] = self.slide[1];
+}
 
-// TODO unify with collision logic above
+/* ------------------------------------------------------------------------- */
 
 static
-void on_px_player_collision(void* _, dGeomID geom1, dGeomID geom2) {
-    dGeomID player_geom = self.obj->geom;
-    dGeomID interact_geom = self.interact_ray->geom;
-    
-    if (geom1 == interact_geom || geom2 == interact_geom) {
-        dGeomID other_geom = (geom1 == interact_geom ? geom2 : geom1);
-        if (other_geom == player_geom)  return;
-
-        on_px_player_interact_ray_collision(other_geom);
-    }
-
-    if (geom1 != player_geom && geom2 != player_geom)  return;
-    
-    dGeomID other_geom = (geom1 == player_geom ? geom2 : geom1);
+void _ground_callback(void* _, dGeomID geom1, dGeomID geom2) {
+    dGeomID other = _other_geom(self.probe, geom1, geom2);
+    bool is_trigger = dGeomGetCategoryBits(other) & PXCAT_TRIGGER;
+    if (!is_trigger && !_is_solid(other))  return;
 
     dContactGeom contact;
-    int n = dCollide(player_geom, other_geom, 1, &contact, sizeof(dContactGeom));
-    if (n > 0) {
-        f32 normal_y = contact.normal[2];
-        f32 pos_y = contact.pos[2];
-        
-        if (contact.normal[2] > 0.7) {
-            self.is_grounded = true;
-        }
-        else if (contact.normal[2] < -0.7) {
-            self.is_ceiled = true;
-        }
+    int n = dCollide(self.probe, other, 1, &contact, sizeof(dContactGeom));
+    if (n == 0)  return;
+
+    if (is_trigger) {
+        cvector_push_back(self.triggers, px_get_object_by_geom(other));
+    }
+    else if (contact.normal[2] > PX_PLAYER_GROUND_NORMAL) {
+        self.is_grounded = true;
+    }
+    else if (contact.normal[2] < -PX_PLAYER_GROUND_NORMAL) {
+        self.is_ceiled = true;
     }
 }
 
 void px_player_update() {
     self.is_grounded = false;
     self.is_ceiled = false;
+    cvector_clear(self.triggers);
     px_ray_clear_targets(self.interact_ray);
 
-    dSpaceCollide(self.space, 0, on_px_player_collision);
+    vec3 pos;
+    px_kinematic_get_position(self.obj, pos);
+    px_set_focus(pos);
+
+    dGeomSetPosition(self.probe, pos[0], -pos[2], pos[1]);
+    px_collide_geom(self.probe, NULL, _ground_callback);
+
+    PxRay* ray = self.interact_ray;
+    PxHit hits[PX_PLAYER_MAX_TARGETS];
+    u32 count = px_raycast(ray->pos, ray->dir, ray->len, self.obj, hits, PX_PLAYER_MAX_TARGETS);
+
+    for (u32 i = 0; i < count; i++) {
+        px_ray_add_target(ray, (PxRayTarget){.obj = hits[i].obj, .dist = hits[i].dist});
+    }
 }
@@ -12,6 +12,8 @@ void px_player_destroy();
 bool px_player_get_grounded();
 bool px_player_get_ceiled();
 PxRayTarget* px_player_get_interact_target();
+/* Trigger volumes overlapped by player on last update */
+PxObject** px_player_get_triggers();
 
 void px_player_set_position(vec3 pos);
 void px_player_set_interact_ray(vec3 pos, vec3 dir);
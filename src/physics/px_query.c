@@ -0,0 +1,360 @@
+#include <float.h>
+#include <stdlib.h>
+
+#include <ode/ode.h>
+#include <cvector.h>
+
+#include "px_query.h"
+#include "physics/px.h"
+
+#include "world/bvh.h"
+
+#define RCOMP  (M_PI / 180.0)
+
+#define PX_QUERY_MARGIN      0.1   // fat bounds, moving bodies are rarely reinserted
+#define PX_QUERY_CANDIDATES  256   // on stack, more are queried again into heap
+#define PX_QUERY_CONTACTS    4
+#define PX_SPHERE_CAST_REFINE  8   // bisection steps after first overlapping sample
+
+
+static struct PxQuery {
+    Bvh bvh;
+    PxObject** objects;     // cvector, by leaf data (slot), NULL if free
+    u32* free_slots;        // cvector
+} self = {};
+
+static _Thread_local bool thread_ready = false;
+
+
+/* ODE keeps per-thread collision data, query threads may be any threads */
+static inline
+void _thread_init() {
+    if (thread_ready)  return;
+
+    dAllocateODEDataForThread(dAllocateMaskAll);
+    thread_ready = true;
+}
+
+/* ODE AABB (min/max pairs per axis) to engine space bounds */
+static inline
+void _geom_bounds(dGeomID geom, Bounds* dest) {
+    dReal aabb[6];
+    dGeomGetAABB(geom, aabb);
+
+    vec3 min = {aabb[0], aabb[4], -aabb[3]};
+    vec3 max = {aabb[1], aabb[5], -aabb[2]};
+    glm_vec3_center(min, max, dest->center);
+    glm_vec3_sub(max, dest->center, dest->extent);
+}
+
+static inline
+void _to_engine(const dReal* v, vec3 dest) {
+    dest[0] = v[0];
+    dest[1] = v[2];
+    dest[2] = -v[1];
+}
+
+static inline
+bool _accepts_query(PxObject* obj, PxObject* ignore) {
+    return obj != ignore && (obj->collide & PXCAT_RAY);
+}
+
+/* Candidates into `stack`, or heap buffer (to be freed) if there are more */
+static
+u32* _candidates(const BvhShape* shape, u32* stack, u32* count) {
+    *count = bvh_query(&self.bvh, shape, stack, PX_QUERY_CANDIDATES);
+    if (*count <= PX_QUERY_CANDIDATES)  return stack;
+
+    u32* heap = malloc(sizeof(u32) * *count);
+    bvh_query(&self.bvh, shape, heap, *count);
+    return heap;
+}
+
+/* Insert keeping `hits` sorted, farthest hit falls out when full */
+static inline
+void _add_hit(PxHit* hits, u32* count, u32 max, PxHit* hit) {
+    if (*count == max && (max == 0 || hits[max - 1].dist <= hit->dist))  return;
+
+    u32 i = *count < max ? (*count)++ : max - 1;
+    while (i > 0 && hits[i - 1].dist > hit->dist) {
+        hits[i] = hits[i - 1];
+        i--;
+    }
+    hits[i] = *hit;
+}
+
+static inline
+void _set_hit(PxHit* hit, PxObject* obj, f32 dist, dContactGeom* contact, const vec3 facing) {
+    hit->obj = obj;
+    hit->dist = dist;
+    _to_engine(contact->pos, hit->pos);
+    _to_engine(contact->normal, hit->normal);
+
+    if (glm_vec3_dot(hit->normal, (f32*)facing) > 0.0)
+        glm_vec3_negate(hit->normal);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void px_query_init() {
+    bvh_init(&self.bvh, PX_QUERY_MARGIN);
+    self.objects = NULL;
+    self.free_slots = NULL;
+}
+
+void px_query_destroy() {
+    bvh_free(&self.bvh);
+    cvector_free(self.objects);
+    cvector_free(self.free_slots);
+}
+
+void px_query_insert(PxObject* obj) {
+    u32 slot;
+    if (!cvector_empty(self.free_slots)) {
+        slot = *cvector_back(self.free_slots);
+        cvector_pop_back(self.free_slots);
+        self.objects[slot] = obj;
+    }
+    else {
+        slot = cvector_size(self.objects);
+        cvector_push_back(self.objects, obj);
+    }
+
+    Bounds bounds;
+    _geom_bounds(obj->geom, &bounds);
+    obj->proxy = bvh_insert(&self.bvh, &bounds, slot);
+}
+
+void px_query_remove(PxObject* obj) {
+    u32 slot = self.bvh.nodes[obj->proxy].data;
+    self.objects[slot] = NULL;
+    cvector_push_back(self.free_slots, slot);
+
+    bvh_remove(&self.bvh, obj->proxy);
+}
+
+void px_query_move(PxObject* obj) {
+    Bounds bounds;
+    _geom_bounds(obj->geom, &bounds);
+    bvh_move(&self.bvh, obj->proxy, &bounds);
+}
+
+/* ------ Raycast ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+u32 _raycast(dGeomID ray, const PxRayQuery* query, PxObject* ignore, PxHit* hits, u32 max) {
+    vec3 dir;
+    glm_vec3_normalize_to((f32*)query->dir, dir);
+
+    dGeomRaySetLength(ray, query->max_dist);
+    dGeomRaySet(
+        ray,
+        query->origin[0], -query->origin[2], query->origin[1],
+        dir[0], -dir[2], dir[1]
+    );
+
+    BvhShape shape;
+    bvh_shape_ray(&shape, (f32*)query->origin, dir, query->max_dist);
+
+    u32 stack[PX_QUERY_CANDIDATES];
+    u32 count;
+    u32* candidates = _candidates(&shape, stack, &count);
+    u32 found = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.objects[candidates[i]];
+        if (!_accepts_query(obj, ignore))  continue;
+
+        dContactGeom contact;
+        if (dCollide(ray, obj->geom, 1, &contact, sizeof(dContactGeom)) == 0)  continue;
+
+        PxHit hit;
+        _set_hit(&hit, obj, contact.depth, &contact, dir);
+        _add_hit(hits, &found, max, &hit);
+    }
+
+    if (candidates != stack)  free(candidates);
+    return found;
+}
+
+static inline
+dGeomID _ray_new() {
+    dGeomID ray = dCreateRay(0, 1.0);
+    dGeomRaySetClosestHit(ray, 1);
+    return ray;
+}
+
+u32 px_raycast(vec3 origin, vec3 dir, f32 max_dist, PxObject* ignore, PxHit* hits, u32 max) {
+    _thread_init();
+
+    PxRayQuery query = {.max_dist = max_dist};
+    glm_vec3_copy(origin, query.origin);
+    glm_vec3_copy(dir, query.dir);
+
+    dGeomID ray = _ray_new();
+    u32 found = _raycast(ray, &query, ignore, hits, max);
+    dGeomDestroy(ray);
+
+    return found;
+}
+
+u32 px_raycast_batch(const PxRayQuery* rays, u32 count, PxObject* ignore, PxHit* hits, u32 max_per_ray, u32* counts) {
+    _thread_init();
+
+    dGeomID ray = _ray_new();
+    u32 total = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        counts[i] = _raycast(ray, &rays[i], ignore, hits + (u64)i * max_per_ray, max_per_ray);
+        total += counts[i];
+    }
+
+    dGeomDestroy(ray);
+    return total;
+}
+
+/* ------ Sphere cast ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+bool _sphere_overlaps(dGeomID sphere, dGeomID geom, const vec3 origin, const vec3 dir, f32 t, dContactGeom* contact) {
+    dGeomSetPosition(
+        sphere,
+        origin[0] + dir[0] * t, -(origin[2] + dir[2] * t), origin[1] + dir[1] * t
+    );
+    return dCollide(sphere, geom, 1, contact, sizeof(dContactGeom)) > 0;
+}
+
+u32 px_sphere_cast(vec3 origin, f32 radius, vec3 dir, f32 max_dist, PxObject* ignore, PxHit* hits, u32 max) {
+    _thread_init();
+
+    vec3 dir_;
+    glm_vec3_normalize_to(dir, dir_);
+
+    // Swept sphere bounds, exact test samples positions along segment
+    vec3 end, min, max_;
+    glm_vec3_scale(dir_, max_dist, end);
+    glm_vec3_add(origin, end, end);
+    glm_vec3_minv(origin, end, min);
+    glm_vec3_maxv(origin, end, max_);
+    glm_vec3_subs(min, radius, min);
+    glm_vec3_adds(max_, radius, max_);
+
+    BvhShape shape = {.type = BVH_SHAPE_AABB};
+    glm_vec3_center(min, max_, shape.box.center);
+    glm_vec3_sub(max_, shape.box.center, shape.box.extent);
+
+    u32 stack[PX_QUERY_CANDIDATES];
+    u32 count;
+    u32* candidates = _candidates(&shape, stack, &count);
+
+    dGeomID sphere = dCreateSphere(0, radius);
+    f32 step = radius * 0.5;
+    u32 found = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.objects[candidates[i]];
+        if (!_accepts_query(obj, ignore))  continue;
+
+        // Only part of segment where sphere can touch geom bounds is sampled
+        Bounds bounds;
+        _geom_bounds(obj->geom, &bounds);
+        glm_vec3_adds(bounds.extent, radius, bounds.extent);
+
+        f32 t_near = 0.0, t_far = max_dist;
+        for (int a = 0; a < 3; a++) {
+            f32 lo = bounds.center[a] - bounds.extent[a] - origin[a];
+            f32 hi = bounds.center[a] + bounds.extent[a] - origin[a];
+            if (fabsf(dir_[a]) < 1e-8) {
+                if (lo > 0.0 || hi < 0.0)  t_near = FLT_MAX;
+                continue;
+            }
+            f32 t0 = lo / dir_[a], t1 = hi / dir_[a];
+            t_near = fmaxf(t_near, fminf(t0, t1));
+            t_far = fminf(t_far, fmaxf(t0, t1));
+        }
+        if (t_near > t_far)  continue;
+
+        // First overlapping sample, then bisect between it and last free one
+        dContactGeom contact;
+        f32 free_t = t_near, hit_t = -1.0;
+
+        for (f32 t = t_near; ; t = fminf(t + step, t_far)) {
+            if (_sphere_overlaps(sphere, obj->geom, origin, dir_, t, &contact)) {
+                hit_t = t;
+                break;
+            }
+            free_t = t;
+            if (t >= t_far)  break;
+        }
+        if (hit_t < 0.0)  continue;
+
+        dContactGeom refined = contact;
+        if (hit_t > free_t) {
+            for (int r = 0; r < PX_SPHERE_CAST_REFINE; r++) {
+                f32 mid = (free_t + hit_t) * 0.5;
+                if (_sphere_overlaps(sphere, obj->geom, origin, dir_, mid, &contact)) {
+                    hit_t = mid;
+                    refined = contact;
+                }
+                else {
+                    free_t = mid;
+                }
+            }
+        }
+
+        PxHit hit;
+        _set_hit(&hit, obj, hit_t, &refined, dir_);
+        _add_hit(hits, &found, max, &hit);
+    }
+
+    dGeomDestroy(sphere);
+    if (candidates != stack)  free(candidates);
+    return found;
+}
+
+/* ------ Overlap ------ */
+/* ------------------------------------------------------------------------- */
+
+u32 px_overlap_box(vec3 center, vec3 size, vec3 rot, PxObject* ignore, PxHit* hits, u32 max) {
+    _thread_init();
+
+    dGeomID box = dCreateBox(0, size[0], size[2], size[1]);
+    dGeomSetPosition(box, center[0], -center[2], center[1]);
+    dMatrix3 R;
+    dRFromEulerAngles(R, rot[0]*RCOMP, rot[2]*RCOMP, rot[1]*RCOMP);
+    dGeomSetRotation(box, R);
+
+    BvhShape shape = {.type = BVH_SHAPE_AABB};
+    _geom_bounds(box, &shape.box);
+
+    u32 stack[PX_QUERY_CANDIDATES];
+    u32 count;
+    u32* candidates = _candidates(&shape, stack, &count);
+    u32 found = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        PxObject* obj = self.objects[candidates[i]];
+        if (!_accepts_query(obj, ignore))  continue;
+
+        dContactGeom contacts[PX_QUERY_CONTACTS];
+        int n = dCollide(box, obj->geom, PX_QUERY_CONTACTS, contacts, sizeof(dContactGeom));
+        if (n == 0)  continue;
+
+        // Deepest contact stands for overlap
+        dContactGeom* deepest = &contacts[0];
+        for (int c = 1; c < n; c++) {
+            if (contacts[c].depth > deepest->depth)  deepest = &contacts[c];
+        }
+
+        PxHit hit;
+        _set_hit(&hit, obj, 0.0, deepest, (vec3){0.0, 0.0, 0.0});
+        hit.dist = glm_vec3_distance(center, hit.pos);
+        _add_hit(hits, &found, max, &hit);
+    }
+
+    dGeomDestroy(box);
+    if (candidates != stack)  free(candidates);
+    return found;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cglm/cglm.h>
+
+#include "physics/px_object.h"
+
+#include "core/types.h"
+
+/*
+    Immediate queries: candidates come from BVH over geom bounds (kept by
+    px on add / move / delete and after each step batch), exact tests run
+    against private query geoms in no space, simulation space is never
+    touched. Queries only read shared state, so any number may run in
+    parallel (batches split across threads), but like other direct ODE
+    access only within sync window (see px.h).
+
+    Only objects with PXCAT_RAY in collide mask are found. Hits are sorted
+    by distance, up to `max` nearest are written.
+*/
+
+typedef struct PxHit {
+    PxObject* obj;
+    f32 dist;       // along cast, from box center for overlaps
+    vec3 pos;
+    vec3 normal;    // facing query
+} PxHit;
+
+typedef struct PxRayQuery {
+    vec3 origin;
+    vec3 dir;
+    f32 max_dist;
+} PxRayQuery;
+
+
+u32 px_raycast(vec3 origin, vec3 dir, f32 max_dist, PxObject* ignore, PxHit* hits, u32 max);
+/* Hits of ray `i` are `hits[i * max_per_ray ...]`, their count is `counts[i]`, returns total */
+u32 px_raycast_batch(const PxRayQuery* rays, u32 count, PxObject* ignore, PxHit* hits, u32 max_per_ray, u32* counts);
+/* Sphere swept from `origin` along `dir` */
+u32 px_sphere_cast(vec3 origin, f32 radius, vec3 dir, f32 max_dist, PxObject* ignore, PxHit* hits, u32 max);
+u32 px_overlap_box(vec3 center, vec3 size, vec3 rot, PxObject* ignore, PxHit* hits, u32 max);
+
+/* --- Query BVH, maintained by px --- */
+void px_query_init();
+void px_query_destroy();
+void px_query_insert(PxObject* obj);
+void px_query_remove(PxObject* obj);
+void px_query_move(PxObject* obj);
@@ -1,5 +1,4 @@
 #pragma once
-#include <ode/ode.h>
 #include "cglm/cglm.h"
 #include <cvector.h>
 #include <cvector_utils.h>
@@ -14,8 +13,11 @@ typedef struct {
     f64 dist;
 } PxRayTarget;
 
+/* Plain ray, cast through `px_raycast` (no geom in simulation space) */
 typedef struct {
-    dGeomID geom;
+    vec3 pos;
+    vec3 dir;
+    f32 len;
     cvector(PxRayTarget) targets;
 } PxRay;
 
@@ -25,4 +27,4 @@ void px_ray_free(PxRay*);
 void px_ray_set(PxRay*, vec3 pos, vec3 dir);
 void px_ray_get(PxRay*, vec3 dest_pos, vec3 dest_dir);
 void px_ray_add_target(PxRay*, PxRayTarget target);
-void px_ray_clear_targets(PxRay*);
\ No newline at end of file
+void px_ray_clear_targets(PxRay*);
@@ -21,6 +21,8 @@ static struct Input {
     // Mouse cursor delta
     f64 mouse_dx;
     f64 mouse_dy;
+    // Time of the most recent mouse sample
+    f64 sample_time;
 
     // Storage for key pressing state
     int keyp_storage[KEYP_STORAGE_SIZE];
@@ -33,6 +35,7 @@ void input_init() {
     glfwGetCursorPos(self.window, &self.mouse_px, &self.mouse_py);
     self.mouse_dx = 0.0;
     self.mouse_dy = 0.0;
+    self.sample_time = glfwGetTime();
 
     for (int i = 0; i < KEYP_STORAGE_SIZE; i++) {
         self.keyp_storage[i] = __KEY_EMPTY;
@@ -59,6 +62,29 @@ void input_update() {
 
     self.mouse_px = new_px;
     self.mouse_py = new_py;
+    self.sample_time = glfwGetTime();
+}
+
+
+/* Late mouse sample: returns delta accumulated since the last sample
+   and moves the baseline, so next `input_update` won't count it twice
+*/
+void input_resample_mouse(vec2 dest) {
+    double new_px, new_py;
+
+    glfwPollEvents();
+    glfwGetCursorPos(self.window, &new_px, &new_py);
+
+    dest[0] = (new_px - self.mouse_px) / Config.WINDOW_WIDTH;
+    dest[1] = (new_py - self.mouse_py) / Config.WINDOW_HEIGHT;
+
+    self.mouse_px = new_px;
+    self.mouse_py = new_py;
+    self.sample_time = glfwGetTime();
+}
+
+f64 input_get_sample_time() {
+    return self.sample_time;
 }
 
 
@@ -2,6 +2,7 @@
 #include <cglm/cglm.h>
 
 #include "platform/input_keys.h"
+#include "core/types.h"
 
 
 void input_init();
@@ -11,5 +12,7 @@ void input_update();
 bool input_is_keyp(int key);
 bool input_is_keyrp(int key);
 void input_get_mouse_delta(vec2 dest);
+void input_resample_mouse(vec2 dest);
+f64 input_get_sample_time();
 bool cursor_is_visible();
 void cursor_set_visible(bool visible);
@@ -0,0 +1,1486 @@
+/*
+    bench.c -- Engine Micro-Benchmarks
+
+    Usage: ./interlope-bench <name> [iterations]
+
+    * gltf ..... import every .glb in meshes directory into GPU-ready buffers,
+                 reports throughput of produced vertex/index data (MB/s)
+    * db ....... load synthetic scene with 100k object refs with cJSON DOM
+                 (reference), streaming JSON loader and binary snapshot,
+                 reports load & free time of each
+    * refs ..... iterate 1M object refs stored as map of heap structs (as scene
+                 used to) and as dense SoA columns, reports scan & transform time
+                 and cost of flushing cached matrices of static & moving refs
+    * mats ..... build 1M model matrices with `cgm_model_mat` one by one, with
+                 scalar batch path and with SIMD batch path, checks both batch
+                 paths against `cgm_model_mat`
+    * bvh ...... build BVH over 100k boxes (then move & remove part of them),
+                 run box, sphere, frustum & ray queries through BVH and by
+                 scanning all bounds, checks that both find the same refs
+    * px ....... 50k static physics boxes with interaction ray sweeping through
+                 them, reports collide time and geom -> PxObject -> ref lookups
+                 by back-references against scanning all objects (as before),
+                 player controller cost with 5k and 50k statics (should match),
+                 then 1k rigid boxes dropped on them, reports step time and
+                 broadphase pairs per step (static vs static must be 0)
+    * pxthread . 500 falling boxes with main thread work as long as physics,
+                 reports frame time stepping inline and on physics thread
+                 (ideally max of both, not sum), checks both end up the same
+    * pxquery .. 50k static physics boxes, batch of rays cast through query
+                 BVH on 1 and 4 threads and one by one through ODE broadphase
+                 (ray geom vs spaces), checks all find the same nearest hits,
+                 sanity checks sphere cast & box overlap, reports time per ray
+    * pxsleep .. 1600 boxes dropped on ground, reports step time and body
+                 counts always awake, with auto-disable and with region
+                 around corner (active radius, slower ring, rest frozen)
+    * pxstacks . 1024 independent stacks of 3 boxes stepped with 1, 2, 4 and
+                 8 ODE step threads, reports step time against thread count
+                 and checks stacks keep standing
+    * pxmasks .. items among static pillars, trigger volumes & player, reports
+                 broadphase pairs & contacts per step with every geom colliding
+                 with everything and with default category / collide masks,
+                 checks player walks through trigger and sees it
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cJSON.h>
+
+#include "assets/mesh_gltf.h"
+#include "assets/model.h"
+#include "core/atom.h"
+#include "core/config.h"
+#include "core/cgm.h"
+#include "core/containers/map.h"
+#include "core/containers/tuple.h"
+#include "core/log.h"
+#include "physics/px.h"
+#include "physics/px_object.h"
+#include "physics/px_player.h"
+#include "physics/px_query.h"
+#include "platform/file.h"
+#include "database/loader.h"
+#include "database/snapshot.h"
+#include "world/bvh.h"
+#include "world/ref_store.h"
+
+
+#define BENCH_MAX_FILES  256
+#define BENCH_PATH_LEN   256
+#define BENCH_DB_REFS    100000
+#define BENCH_REFS       1000000
+#define BENCH_MATS       1000000
+#define BENCH_MATS_EPS   1e-4  // tolerated difference from `cgm_model_mat`
+#define BENCH_BVH_BOXES  100000
+#define BENCH_BVH_SIZE   2000.0  // side of area boxes are scattered in
+#define BENCH_PX_OBJECTS 50000
+#define BENCH_PX_GRID    224     // boxes per row, 2m apart
+#define BENCH_PX_RIGID   1000
+#define BENCH_PXT_BOXES  500
+#define BENCH_PXT_GRID   20      // columns per row, boxes are stacked on columns
+#define BENCH_PXT_DT     (1.0 / 60.0)
+#define BENCH_PXQ_RAYS    20000
+#define BENCH_PXQ_THREADS 4
+#define BENCH_PXQ_HITS    4
+#define BENCH_PXS_GRID    40
+#define BENCH_PXS_SPACING 4.0
+#define BENCH_PXS_RADIUS  30.0
+#define BENCH_PXST_GRID    32
+#define BENCH_PXST_HEIGHT  3
+#define BENCH_PXST_SPACING 3.0
+#define BENCH_PXM_GRID     30
+
+
+/* ------------------------------------------------------------------------- */
+
+static inline
+f64 _now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline
+f64 _mb(u64 bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+/* Collect .glb paths relative to meshes directory */
+static
+void _find_meshes(const char* dir, const char* rel, char (*dest)[BENCH_PATH_LEN], int* count) {
+    char path[BENCH_PATH_LEN * 2];
+    snprintf(path, sizeof(path), "%s%s", dir, rel);
+
+    DIR* d = opendir(path);
+    if (!d)  return;
+
+    struct dirent* entry;
+    while ((entry = readdir(d)) && *count < BENCH_MAX_FILES) {
+        if (entry->d_name[0] == '.')  continue;
+
+        char entry_rel[BENCH_PATH_LEN];
+        snprintf(entry_rel, sizeof(entry_rel), "%s%s", rel, entry->d_name);
+        snprintf(path, sizeof(path), "%s%s", dir, entry_rel);
+
+        struct stat st;
+        if (stat(path, &st) != 0)  continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            strncat(entry_rel, "/", sizeof(entry_rel) - strlen(entry_rel) - 1);
+            _find_meshes(dir, entry_rel, dest, count);
+        }
+        else if (strstr(entry->d_name, ".glb")) {
+            strcpy(dest[(*count)++], entry_rel);
+        }
+    }
+    closedir(d);
+}
+
+/* ------ glTF Import ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void _bench_gltf(int iterations) {
+    static char files[BENCH_MAX_FILES][BENCH_PATH_LEN];
+    int files_count = 0;
+    _find_meshes(Config.DIR_MESHES, "", files, &files_count);
+
+    if (files_count == 0)  log_exit("[bench] No .glb files found in %s", Config.DIR_MESHES);
+
+    u64 vtx_bytes = 0;
+    u64 ind_bytes = 0;
+    u64 ind_bytes_u32 = 0;
+    u32 ranges = 0;
+    f64 import_time = 0.0;
+
+    for (int f = 0; f < files_count; f++) {
+        // Parsing & buffers loading is file IO, only import into engine buffers is measured
+        GLTF_Asset* gltf = gltf_open(files[f]);
+        int nodes_count = gltf_get_nodes_count(gltf);
+
+        ModelNode* nodes = calloc(nodes_count, sizeof(ModelNode));
+        ModelNode** node_ptrs = malloc(sizeof(ModelNode*) * nodes_count);
+        ModelNodeData* nodes_data = calloc(nodes_count, sizeof(ModelNodeData));
+        for (int i = 0; i < nodes_count; i++)  node_ptrs[i] = &nodes[i];
+
+        for (int it = 0; it < iterations; it++) {
+            f64 start = _now();
+            gltf_read_model_nodes(gltf, node_ptrs, nodes_data);
+            import_time += _now() - start;
+
+            for (int i = 0; i < nodes_count; i++) {
+                ModelNodeData* nd = &nodes_data[i];
+                if (!nd->vtx_buf)  continue;
+
+                vtx_bytes += nd->vtx_count * 8 * sizeof(f32);
+                ind_bytes += nd->ind_count * nd->index_size;
+                ind_bytes_u32 += nd->ind_count * sizeof(u32);
+                ranges += nd->ranges_count;
+
+                free(nd->vtx_buf);
+                free(nd->ind_buf);
+                free(nd->ranges);
+            }
+            memset(nodes_data, 0, sizeof(ModelNodeData) * nodes_count);
+        }
+
+        free(nodes_data);
+        free(node_ptrs);
+        free(nodes);
+        gltf_close(gltf);
+    }
+
+    u64 total = vtx_bytes + ind_bytes;
+    log_info("[bench] gltf: %d files x %d iterations, %d draw ranges", files_count, iterations, ranges / iterations);
+    log_info(
+        "[bench] gltf: %.2f MB in %.2f ms -> %.1f MB/s",
+        _mb(total), import_time * 1000.0, import_time > 0.0 ? _mb(total) / import_time : 0.0
+    );
+    log_info(
+        "[bench] gltf: indices %.2f MB (%.2f MB as u32, %.0f%% saved)",
+        _mb(ind_bytes), _mb(ind_bytes_u32),
+        ind_bytes_u32 > 0 ? 100.0 * (1.0 - (f64)ind_bytes / ind_bytes_u32) : 0.0
+    );
+}
+
+/* ------ Database Load ------ */
+/* ------------------------------------------------------------------------- */
+
+/* Reference: DOM walk with heap allocation per item, as loader used to work */
+
+static inline
+void _dom_vec(cJSON* json, f32* dest, int n) {
+    if (!json || !cJSON_IsArray(json) || cJSON_GetArraySize(json) < n)  return;
+    for (int i = 0; i < n; i++)  dest[i] = cJSON_GetArrayItem(json, i)->valuedouble;
+}
+
+static
+PhysicsInfo* _dom_physics(cJSON* json) {
+    PhysicsInfo* physics = calloc(1, sizeof(PhysicsInfo));
+    physics->category = physics->collide = PHCAT_DEFAULT;
+    cJSON* shape = cJSON_GetObjectItem(json, "shape");
+    if (shape && cJSON_IsString(shape))
+        physics->shape = strcmp(shape->valuestring, "BOX") == 0 ? PHSHAPE_BOX : PHSHAPE_AABB;
+    _dom_vec(cJSON_GetObjectItem(json, "size"), physics->size, 3);
+    _dom_vec(cJSON_GetObjectItem(json, "pos"), physics->pos, 3);
+    return physics;
+}
+
+static
+ObjectInfo** _dom_load_objects(const char* path) {
+    const char* content = NULL;
+    ObjectInfo** objects = NULL;
+
+    with_file_read(path, content, {
+        cJSON* root = cJSON_Parse(content);
+        int count = cJSON_GetArraySize(root);
+        objects = calloc(count + 1, sizeof(ObjectInfo*));
+
+        int i = 0;
+        cJSON* json;
+        cJSON_ArrayForEach(json, root) {
+            ObjectInfo* obj = objects[i++] = calloc(1, sizeof(ObjectInfo));
+            strncpy(obj->id, json->string, MAX_ID_LENGTH - 1);
+            obj->atom = atom_intern(obj->id);
+
+            cJSON* model = cJSON_GetObjectItem(json, "model");
+            if (!model)  model = json;
+
+            cJSON* mesh = cJSON_GetObjectItem(model, "mesh");
+            cJSON* textures = cJSON_GetObjectItem(model, "textures");
+            if (mesh) {
+                obj->model = calloc(1, sizeof(ModelInfo));
+                strncpy(obj->model->mesh, mesh->valuestring, MAX_MESH_PATH_LENGTH - 1);
+
+                int tex_count = textures ? cJSON_GetArraySize(textures) : 0;
+                obj->model->textures = calloc(tex_count, MAX_TEXTURE_PATH_LENGTH);
+                obj->model->texture_count = tex_count;
+                for (int t = 0; t < tex_count; t++)
+                    strncpy(obj->model->textures[t], cJSON_GetArrayItem(textures, t)->valuestring, MAX_TEXTURE_PATH_LENGTH - 1);
+            }
+
+            cJSON* physics = cJSON_GetObjectItem(json, "physics");
+            if (physics) {
+                int physics_count = cJSON_IsArray(physics) ? cJSON_GetArraySize(physics) : 1;
+                obj->physics = calloc(physics_count + 1, sizeof(PhysicsInfo*));
+                for (int p = 0; p < physics_count; p++)
+                    obj->physics[p] = _dom_physics(cJSON_IsArray(physics) ? cJSON_GetArrayItem(physics, p) : physics);
+            }
+        }
+        cJSON_Delete(root);
+    });
+    return objects;
+}
+
+static
+SceneInfo* _dom_load_scene(const char* path) {
+    const char* content = NULL;
+    SceneInfo* scene = calloc(1, sizeof(SceneInfo));
+
+    with_file_read(path, content, {
+        cJSON* root = cJSON_Parse(content);
+        cJSON* refs = cJSON_GetObjectItem(root, "object_refs");
+        int count = cJSON_GetArraySize(refs);
+        scene->object_refs = calloc(count + 1, sizeof(ObjectRefInfo*));
+
+        int i = 0;
+        cJSON* json;
+        cJSON_ArrayForEach(json, refs) {
+            ObjectRefInfo* ref = scene->object_refs[i++] = calloc(1, sizeof(ObjectRefInfo));
+            strncpy(ref->id, cJSON_GetObjectItem(json, "id")->valuestring, MAX_ID_LENGTH - 1);
+            ref->atom = atom_intern(ref->id);
+            _dom_vec(cJSON_GetObjectItem(json, "pos"), ref->pos, 3);
+            _dom_vec(cJSON_GetObjectItem(json, "rot"), ref->rot, 3);
+        }
+        cJSON_Delete(root);
+    });
+    return scene;
+}
+
+static
+void _dom_free(ObjectInfo** objects, SceneInfo* scene) {
+    ObjectInfo* obj;
+    tuple_for_each(obj, objects) {
+        if (obj->model)  free(obj->model->textures);
+        free(obj->model);
+
+        PhysicsInfo* physics;
+        if (obj->physics) tuple_for_each(physics, obj->physics)  free(physics);
+        free(obj->physics);
+        free(obj);
+    }
+    free(objects);
+
+    ObjectRefInfo* ref;
+    tuple_for_each(ref, scene->object_refs)  free(ref);
+    free(scene->object_refs);
+    free(scene);
+}
+
+/* Scene with refs to every known object in round-robin, scattered on grid */
+static
+void _write_synthetic_scene(const char* path, ObjectInfo** objects) {
+    FILE* f = fopen(path, "w");
+    if (!f)  log_exit("[bench] Unable to write synthetic scene: %s", path);
+
+    int objects_count = tuple_size(objects);
+    fprintf(f, "{\n  \"player_init\": {\"pos\": [0.0, 1.0, 0.0], \"rot\": [0.0, 0.0]},\n  \"object_refs\": [\n");
+
+    for (int i = 0; i < BENCH_DB_REFS; i++) {
+        fprintf(
+            f, "    {\"id\": \"%s\", \"pos\": [%.2f, 0.0, %.2f], \"rot\": [0.0, %.1f, 0.0]}%s\n",
+            objects[i % objects_count]->id, (i % 316) * 2.0, (i / 316) * 2.0, (f64)(i % 360),
+            i < BENCH_DB_REFS - 1 ? "," : ""
+        );
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+/* Walk refs the way scene init does, so lazily mapped pages are counted too */
+static inline
+f32 _touch_scene(SceneInfo* scene) {
+    f32 sum = 0.0;
+    ObjectRefInfo* ref;
+    tuple_for_each(ref, scene->object_refs) {
+        sum += ref->pos[0] + ref->rot[1] + ref->id[0];
+    }
+    return sum;
+}
+
+static
+void _bench_db(int iterations) {
+    char scene_path[BENCH_PATH_LEN];
+    char snapshot_path[BENCH_PATH_LEN];
+    snprintf(scene_path, sizeof(scene_path), "%sbench_scene.json", Config.DIR_CACHE);
+    snprintf(snapshot_path, sizeof(snapshot_path), "%sbench_scene.snapshot", Config.DIR_CACHE);
+    mkdir(Config.DIR_CACHE, 0755);
+
+    Arena* arena = arena_new();
+    ObjectInfo** objects = db_load_objects_data(arena, Config.PATH_OBJECTS_DATA);
+    if (!objects)  log_exit("[bench] Unable to load objects data: %s", Config.PATH_OBJECTS_DATA);
+
+    _write_synthetic_scene(scene_path, objects);
+
+    SceneInfo* scene = db_load_scene_data(arena, scene_path);
+    SceneInfo* scenes[] = {scene, NULL};
+    db_snapshot_write(snapshot_path, objects, scenes, 0);
+    arena_free(arena);
+
+    f64 dom_load = 0.0, dom_free = 0.0;
+    f64 json_load = 0.0, json_free = 0.0;
+    f64 snap_load = 0.0, snap_free = 0.0;
+    f32 dom_sum = 0.0, json_sum = 0.0, snap_sum = 0.0;
+
+    for (int it = 0; it < iterations; it++) {
+        /* --- cJSON DOM --- */
+        f64 start = _now();
+        objects = _dom_load_objects(Config.PATH_OBJECTS_DATA);
+        scene = _dom_load_scene(scene_path);
+        dom_sum += _touch_scene(scene);
+        dom_load += _now() - start;
+
+        start = _now();
+        _dom_free(objects, scene);
+        dom_free += _now() - start;
+
+        /* --- Streaming JSON --- */
+        start = _now();
+        arena = arena_new();
+        objects = db_load_objects_data(arena, Config.PATH_OBJECTS_DATA);
+        scene = db_load_scene_data(arena, scene_path);
+        json_sum += _touch_scene(scene);
+        json_load += _now() - start;
+
+        start = _now();
+        arena_free(arena);
+        json_free += _now() - start;
+
+        /* --- Snapshot --- */
+        start = _now();
+        if (!db_snapshot_open(snapshot_path))  log_exit("[bench] Unable to open snapshot: %s", snapshot_path);
+        scene = db_snapshot_find_scene("bench_scene");
+        snap_sum += _touch_scene(scene);
+        snap_load += _now() - start;
+
+        start = _now();
+        db_snapshot_close();
+        snap_free += _now() - start;
+    }
+
+    if (dom_sum != json_sum || json_sum != snap_sum)  log_error("[bench] db: loaded data differs");
+
+    log_info("[bench] db: %d refs x %d iterations", BENCH_DB_REFS, iterations);
+    log_info(
+        "[bench] db: cJSON    load %.2f ms, free %.2f ms",
+        dom_load * 1000.0 / iterations, dom_free * 1000.0 / iterations
+    );
+    log_info(
+        "[bench] db: stream   load %.2f ms, free %.2f ms (%.1fx faster load)",
+        json_load * 1000.0 / iterations, json_free * 1000.0 / iterations,
+        json_load > 0.0 ? dom_load / json_load : 0.0
+    );
+    log_info(
+        "[bench] db: snapshot load %.2f ms, free %.2f ms (%.1fx faster load)",
+        snap_load * 1000.0 / iterations, snap_free * 1000.0 / iterations,
+        snap_load > 0.0 ? dom_load / snap_load : 0.0
+    );
+}
+
+/* ------ Object Refs Iteration ------ */
+/* ------------------------------------------------------------------------- */
+
+/* Heap-allocated ref as scene stored it before SoA columns */
+typedef struct LegacyRef {
+    u32 ref_id;
+    void* obj;
+    vec3 position;
+    vec3 rotation;
+    vec3* node_positions;
+    vec3* node_rotations;
+    void** physics;
+    bool is_loaded;
+} LegacyRef;
+
+static inline
+void _ref_transform(u32 i, vec3 pos, vec3 rot) {
+    glm_vec3_copy((vec3){(i % 1000) * 2.0, 0.0, (i / 1000) * 2.0}, pos);
+    glm_vec3_copy((vec3){0.0, (f32)(i % 360), 0.0}, rot);
+}
+
+static
+void _bench_refs(int iterations) {
+    /* --- Map of heap structs --- */
+    map(LegacyRef) legacy = map_new(MHASH_INT);
+    for (u32 i = 0; i < BENCH_REFS; i++) {
+        LegacyRef* ref = calloc(1, sizeof(LegacyRef));
+        ref->ref_id = i + 1;
+        _ref_transform(i, ref->position, ref->rotation);
+        map_set(legacy, ref, (void*)(u64)ref->ref_id);
+    }
+
+    /* --- SoA columns --- */
+    RefStore store;
+    ref_store_init(&store);
+    for (u32 i = 0; i < BENCH_REFS; i++) {
+        u32 slot = ref_store_add(&store);
+        _ref_transform(i, store.positions[slot], store.rotations[slot]);
+    }
+
+    f64 legacy_scan = 0.0, legacy_xform = 0.0;
+    f64 soa_scan = 0.0, soa_xform = 0.0;
+    f64 legacy_sum = 0.0, soa_sum = 0.0;  // sums of whole numbers, exact in any order
+    LegacyRef* ref;
+    mat4 m;
+
+    for (int it = 0; it < iterations; it++) {
+        f64 start = _now();
+        map_for_each(ref, legacy) {
+            legacy_sum += ref->position[0];
+        }
+        legacy_scan += _now() - start;
+
+        start = _now();
+        map_for_each(ref, legacy) {
+            cgm_model_mat(ref->position, ref->rotation, NULL, m);
+            legacy_sum += m[3][0];
+        }
+        legacy_xform += _now() - start;
+
+        start = _now();
+        for (u32 i = 0; i < store.count; i++) {
+            soa_sum += store.positions[i][0];
+        }
+        soa_scan += _now() - start;
+
+        start = _now();
+        ref_store_update_transforms(&store, 0, store.count);
+        for (u32 i = 0; i < store.count; i++) {
+            soa_sum += store.world_mats[i][3][0];
+        }
+        soa_xform += _now() - start;
+    }
+
+    if (legacy_sum != soa_sum)  log_error("[bench] refs: results differ");
+
+    log_info("[bench] refs: %d refs x %d iterations", BENCH_REFS, iterations);
+    log_info(
+        "[bench] refs: scan      map %.2f ms, soa %.2f ms (%.1fx)",
+        legacy_scan * 1000.0 / iterations, soa_scan * 1000.0 / iterations,
+        soa_scan > 0.0 ? legacy_scan / soa_scan : 0.0
+    );
+    log_info(
+        "[bench] refs: transform map %.2f ms, soa %.2f ms (%.1fx)",
+        legacy_xform * 1000.0 / iterations, soa_xform * 1000.0 / iterations,
+        soa_xform > 0.0 ? legacy_xform / soa_xform : 0.0
+    );
+
+    /* --- Cached matrices: flush of static frame and of frame moving 1% of refs --- */
+    ref_store_flush_transforms(&store);
+    f64 static_flush = 0.0, moving_flush = 0.0;
+    u32 static_updated = 0, moving_updated = 0;
+    for (int it = 0; it < iterations; it++) {
+        f64 start = _now();
+        static_updated += ref_store_flush_transforms(&store);
+        static_flush += _now() - start;
+
+        for (u32 i = it % 100; i < store.count; i += 100) {
+            ref_store_mark_dirty(&store, i);
+        }
+        start = _now();
+        moving_updated += ref_store_flush_transforms(&store);
+        moving_flush += _now() - start;
+    }
+    log_info(
+        "[bench] refs: flush     static %.3f ms (%u rebuilt), 1%% moving %.2f ms (%u rebuilt)",
+        static_flush * 1000.0 / iterations, static_updated / iterations,
+        moving_flush * 1000.0 / iterations, moving_updated / iterations
+    );
+
+    map_for_each(ref, legacy) {
+        free(ref);
+    }
+    map_free(legacy);
+    ref_store_free(&store);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static
+f64 _mats_max_error(mat4* expected, mat4* actual, u32 count) {
+    f64 max_error = 0.0;
+    for (u32 i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                max_error = max(max_error, fabs(expected[i][c][r] - actual[i][c][r]));
+            }
+        }
+    }
+    return max_error;
+}
+
+static
+void _bench_mats(int iterations) {
+    vec3* positions = malloc(sizeof(vec3) * BENCH_MATS);
+    vec3* rotations = malloc(sizeof(vec3) * BENCH_MATS);
+    vec3* scales = malloc(sizeof(vec3) * BENCH_MATS);
+    mat4* expected = aligned_alloc(32, sizeof(mat4) * BENCH_MATS);
+    mat4* actual = aligned_alloc(32, sizeof(mat4) * BENCH_MATS);
+
+    // Angles cover several turns both ways, to exercise range reduction
+    srand(1);
+    for (u32 i = 0; i < BENCH_MATS; i++) {
+        for (int k = 0; k < 3; k++) {
+            positions[i][k] = (rand() % 20000 - 10000) * 0.1f;
+            rotations[i][k] = (rand() % 2000000 - 1000000) * 0.001f;
+            scales[i][k] = 0.5f + (rand() % 100) * 0.02f;
+        }
+    }
+
+    f64 single = 0.0, scalar = 0.0, simd = 0.0;
+    f64 scalar_error = 0.0, simd_error = 0.0;
+
+    for (int it = 0; it < iterations; it++) {
+        f64 start = _now();
+        for (u32 i = 0; i < BENCH_MATS; i++) {
+            cgm_model_mat(positions[i], rotations[i], scales[i], expected[i]);
+        }
+        single += _now() - start;
+
+        start = _now();
+        cgm_model_mat_batch_scalar(positions, rotations, scales, actual, BENCH_MATS);
+        scalar += _now() - start;
+        scalar_error = max(scalar_error, _mats_max_error(expected, actual, BENCH_MATS));
+
+        start = _now();
+        cgm_model_mat_batch(positions, rotations, scales, actual, BENCH_MATS);
+        simd += _now() - start;
+        simd_error = max(simd_error, _mats_max_error(expected, actual, BENCH_MATS));
+    }
+
+    log_info("[bench] mats: %d matrices x %d iterations", BENCH_MATS, iterations);
+    log_info("[bench] mats: cgm_model_mat    %.2f ms", single * 1000.0 / iterations);
+    log_info(
+        "[bench] mats: batch scalar     %.2f ms (%.1fx), max error %.2e",
+        scalar * 1000.0 / iterations, scalar > 0.0 ? single / scalar : 0.0, scalar_error
+    );
+    log_info(
+        "[bench] mats: batch %-10s %.2f ms (%.1fx), max error %.2e",
+        cgm_simd_name(), simd * 1000.0 / iterations, simd > 0.0 ? single / simd : 0.0, simd_error
+    );
+    if (scalar_error > BENCH_MATS_EPS || simd_error > BENCH_MATS_EPS)
+        log_error("[bench] mats: batch results differ from cgm_model_mat");
+
+    free(positions);
+    free(rotations);
+    free(scales);
+    free(expected);
+    free(actual);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline
+f32 _rand_range(f32 from, f32 to) {
+    return from + (to - from) * (rand() / (f32)RAND_MAX);
+}
+
+static inline
+void _rand_box(Bounds* box) {
+    glm_vec3_copy(
+        (vec3){_rand_range(0.0, BENCH_BVH_SIZE), _rand_range(0.0, 20.0), _rand_range(0.0, BENCH_BVH_SIZE)},
+        box->center
+    );
+    glm_vec3_copy((vec3){_rand_range(0.2, 4.0), _rand_range(0.2, 4.0), _rand_range(0.2, 4.0)}, box->extent);
+}
+
+static
+u32 _scan_query(Bounds* boxes, u8* alive, u32 count, const BvhShape* shape) {
+    u32 found = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (alive[i] && bvh_shape_overlaps(shape, &boxes[i]))  found++;
+    }
+    return found;
+}
+
+static
+f32 _scan_raycast(Bounds* boxes, u8* alive, u32 count, vec3 origin, vec3 dir, f32 max_dist) {
+    f32 best = max_dist;
+    for (u32 i = 0; i < count; i++) {
+        if (!alive[i])  continue;
+
+        vec3 min, max;
+        glm_vec3_sub(boxes[i].center, boxes[i].extent, min);
+        glm_vec3_add(boxes[i].center, boxes[i].extent, max);
+
+        f32 t_near = 0.0, t_far = best;
+        for (int k = 0; k < 3; k++) {
+            f32 t0 = (min[k] - origin[k]) / dir[k];
+            f32 t1 = (max[k] - origin[k]) / dir[k];
+            t_near = fmaxf(t_near, fminf(t0, t1));
+            t_far = fminf(t_far, fmaxf(t0, t1));
+        }
+        if (t_near <= t_far)  best = t_near;
+    }
+    return best;
+}
+
+static
+void _bench_bvh(int iterations) {
+    Bounds* boxes = malloc(sizeof(Bounds) * BENCH_BVH_BOXES);
+    u32* leaves = malloc(sizeof(u32) * BENCH_BVH_BOXES);
+    u8* alive = malloc(BENCH_BVH_BOXES);
+    u32* results = malloc(sizeof(u32) * BENCH_BVH_BOXES);
+    srand(1);
+
+    /* --- Build, then move every 10th box (some a bit, some far) and remove every 7th --- */
+    Bvh bvh;
+    bvh_init(&bvh, 0.1);
+
+    f64 start = _now();
+    for (u32 i = 0; i < BENCH_BVH_BOXES; i++) {
+        _rand_box(&boxes[i]);
+        leaves[i] = bvh_insert(&bvh, &boxes[i], i);
+        alive[i] = 1;
+    }
+    f64 build = _now() - start;
+
+    start = _now();
+    for (u32 i = 0; i < BENCH_BVH_BOXES; i += 10) {
+        if (i % 20 == 0)
+            glm_vec3_add(boxes[i].center, (vec3){_rand_range(-0.5, 0.5), 0.0, _rand_range(-0.5, 0.5)}, boxes[i].center);
+        else
+            _rand_box(&boxes[i]);
+        bvh_move(&bvh, leaves[i], &boxes[i]);
+    }
+    for (u32 i = 0; i < BENCH_BVH_BOXES; i += 7) {
+        bvh_remove(&bvh, leaves[i]);
+        alive[i] = 0;
+    }
+    f64 update = _now() - start;
+
+    /* --- Queries --- */
+    BvhShape shapes[3];
+    shapes[0].type = BVH_SHAPE_AABB;
+    shapes[1].type = BVH_SHAPE_SPHERE;
+    shapes[2].type = BVH_SHAPE_FRUSTUM;
+
+    f64 bvh_time[4] = {}, scan_time[4] = {};
+    u64 hits[4] = {};
+    u32 mismatches = 0;
+
+    for (int it = 0; it < iterations; it++) {
+        vec3 eye = {_rand_range(0.0, BENCH_BVH_SIZE), 2.0, _rand_range(0.0, BENCH_BVH_SIZE)};
+        vec3 dir = {_rand_range(-1.0, 1.0), _rand_range(-0.1, 0.1), _rand_range(-1.0, 1.0)};
+        glm_vec3_normalize(dir);
+
+        glm_vec3_copy(eye, shapes[0].box.center);
+        glm_vec3_copy((vec3){30.0, 10.0, 30.0}, shapes[0].box.extent);
+        glm_vec4_copy((vec4){eye[0], eye[1], eye[2], 40.0}, shapes[1].sphere);
+
+        mat4 m_persp, m_view, m_view_proj;
+        glm_perspective(glm_rad(75.0), 16.0 / 9.0, 0.1, 150.0, m_persp);
+        glm_look(eye, dir, (vec3){0.0, 1.0, 0.0}, m_view);
+        glm_mat4_mul(m_persp, m_view, m_view_proj);
+        glm_frustum_planes(m_view_proj, shapes[2].planes);
+
+        for (int q = 0; q < 3; q++) {
+            start = _now();
+            u32 found = bvh_query(&bvh, &shapes[q], results, BENCH_BVH_BOXES);
+            bvh_time[q] += _now() - start;
+
+            start = _now();
+            u32 expected = _scan_query(boxes, alive, BENCH_BVH_BOXES, &shapes[q]);
+            scan_time[q] += _now() - start;
+
+            hits[q] += found;
+            if (found != expected)  mismatches++;
+        }
+
+        u32 data;
+        f32 dist = 500.0;
+        start = _now();
+        bool hit = bvh_raycast(&bvh, eye, dir, 500.0, &data, &dist);
+        bvh_time[3] += _now() - start;
+
+        start = _now();
+        f32 expected = _scan_raycast(boxes, alive, BENCH_BVH_BOXES, eye, dir, 500.0);
+        scan_time[3] += _now() - start;
+
+        hits[3] += hit;
+        if ((hit && fabsf(dist - expected) > 1e-3) || (!hit && expected < 500.0))  mismatches++;
+    }
+
+    const char* names[] = {"aabb", "sphere", "frustum", "ray"};
+    log_info(
+        "[bench] bvh: %d boxes, build %.2f ms, move 10%% & remove 14%% %.2f ms, %u nodes",
+        BENCH_BVH_BOXES, build * 1000.0, update * 1000.0, bvh.capacity
+    );
+    for (int q = 0; q < 4; q++) {
+        log_info(
+            "[bench] bvh: %-8s bvh %.4f ms, scan %.2f ms (%.0fx), %.1f hits avg",
+            names[q], bvh_time[q] * 1000.0 / iterations, scan_time[q] * 1000.0 / iterations,
+            bvh_time[q] > 0.0 ? scan_time[q] / bvh_time[q] : 0.0, (f64)hits[q] / iterations
+        );
+    }
+    if (mismatches)  log_error("[bench] bvh: %u queries differ from scan", mismatches);
+
+    bvh_free(&bvh);
+    free(boxes);
+    free(leaves);
+    free(alive);
+    free(results);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Player walks into box to its right among first `rows` rows, returns update & translate time per frame */
+static
+f64 _px_controller_frames(int frames, u32 rows, u32* slides) {
+    f64 time = 0.0;
+    *slides = 0;
+    px_player_update();  // files statics added since last query into quadtree
+
+    for (int it = 0; it < frames; it++) {
+        // Last column has no box to the right
+        u32 cell = (it * 7919u) % (rows * (BENCH_PX_GRID - 1));
+        vec3 pos = {(cell % (BENCH_PX_GRID - 1)) * 2.0 + 1.0, 0.0, (cell / (BENCH_PX_GRID - 1)) * 2.0};
+        vec3 move = {0.5, 0.0, 0.3};
+        px_player_set_position(pos);
+
+        f64 start = _now();
+        px_player_update();
+        px_player_translate(move);
+        time += _now() - start;
+
+        // Blocked along X, keeps moving along the wall
+        if (move[0] < 0.5 && move[2] == 0.3f)  (*slides)++;
+    }
+    return time / frames;
+}
+
+static
+void _bench_px(int iterations) {
+    Config.PHYSICS_THREADED = false;
+    Config.PHYSICS_ACTIVE_RADIUS = 0.0;  // player is parked away from boxes
+    px_init();
+
+    // As scene does on load, sized to static grid
+    f32 half = BENCH_PX_GRID;
+    px_build_static_space((vec3){half, 0.0, half}, (vec3){half + 2.0, 2.0, half + 2.0});
+
+    px_player_init((vec3){-100.0, 100.0, -100.0}, (vec3){0.0, 0.0, 0.0}, 0.4, 1.8);
+
+    // Owner ids stand for refs, object `i` is owned by ref `i + 1`
+    PxObject** objects = malloc(sizeof(PxObject*) * BENCH_PX_OBJECTS);
+    f64 controller_small = 0.0;
+    u32 slides_small = 0;
+
+    for (u32 i = 0; i < BENCH_PX_OBJECTS; i++) {
+        if (i == BENCH_PX_OBJECTS / 10)
+            controller_small = _px_controller_frames(iterations, i / BENCH_PX_GRID, &slides_small);
+
+        vec3 pos = {(i % BENCH_PX_GRID) * 2.0, 0.5, (i / BENCH_PX_GRID) * 2.0};
+        objects[i] = px_static_create(PXBODY_BOX, pos, (vec3){0.0, 0.0, 0.0}, (vec3){1.0, 1.0, 1.0});
+        objects[i]->owner = i + 1;
+    }
+
+    u32 slides = 0;
+    f64 controller = _px_controller_frames(iterations, BENCH_PX_OBJECTS / BENCH_PX_GRID, &slides);
+    log_info(
+        "[bench] px: controller %.4f ms/frame with %d statics, %.4f ms/frame with %d",
+        controller_small * 1000.0, BENCH_PX_OBJECTS / 10, controller * 1000.0, BENCH_PX_OBJECTS
+    );
+    if (slides_small != (u32)iterations || slides != (u32)iterations)
+        log_error("[bench] px: player didn't slide along wall (%u, %u of %d)", slides_small, slides, iterations);
+
+    f64 collide = 0.0, lookup = 0.0, scan = 0.0;
+    u64 targets_count = 0, owners_sum = 0, scan_owners_sum = 0;
+
+    for (int it = 0; it < iterations; it++) {
+        // Sweep along rows, ray starts between boxes and reaches next one
+        u32 cell = (it * 7919u) % BENCH_PX_OBJECTS;
+        vec3 origin = {(cell % BENCH_PX_GRID) * 2.0 - 1.4, 0.5, (cell / BENCH_PX_GRID) * 2.0};
+        px_player_set_interact_ray(origin, (vec3){1.0, 0.0, 0.0});
+
+        f64 start = _now();
+        px_player_update();
+        collide += _now() - start;
+
+        cvector(PxRayTarget) targets = px_player_get_interact_target();
+        targets_count += cvector_size(targets);
+
+        PxRayTarget* target;
+        start = _now();
+        cvector_for_each_in(target, targets) {
+            PxObject* obj = px_get_object_by_geom(target->obj->geom);
+            owners_sum += obj->owner;
+        }
+        lookup += _now() - start;
+
+        // Previous lookups: scan physics objects for geom, then refs for object
+        start = _now();
+        cvector_for_each_in(target, targets) {
+            PxObject* obj = NULL;
+            for (u32 i = 0; i < BENCH_PX_OBJECTS && !obj; i++) {
+                if (objects[i]->geom == target->obj->geom)  obj = objects[i];
+            }
+            for (u32 i = 0; i < BENCH_PX_OBJECTS; i++) {
+                if (objects[i] != obj)  continue;
+                scan_owners_sum += i + 1;
+                break;
+            }
+        }
+        scan += _now() - start;
+    }
+
+    log_info("[bench] px: %d static objects x %d frames", BENCH_PX_OBJECTS, iterations);
+    log_info(
+        "[bench] px: collide %.3f ms/frame, %.2f ray targets/frame",
+        collide * 1000.0 / iterations, (f64)targets_count / iterations
+    );
+    log_info(
+        "[bench] px: lookup  back-refs %.6f ms/frame, scan %.3f ms/frame",
+        lookup * 1000.0 / iterations, scan * 1000.0 / iterations
+    );
+    if (targets_count == 0)              log_error("[bench] px: interaction ray hit nothing");
+    if (owners_sum != scan_owners_sum)   log_error("[bench] px: lookups differ from scan");
+
+    /* --- Step rigid boxes falling on statics --- */
+    for (u32 i = 0; i < BENCH_PX_RIGID; i++) {
+        u32 cell = (i * 53u) % BENCH_PX_OBJECTS;
+        vec3 pos = {(cell % BENCH_PX_GRID) * 2.0, 1.6, (cell / BENCH_PX_GRID) * 2.0};
+        px_rigid_create(PXBODY_BOX, pos, (vec3){0.0, 0.0, 0.0}, (vec3){1.0, 1.0, 1.0}, 1.0);
+    }
+
+    f64 step = 0.0;
+    u64 steps = 0, dynamic_pairs = 0, static_pairs = 0, dropped_pairs = 0;
+
+    for (int it = 0; it < iterations; it++) {
+        f64 start = _now();
+        px_update(1.0 / 60.0);
+        step += _now() - start;
+
+        PxStats stats = px_get_stats();
+        steps += px_get_frame_steps();
+        dynamic_pairs += stats.dynamic_pairs;
+        static_pairs += stats.static_pairs;
+        dropped_pairs += stats.dropped_pairs;
+    }
+    steps = steps ? steps : 1;
+
+    log_info("[bench] px: %d rigid boxes, step %.3f ms/frame", BENCH_PX_RIGID, step * 1000.0 / iterations);
+    log_info(
+        "[bench] px: pairs/step dynamic %.1f, static %.1f, static vs static %.1f",
+        (f64)dynamic_pairs / steps, (f64)static_pairs / steps, (f64)dropped_pairs / steps
+    );
+    if (dropped_pairs)  log_error("[bench] px: broadphase generated static vs static pairs");
+
+    px_player_destroy();
+    free(objects);
+    px_destroy();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Frames of falling boxes with main thread busy for `work` sec, returns frame time */
+static
+f64 _px_thread_frames(bool threaded, int frames, f64 work, f64* physics, f64* checksum) {
+    Config.PHYSICS_THREADED = threaded;
+    Config.PHYSICS_STEP_THREADS = 0;  // islands would draw from shared RNG in any order
+    px_init();
+    dRandSetSeed(0);  // quick step shuffles constraints, runs must see same sequence
+
+    vec3 zero = {0.0, 0.0, 0.0};
+    px_static_create(PXBODY_BOX, (vec3){20.0, -0.5, 20.0}, zero, (vec3){100.0, 1.0, 100.0});
+
+    PxObject** boxes = malloc(sizeof(PxObject*) * BENCH_PXT_BOXES);
+    for (u32 i = 0; i < BENCH_PXT_BOXES; i++) {
+        u32 column = i % (BENCH_PXT_GRID * BENCH_PXT_GRID);
+        u32 level = i / (BENCH_PXT_GRID * BENCH_PXT_GRID);
+        vec3 pos = {(column % BENCH_PXT_GRID) * 2.0, 0.5 + level * 1.1, (column / BENCH_PXT_GRID) * 2.0};
+        boxes[i] = px_rigid_create(PXBODY_BOX, pos, zero, (vec3){1.0, 1.0, 1.0}, 1.0);
+    }
+
+    f64 frame_time = 0.0;
+    *physics = 0.0;
+
+    for (int f = 0; f < frames; f++) {
+        f64 start = _now();
+        px_update(BENCH_PXT_DT);
+        *physics += _now() - start;
+        px_dispatch();
+
+        // Stands for draw, physics thread steps meanwhile
+        f64 work_start = _now();
+        while (_now() - work_start < work);
+
+        frame_time += _now() - start;
+    }
+    px_update(0.0);  // publish last batch
+
+    *checksum = 0.0;
+    for (u32 i = 0; i < BENCH_PXT_BOXES; i++) {
+        vec3 pos;
+        px_rigid_get_position(boxes[i], pos);
+        *checksum += pos[0] + pos[1] + pos[2];
+    }
+
+    free(boxes);
+    px_destroy();
+    return frame_time / frames;
+}
+
+static
+void _bench_px_thread(int frames) {
+    f64 physics, work, checksum, threaded_checksum;
+    _px_thread_frames(false, frames, 0.0, &physics, &checksum);
+    work = physics / frames;
+
+    f64 inline_frame = _px_thread_frames(false, frames, work, &physics, &checksum);
+    f64 threaded_frame = _px_thread_frames(true, frames, work, &physics, &threaded_checksum);
+    f64 wait = physics / frames;
+
+    log_info("[bench] pxthread: %d rigid boxes x %d frames, %.3f ms physics/frame", BENCH_PXT_BOXES, frames, work * 1000.0);
+    log_info(
+        "[bench] pxthread: frame inline %.3f ms, threaded %.3f ms (%.3f ms waiting for physics)",
+        inline_frame * 1000.0, threaded_frame * 1000.0, wait * 1000.0
+    );
+    if (checksum != threaded_checksum)
+        log_error("[bench] pxthread: threaded state differs from inline (%f, %f)", checksum, threaded_checksum);
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct BenchRayJob {
+    const PxRayQuery* rays;
+    PxHit* hits;
+    u32* counts;
+    u32 count;
+} BenchRayJob;
+
+static
+void* _px_ray_job(void* data) {
+    BenchRayJob* job = data;
+    px_raycast_batch(job->rays, job->count, NULL, job->hits, BENCH_PXQ_HITS, job->counts);
+    return NULL;
+}
+
+/* Ray geom vs spaces (as interaction ray used to), nearest hit by `dCollide` */
+static
+void _px_ray_nearest(void* data, dGeomID geom1, dGeomID geom2) {
+    PxHit* nearest = data;
+    dGeomID ray = dGeomGetClass(geom1) == dRayClass ? geom1 : geom2;
+    dGeomID other = ray == geom1 ? geom2 : geom1;
+
+    dContactGeom contact;
+    if (dCollide(ray, other, 1, &contact, sizeof(dContactGeom)) == 0)  return;
+    if (nearest->obj && contact.depth >= nearest->dist)  return;
+
+    nearest->obj = px_get_object_by_geom(other);
+    nearest->dist = contact.depth;
+}
+
+static
+void _bench_px_query(int iterations) {
+    Config.PHYSICS_THREADED = false;
+    px_init();
+
+    f32 half = BENCH_PX_GRID;
+    px_build_static_space((vec3){half, 0.0, half}, (vec3){half + 2.0, 2.0, half + 2.0});
+
+    vec3 zero = {0.0, 0.0, 0.0};
+    for (u32 i = 0; i < BENCH_PX_OBJECTS; i++) {
+        vec3 pos = {(i % BENCH_PX_GRID) * 2.0, 0.5, (i / BENCH_PX_GRID) * 2.0};
+        PxObject* obj = px_static_create(PXBODY_BOX, pos, zero, (vec3){1.0, 1.0, 1.0});
+        obj->owner = i + 1;
+    }
+    int static_geoms = dSpaceGetNumGeoms(px_get_static_space());
+    int dynamic_geoms = dSpaceGetNumGeoms(px_get_dynamic_space());
+
+    // Horizontal rays from between boxes in random directions
+    PxRayQuery* rays = malloc(sizeof(PxRayQuery) * BENCH_PXQ_RAYS);
+    srand(42);
+    for (u32 i = 0; i < BENCH_PXQ_RAYS; i++) {
+        u32 cell = rand() % BENCH_PX_OBJECTS;
+        f32 angle = (rand() / (f32)RAND_MAX) * 2.0 * M_PI;
+        glm_vec3_copy((vec3){(cell % BENCH_PX_GRID) * 2.0 + 1.0, 0.5, (cell / BENCH_PX_GRID) * 2.0 + 1.0}, rays[i].origin);
+        glm_vec3_copy((vec3){cosf(angle), 0.0, sinf(angle)}, rays[i].dir);
+        rays[i].max_dist = 10.0;
+    }
+
+    PxHit* hits = malloc(sizeof(PxHit) * BENCH_PXQ_RAYS * BENCH_PXQ_HITS);
+    PxHit* threaded_hits = malloc(sizeof(PxHit) * BENCH_PXQ_RAYS * BENCH_PXQ_HITS);
+    u32* counts = malloc(sizeof(u32) * BENCH_PXQ_RAYS);
+    u32* threaded_counts = malloc(sizeof(u32) * BENCH_PXQ_RAYS);
+    f64 single = 0.0, threaded = 0.0;
+    u64 total = 0;
+
+    for (int it = 0; it < iterations; it++) {
+        f64 start = _now();
+        total += px_raycast_batch(rays, BENCH_PXQ_RAYS, NULL, hits, BENCH_PXQ_HITS, counts);
+        single += _now() - start;
+
+        // Same batch split across threads, each writes own slice of results
+        pthread_t threads[BENCH_PXQ_THREADS];
+        BenchRayJob jobs[BENCH_PXQ_THREADS];
+        u32 slice = BENCH_PXQ_RAYS / BENCH_PXQ_THREADS;
+
+        start = _now();
+        for (u32 t = 0; t < BENCH_PXQ_THREADS; t++) {
+            u32 first = t * slice;
+            jobs[t] = (BenchRayJob){
+                .rays = rays + first,
+                .hits = threaded_hits + (u64)first * BENCH_PXQ_HITS,
+                .counts = threaded_counts + first,
+                .count = t == BENCH_PXQ_THREADS - 1 ? BENCH_PXQ_RAYS - first : slice,
+            };
+            pthread_create(&threads[t], NULL, _px_ray_job, &jobs[t]);
+        }
+        for (u32 t = 0; t < BENCH_PXQ_THREADS; t++)
+            pthread_join(threads[t], NULL);
+        threaded += _now() - start;
+    }
+
+    u32 mismatches = 0;
+    for (u32 i = 0; i < BENCH_PXQ_RAYS; i++) {
+        if (counts[i] != threaded_counts[i])  { mismatches++;  continue; }
+        for (u32 h = 0; h < counts[i]; h++) {
+            PxHit* a = &hits[i * BENCH_PXQ_HITS + h];
+            PxHit* b = &threaded_hits[i * BENCH_PXQ_HITS + h];
+            if (a->obj != b->obj || a->dist != b->dist)  { mismatches++;  break; }
+        }
+    }
+
+    // Previous way, ray geom through broadphase of both spaces
+    dGeomID ray = dCreateRay(0, 10.0);
+    u32 broad_mismatches = 0;
+    f64 broadphase = 0.0;
+
+    f64 start = _now();
+    for (u32 i = 0; i < BENCH_PXQ_RAYS; i++) {
+        PxRayQuery* q = &rays[i];
+        dGeomRaySet(ray, q->origin[0], -q->origin[2], q->origin[1], q->dir[0], -q->dir[2], q->dir[1]);
+
+        PxHit nearest = {};
+        px_collide_geom(ray, &nearest, _px_ray_nearest);
+
+        PxObject* expected = counts[i] ? hits[i * BENCH_PXQ_HITS].obj : NULL;
+        if (nearest.obj != expected)  broad_mismatches++;
+    }
+    broadphase = _now() - start;
+    dGeomDestroy(ray);
+
+    /* --- Sphere cast & overlap sanity --- */
+    PxHit hit;
+    u32 sanity_errors = 0;
+
+    // Midway between boxes 0 and 1 of first row, box 1 surface is 0.5 away
+    u32 n = px_sphere_cast((vec3){1.0, 0.5, 0.0}, 0.2, (vec3){1.0, 0.0, 0.0}, 5.0, NULL, &hit, 1);
+    if (n != 1 || hit.obj->owner != 2 || fabsf(hit.dist - 0.3f) > 0.01 || hit.normal[0] > -0.99)  sanity_errors++;
+    f32 cast_dist = n ? hit.dist : -1.0;
+
+    // Box covering boxes 1 & 2 of second row only, nearest is one it's centered on
+    PxHit overlaps[4];
+    n = px_overlap_box((vec3){2.5, 0.5, 2.0}, (vec3){2.0, 0.5, 0.5}, zero, NULL, overlaps, 4);
+    if (n != 2 || overlaps[0].obj->owner != BENCH_PX_GRID + 2 || overlaps[1].obj->owner != BENCH_PX_GRID + 3)  sanity_errors++;
+    u32 overlap_count = n;
+
+    if (dSpaceGetNumGeoms(px_get_static_space()) != static_geoms
+        || dSpaceGetNumGeoms(px_get_dynamic_space()) != dynamic_geoms)
+        sanity_errors++;
+
+    u64 rays_cast = (u64)BENCH_PXQ_RAYS * iterations;
+    log_info("[bench] pxquery: %d static objects, %d rays x %d iterations, %.2f hits/ray",
+        BENCH_PX_OBJECTS, BENCH_PXQ_RAYS, iterations, (f64)total / rays_cast);
+    log_info(
+        "[bench] pxquery: raycast batch %.3f us/ray, %d threads %.3f us/ray, broadphase %.3f us/ray",
+        single * 1e6 / rays_cast, BENCH_PXQ_THREADS, threaded * 1e6 / rays_cast, broadphase * 1e6 / BENCH_PXQ_RAYS
+    );
+    log_info("[bench] pxquery: sphere cast hit at %.3f (0.3 expected), box overlaps %u (2 expected)", cast_dist, overlap_count);
+
+    if (total == 0)          log_error("[bench] pxquery: rays hit nothing");
+    if (mismatches)          log_error("[bench] pxquery: %u threaded results differ from single thread", mismatches);
+    if (broad_mismatches)    log_error("[bench] pxquery: %u nearest hits differ from broadphase", broad_mismatches);
+    if (sanity_errors)       log_error("[bench] pxquery: sphere cast / overlap sanity checks failed");
+
+    free(rays);
+    free(hits);
+    free(threaded_hits);
+    free(counts);
+    free(threaded_counts);
+    px_destroy();
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct BenchSleepRun {
+    PxStats stats;          // of last frame
+    f64 step;               // sec per frame, second half (settled)
+    u32 expected_active;    // boxes within active radius
+    f32 ring_y, far_y;      // height of farthest ring box & of far corner box
+} BenchSleepRun;
+
+/* Boxes dropped on ground in grid, focus in corner */
+static
+BenchSleepRun _px_sleep_frames(int sleep_steps, f64 active_radius, int frames) {
+    Config.PHYSICS_THREADED = false;
+    Config.PHYSICS_SLEEP_STEPS = sleep_steps;
+    Config.PHYSICS_ACTIVE_RADIUS = active_radius;
+    Config.PHYSICS_RING_RADIUS = active_radius * 2.0;
+    Config.PHYSICS_RING_INTERVAL = 4;
+    px_init();
+    dRandSetSeed(0);
+
+    vec3 zero = {0.0, 0.0, 0.0};
+    f32 side = BENCH_PXS_GRID * BENCH_PXS_SPACING;
+    px_static_create(PXBODY_BOX, (vec3){side / 2.0, -0.5, side / 2.0}, zero, (vec3){side + 4.0, 1.0, side + 4.0});
+    px_set_focus(zero);
+
+    BenchSleepRun run = {};
+    PxObject* ring_box = NULL;
+    f32 ring_dist = 0.0;
+
+    PxObject** boxes = malloc(sizeof(PxObject*) * BENCH_PXS_GRID * BENCH_PXS_GRID);
+    for (u32 i = 0; i < BENCH_PXS_GRID * BENCH_PXS_GRID; i++) {
+        vec3 pos = {(i % BENCH_PXS_GRID) * BENCH_PXS_SPACING, 2.0, (i / BENCH_PXS_GRID) * BENCH_PXS_SPACING};
+        boxes[i] = px_rigid_create(PXBODY_BOX, pos, zero, (vec3){1.0, 1.0, 1.0}, 1.0);
+
+        f32 dist = sqrtf(pos[0] * pos[0] + pos[2] * pos[2]);
+        if (dist <= active_radius)  run.expected_active++;
+        if (dist > active_radius && dist <= active_radius * 2.0 && dist > ring_dist) {
+            ring_box = boxes[i];
+            ring_dist = dist;
+        }
+    }
+
+    for (int f = 0; f < frames; f++) {
+        f64 start = _now();
+        px_update(BENCH_PXT_DT);
+        if (f >= frames / 2)  run.step += _now() - start;
+    }
+    run.step /= frames - frames / 2;
+    run.stats = px_get_stats();
+
+    vec3 pos;
+    px_rigid_get_position(boxes[BENCH_PXS_GRID * BENCH_PXS_GRID - 1], pos);
+    run.far_y = pos[1];
+    if (ring_box) {
+        px_rigid_get_position(ring_box, pos);
+        run.ring_y = pos[1];
+    }
+
+    free(boxes);
+    px_destroy();
+    return run;
+}
+
+static
+void _bench_px_sleep(int frames) {
+    u32 count = BENCH_PXS_GRID * BENCH_PXS_GRID;
+    BenchSleepRun awake = _px_sleep_frames(0, 0.0, frames);
+    BenchSleepRun sleep = _px_sleep_frames(30, 0.0, frames);
+    BenchSleepRun region = _px_sleep_frames(0, BENCH_PXS_RADIUS, frames);
+
+    log_info("[bench] pxsleep: %u rigid boxes x %d frames, step time over last %d frames", count, frames, frames - frames / 2);
+    log_info("[bench] pxsleep: always awake  %.3f ms/frame, active %u", awake.step * 1000.0, awake.stats.active_bodies);
+    log_info(
+        "[bench] pxsleep: auto-disable  %.3f ms/frame, active %u, sleeping %u",
+        sleep.step * 1000.0, sleep.stats.active_bodies, sleep.stats.sleeping_bodies
+    );
+    log_info(
+        "[bench] pxsleep: region %.0fm    %.3f ms/frame, active %u (%u in radius), ring %u, held %u",
+        BENCH_PXS_RADIUS, region.step * 1000.0, region.stats.active_bodies, region.expected_active,
+        region.stats.ring_bodies, region.stats.held_bodies
+    );
+    log_info("[bench] pxsleep: ring box landed at y %.2f, far box frozen at y %.2f", region.ring_y, region.far_y);
+
+    if (awake.stats.active_bodies != count)
+        log_error("[bench] pxsleep: bodies asleep with auto-disable off");
+    if (sleep.stats.sleeping_bodies < count * 9 / 10)
+        log_error("[bench] pxsleep: resting bodies didn't fall asleep (%u of %u)", sleep.stats.sleeping_bodies, count);
+    if (region.stats.active_bodies != region.expected_active)
+        log_error("[bench] pxsleep: active bodies don't match region");
+    if (fabsf(region.ring_y - 0.5f) > 0.05 || region.far_y != 2.0f)
+        log_error("[bench] pxsleep: ring box didn't land or far box moved");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Independent stacks (one island each) stepped with `threads`, returns step time per frame */
+static
+f64 _px_stack_frames(int threads, int frames, f64* top_drop) {
+    Config.PHYSICS_THREADED = false;
+    Config.PHYSICS_STEP_THREADS = threads;
+    Config.PHYSICS_SLEEP_STEPS = 0;  // stacks would fall asleep, nothing left to step
+    Config.PHYSICS_ACTIVE_RADIUS = 0.0;
+    px_init();
+
+    vec3 zero = {0.0, 0.0, 0.0};
+    f32 side = BENCH_PXST_GRID * BENCH_PXST_SPACING;
+    px_static_create(PXBODY_BOX, (vec3){side / 2.0, -0.5, side / 2.0}, zero, (vec3){side + 4.0, 1.0, side + 4.0});
+
+    u32 stacks = BENCH_PXST_GRID * BENCH_PXST_GRID;
+    PxObject** tops = malloc(sizeof(PxObject*) * stacks);
+    for (u32 i = 0; i < stacks; i++) {
+        for (u32 level = 0; level < BENCH_PXST_HEIGHT; level++) {
+            vec3 pos = {(i % BENCH_PXST_GRID) * BENCH_PXST_SPACING, 0.5 + level * 1.0, (i / BENCH_PXST_GRID) * BENCH_PXST_SPACING};
+            tops[i] = px_rigid_create(PXBODY_BOX, pos, zero, (vec3){1.0, 1.0, 1.0}, 1.0);
+        }
+    }
+
+    f64 step = 0.0;
+    for (int f = 0; f < frames; f++) {
+        f64 start = _now();
+        px_update(BENCH_PXT_DT);
+        step += _now() - start;
+    }
+
+    // Stacks settle a bit into contacts, collapsed one drops by meters
+    *top_drop = 0.0;
+    for (u32 i = 0; i < stacks; i++) {
+        vec3 pos;
+        px_rigid_get_position(tops[i], pos);
+        *top_drop = fmax(*top_drop, (0.5 + (BENCH_PXST_HEIGHT - 1) * 1.0) - pos[1]);
+    }
+
+    free(tops);
+    px_destroy();
+    return step / frames;
+}
+
+static
+void _bench_px_stacks(int frames) {
+    static const int threads[] = {1, 2, 4, 8};
+    u32 boxes = BENCH_PXST_GRID * BENCH_PXST_GRID * BENCH_PXST_HEIGHT;
+    log_info(
+        "[bench] pxstacks: %d stacks of %d boxes (%u bodies) x %d frames, %ld cores",
+        BENCH_PXST_GRID * BENCH_PXST_GRID, BENCH_PXST_HEIGHT, boxes, frames, sysconf(_SC_NPROCESSORS_ONLN)
+    );
+
+    f64 single = 0.0;
+    for (u32 i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        f64 top_drop;
+        f64 step = _px_stack_frames(threads[i], frames, &top_drop);
+        if (i == 0)  single = step;
+
+        log_info(
+            "[bench] pxstacks: %d step threads  %.3f ms/frame (x%.2f), top box dropped by %.3f max",
+            threads[i], step * 1000.0, single / step, top_drop
+        );
+        if (top_drop > 0.1)
+            log_error("[bench] pxstacks: stack collapsed with %d step threads", threads[i]);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct BenchMaskRun {
+    f64 step;       // sec per frame
+    f64 dynamic_pairs, static_pairs, contacts;  // per step
+} BenchMaskRun;
+
+/* Items resting between static pillars with player and trigger volumes among
+   them, `open_masks` collides every geom with everything (as before masks) */
+static
+BenchMaskRun _px_mask_frames(bool open_masks, int frames) {
+    Config.PHYSICS_THREADED = false;
+    Config.PHYSICS_STEP_THREADS = 0;
+    Config.PHYSICS_SLEEP_STEPS = 0;
+    Config.PHYSICS_ACTIVE_RADIUS = 0.0;
+    px_init();
+    dRandSetSeed(0);
+
+    vec3 zero = {0.0, 0.0, 0.0};
+    f32 side = BENCH_PXM_GRID * 2.0;
+    cvector(PxObject*) objects = NULL;
+
+    cvector_push_back(objects, px_static_create(PXBODY_BOX, (vec3){side / 2.0, -0.5, side / 2.0}, zero, (vec3){side + 4.0, 1.0, side + 4.0}));
+    for (u32 i = 0; i < BENCH_PXM_GRID * BENCH_PXM_GRID; i++) {
+        f32 x = (i % BENCH_PXM_GRID) * 2.0, z = (i / BENCH_PXM_GRID) * 2.0;
+
+        // Pillar and item next to it, trigger over every 8th cell
+        cvector_push_back(objects, px_static_create(PXBODY_BOX, (vec3){x, 1.0, z}, zero, (vec3){0.5, 2.0, 0.5}));
+        cvector_push_back(objects, px_rigid_create(PXBODY_BOX, (vec3){x + 1.0, 0.25, z}, zero, (vec3){0.5, 0.5, 0.5}, 1.0));
+        if (i % 8 == 0) {
+            PxObject* trigger = px_static_create(PXBODY_BOX, (vec3){x + 1.0, 1.0, z}, zero, (vec3){1.5, 2.0, 1.5});
+            px_object_set_masks(trigger, PXCAT_TRIGGER, PXCAT_PLAYER);
+            cvector_push_back(objects, trigger);
+        }
+    }
+
+    px_player_init((vec3){side / 2.0 + 1.0, 0.0, side / 2.0 + 1.0}, zero, 0.4, 1.8);
+
+    if (open_masks) {
+        PxObject** obj;
+        cvector_for_each_in(obj, objects) {
+            px_object_set_masks(*obj, (*obj)->category, ~0u);
+        }
+    }
+
+    BenchMaskRun run = {};
+    u64 steps = 0;
+
+    for (int f = 0; f < frames; f++) {
+        f64 start = _now();
+        px_update(BENCH_PXT_DT);
+        run.step += _now() - start;
+
+        PxStats stats = px_get_stats();
+        steps += px_get_frame_steps();
+        run.dynamic_pairs += stats.dynamic_pairs;
+        run.static_pairs += stats.static_pairs;
+        run.contacts += stats.contacts;
+    }
+    steps = steps ? steps : 1;
+
+    run.step /= frames;
+    run.dynamic_pairs /= steps;
+    run.static_pairs /= steps;
+    run.contacts /= steps;
+
+    px_player_destroy();
+    cvector_free(objects);
+    px_destroy();
+    return run;
+}
+
+/* Player walks across floor through trigger volume: returns distance walked,
+   frames the trigger was overlapped and frames player was on ground / ceiled */
+static
+f32 _px_mask_walk(u32* in_trigger, u32* grounded, u32* ceiled) {
+    Config.PHYSICS_THREADED = false;
+    px_init();
+
+    vec3 zero = {0.0, 0.0, 0.0};
+    px_static_create(PXBODY_BOX, (vec3){5.0, -0.5, 0.0}, zero, (vec3){14.0, 1.0, 4.0});
+    PxObject* trigger = px_static_create(PXBODY_BOX, (vec3){5.0, 1.0, 0.0}, zero, (vec3){2.0, 2.0, 2.0});
+    px_object_set_masks(trigger, PXCAT_TRIGGER, PXCAT_PLAYER);
+
+    vec3 pos = {0.0, 0.0, 0.0};
+    px_player_init(pos, zero, 0.4, 1.8);
+    *in_trigger = *grounded = *ceiled = 0;
+
+    for (int f = 0; f < 200; f++) {
+        px_player_set_position(pos);
+        px_player_update();
+
+        cvector(PxObject*) triggers = px_player_get_triggers();
+        if (cvector_size(triggers) == 1 && triggers[0] == trigger)  (*in_trigger)++;
+        if (px_player_get_grounded())  (*grounded)++;
+        if (px_player_get_ceiled())    (*ceiled)++;
+
+        vec3 move = {0.05, 0.0, 0.0};
+        px_player_translate(move);
+        glm_vec3_add(pos, move, pos);
+    }
+
+    px_player_destroy();
+    px_destroy();
+    return pos[0];
+}
+
+static
+void _bench_px_masks(int frames) {
+    BenchMaskRun open = _px_mask_frames(true, frames);
+    BenchMaskRun masked = _px_mask_frames(false, frames);
+
+    log_info(
+        "[bench] pxmasks: %d pillars & items, %d triggers, player x %d frames",
+        BENCH_PXM_GRID * BENCH_PXM_GRID, (BENCH_PXM_GRID * BENCH_PXM_GRID + 7) / 8, frames
+    );
+    log_info(
+        "[bench] pxmasks: open   %.3f ms/frame, pairs/step dynamic %.1f, static %.1f, contacts %.1f",
+        open.step * 1000.0, open.dynamic_pairs, open.static_pairs, open.contacts
+    );
+    log_info(
+        "[bench] pxmasks: masked %.3f ms/frame, pairs/step dynamic %.1f, static %.1f, contacts %.1f",
+        masked.step * 1000.0, masked.dynamic_pairs, masked.static_pairs, masked.contacts
+    );
+    if (masked.static_pairs >= open.static_pairs)
+        log_error("[bench] pxmasks: masks didn't prune any pairs");
+
+    u32 in_trigger, grounded, ceiled;
+    f32 walked = _px_mask_walk(&in_trigger, &grounded, &ceiled);
+    log_info(
+        "[bench] pxmasks: walk %.2f m, in trigger %u frames, grounded %u, ceiled %u (of 200)",
+        walked, in_trigger, grounded, ceiled
+    );
+    if (fabs(walked - 10.0) > 1e-3)         log_error("[bench] pxmasks: trigger blocked player");
+    if (in_trigger == 0)                    log_error("[bench] pxmasks: trigger overlap not reported");
+    if (grounded != 200 || ceiled != 0)     log_error("[bench] pxmasks: trigger taken for ground or ceiling");
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(int argc, char** argv) {
+    config_load("econfig.toml");
+    atom_init();
+
+    if (argc < 2) {
+        printf("Usage: %s <gltf|db|refs|mats|bvh|px|pxthread|pxquery|pxsleep|pxstacks|pxmasks> [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int iterations = argc > 2 ? atoi(argv[2]) : 0;
+
+    if (strcmp(argv[1], "gltf") == 0)       _bench_gltf(iterations > 0 ? iterations : 100);
+    else if (strcmp(argv[1], "db") == 0)    _bench_db(iterations > 0 ? iterations : 10);
+    else if (strcmp(argv[1], "refs") == 0)  _bench_refs(iterations > 0 ? iterations : 10);
+    else if (strcmp(argv[1], "mats") == 0)  _bench_mats(iterations > 0 ? iterations : 10);
+    else if (strcmp(argv[1], "bvh") == 0)   _bench_bvh(iterations > 0 ? iterations : 100);
+    else if (strcmp(argv[1], "px") == 0)    _bench_px(iterations > 0 ? iterations : 60);
+    else if (strcmp(argv[1], "pxthread") == 0)  _bench_px_thread(iterations > 0 ? iterations : 120);
+    else if (strcmp(argv[1], "pxquery") == 0)   _bench_px_query(iterations > 0 ? iterations : 10);
+    else if (strcmp(argv[1], "pxsleep") == 0)   _bench_px_sleep(iterations > 0 ? iterations : 240);
+    else if (strcmp(argv[1], "pxstacks") == 0)  _bench_px_stacks(iterations > 0 ? iterations : 20);
+    else if (strcmp(argv[1], "pxmasks") == 0)   _bench_px_masks(iterations > 0 ? iterations : 60);
+    else                                    log_exit("[bench] Unknown benchmark: %s", argv[1]);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,384 @@
+/*
+    cook.c -- Offline Assets Cooker
+
+    Usage: ./interlope-cook [output]  (default: `path.pack` from econfig.toml)
+
+    * Loads objects data, every scene in scenes directory, .glb meshes and .dds
+      textures the same way engine does, measuring time spent on it
+    * Writes assets to single engine pack (layout is in `assets/pack.h`):
+      GPU-ready vertex/index buffers, texture mip chains, pre-parsed tables
+    * Writes objects and scenes to database snapshot (`path.db_snapshot`)
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <cvector.h>
+
+#include "assets/mesh_gltf.h"
+#include "assets/model.h"
+#include "assets/pack.h"
+#include "assets/texture.h"
+#include "core/atom.h"
+#include "core/config.h"
+#include "core/containers/map.h"
+#include "core/containers/tuple.h"
+#include "core/log.h"
+#include "database/loader.h"
+#include "database/snapshot.h"
+#include "platform/file.h"
+
+
+#define TABLE_ALIGN  16
+#define BLOBS_ALIGN  4096  // page-aligned, so texture levels are mapped on page bounds
+
+
+static struct Cook {
+    cvector(PackMeshFile) mesh_files;
+    cvector(PackMeshNode) mesh_nodes;
+    cvector(PackTexture) textures;
+    cvector(SceneInfo*) scenes;  // NULL-terminated on write
+    Arena* db_arena;             // objects & scenes data
+
+    cvector(char) strings;
+    cvector(u8) blobs;  // offsets are relative to blobs section until written
+
+    map(void) strings_index;  // string -> offset + 1
+    map(void) meshes_index;   // path -> loaded
+    map(void) textures_index;
+
+    f64 load_time;
+    i64 source_mtime;
+} self = {};
+
+
+/* ------------------------------------------------------------------------- */
+
+static inline
+f64 _now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline
+u64 _align(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline
+i64 _file_mtime(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0)  return 0;
+    return st.st_mtime;
+}
+
+static inline
+void _track_mtime(const char* path) {
+    i64 mtime = _file_mtime(path);
+    if (mtime > self.source_mtime)  self.source_mtime = mtime;
+}
+
+static
+u32 _string(const char* str) {
+    intptr_t found = (intptr_t)map_get(self.strings_index, (void*)str);
+    if (found)  return found - 1;
+
+    u32 offset = cvector_size(self.strings);
+    u64 len = strlen(str) + 1;
+    for (u64 i = 0; i < len; i++)
+        cvector_push_back(self.strings, str[i]);
+
+    map_set(self.strings_index, (void*)(intptr_t)(offset + 1), strdup(str));
+    return offset;
+}
+
+static
+u64 _blob(const void* data, u64 size) {
+    u64 offset = _align(cvector_size(self.blobs), PACK_BLOB_ALIGN);
+    u64 new_size = offset + size;
+
+    if (cvector_capacity(self.blobs) < new_size) {
+        u64 capacity = cvector_capacity(self.blobs) * 2;
+        cvector_reserve(self.blobs, capacity > new_size ? capacity : new_size);
+    }
+
+    u64 old_size = cvector_size(self.blobs);
+    memset(self.blobs + old_size, 0, offset - old_size);
+    memcpy(self.blobs + offset, data, size);
+    cvector_set_size(self.blobs, new_size);
+
+    return offset;
+}
+
+/* ------ Assets ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void _cook_mesh(const char* path) {
+    if (map_get(self.meshes_index, (void*)path))  return;
+    map_set(self.meshes_index, (void*)1, strdup(path));
+
+    f64 start = _now();
+    GLTF_Asset* gltf = gltf_open((char*)path);
+    if (!gltf)  log_exit("[cook] Unable to load mesh: %s", path);
+
+    int nodes_count = gltf_get_nodes_count(gltf);
+
+    ModelNode* nodes = calloc(nodes_count, sizeof(ModelNode));
+    ModelNode** node_ptrs = calloc(nodes_count + 1, sizeof(ModelNode*));
+    ModelNodeData* nodes_data = calloc(nodes_count, sizeof(ModelNodeData));
+    for (int i = 0; i < nodes_count; i++)
+        node_ptrs[i] = &nodes[i];
+
+    gltf_read_model_nodes(gltf, node_ptrs, nodes_data);
+    for (int i = 0; i < nodes_count; i++)
+        gltf_get_mesh_aabb(gltf, i, nodes[i].aabb_min, nodes[i].aabb_max);
+
+    self.load_time += _now() - start;
+
+    /* --- Pack Entries --- */
+    const char* full_path;
+    PackMeshFile file = {
+        .path = _string(path),
+        .first_node = cvector_size(self.mesh_nodes),
+        .nodes_count = nodes_count,
+    };
+    with_path_to_mesh(full_path, path, {
+        file.source_mtime = _file_mtime(full_path);
+    });
+    cvector_push_back(self.mesh_files, file);
+
+    for (int i = 0; i < nodes_count; i++) {
+        PackMeshNode pn = {.name = _string(nodes[i].name)};
+        glm_vec3_copy(nodes[i].position, pn.position);
+        glm_vec3_copy(nodes[i].rotation, pn.rotation);
+        glm_vec3_copy(nodes[i].aabb_min, pn.aabb_min);
+        glm_vec3_copy(nodes[i].aabb_max, pn.aabb_max);
+
+        ModelNodeData* nd = &nodes_data[i];
+        if (nd->vtx_buf) {
+            pn.has_mesh = true;
+            pn.vtx_count = nd->vtx_count;
+            pn.ind_count = nd->ind_count;
+            pn.index_size = nd->index_size;
+            pn.ranges_count = nd->ranges_count;
+            pn.vtx_offset = _blob(nd->vtx_buf, nd->vtx_count * 8 * sizeof(f32));
+            pn.ind_offset = _blob(nd->ind_buf, nd->ind_count * nd->index_size);
+            pn.ranges_offset = _blob(nd->ranges, nd->ranges_count * sizeof(GfxMeshRange));
+
+            free(nd->vtx_buf);
+            free(nd->ind_buf);
+            free(nd->ranges);
+        }
+        cvector_push_back(self.mesh_nodes, pn);
+    }
+
+    free(nodes_data);
+    free(node_ptrs);
+    free(nodes);
+    gltf_close(gltf);
+}
+
+static
+void _cook_texture(const char* path) {
+    if (map_get(self.textures_index, (void*)path))  return;
+    map_set(self.textures_index, (void*)1, strdup(path));
+
+    f64 start = _now();
+    DDS_File dds;
+    texture_read(path, &dds);
+    self.load_time += _now() - start;
+
+    u64 size = 0;
+    for (u32 i = 0; i < dds.mipmap_cnt; i++)
+        size += texture_dds_level_size(&dds, i);
+    size *= dds.faces;
+
+    PackTexture pt = {
+        .path = _string(path),
+        .width = dds.width,
+        .height = dds.height,
+        .gl_format = dds.gl_format,
+        .block_size = dds.block_size,
+        .mipmap_cnt = dds.mipmap_cnt,
+        .faces = dds.faces,
+        .data_offset = _blob(dds.data, size),
+        .data_size = size,
+    };
+    const char* full_path;
+    with_path_to_texture(full_path, path, {
+        pt.source_mtime = _file_mtime(full_path);
+    });
+    cvector_push_back(self.textures, pt);
+
+    texture_release(&dds);
+}
+
+/* ------ Tables ------ */
+/* ------------------------------------------------------------------------- */
+
+static
+void _cook_objects(ObjectInfo** objects) {
+    ObjectInfo* obj;
+    tuple_for_each(obj, objects) {
+        if (!obj->model)  continue;
+
+        _cook_mesh(obj->model->mesh);
+        for (int i = 0; i < obj->model->texture_count; i++)
+            _cook_texture(obj->model->textures[i]);
+    }
+}
+
+static
+void _cook_scene(const char* path) {
+    f64 start = _now();
+    SceneInfo* scene = db_load_scene_data(self.db_arena, (char*)path);
+    self.load_time += _now() - start;
+
+    if (!scene)  log_exit("[cook] Unable to load scene: %s", path);
+    _track_mtime(path);
+
+    cvector_push_back(self.scenes, scene);
+}
+
+static
+void _cook_scenes_dir(const char* scene_path) {
+    char dir_path[256];
+    strncpy(dir_path, scene_path, sizeof(dir_path) - 1);
+    char* slash = strrchr(dir_path, '/');
+    if (slash)  *slash = '\0';
+    else        strcpy(dir_path, ".");
+
+    DIR* dir = opendir(dir_path);
+    if (!dir)  log_exit("[cook] Unable to open scenes directory: %s", dir_path);
+
+    struct dirent* entry;
+    while ((entry = readdir(dir))) {
+        const char* ext = strrchr(entry->d_name, '.');
+        if (!ext || strcmp(ext, ".json") != 0)  continue;
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+        _cook_scene(path);
+    }
+    closedir(dir);
+}
+
+/* ------ Output ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+void _write_padding(FILE* f, u64 to) {
+    static const u8 zeros[BLOBS_ALIGN] = {};
+    u64 pos = ftell(f);
+    if (to > pos)  fwrite(zeros, 1, to - pos, f);
+}
+
+static inline
+PackSection _section(u64 count, u64 elem_size, u64* cursor) {
+    *cursor = _align(*cursor, TABLE_ALIGN);
+    PackSection section = {.offset = *cursor, .count = count};
+    *cursor += count * elem_size;
+    return section;
+}
+
+#define _write_section(f, vec, section) \
+    _write_padding(f, (section).offset); \
+    if (vec)  fwrite(vec, sizeof(*(vec)), cvector_size(vec), f);
+
+static
+void _write_pack(const char* path) {
+    PackHeader header = {
+        .magic = PACK_MAGIC,
+        .version = PACK_VERSION,
+        .source_load_time = self.load_time,
+        .source_mtime = self.source_mtime,
+    };
+
+    /* --- Layout --- */
+    u64 cursor = sizeof(PackHeader);
+    header.mesh_files = _section(cvector_size(self.mesh_files), sizeof(PackMeshFile), &cursor);
+    header.mesh_nodes = _section(cvector_size(self.mesh_nodes), sizeof(PackMeshNode), &cursor);
+    header.textures = _section(cvector_size(self.textures), sizeof(PackTexture), &cursor);
+    header.strings = _section(cvector_size(self.strings), sizeof(char), &cursor);
+
+    u64 blobs_offset = _align(cursor, BLOBS_ALIGN);
+    header.file_size = blobs_offset + cvector_size(self.blobs);
+
+    /* --- Blob offsets become absolute --- */
+    for (u64 i = 0; i < cvector_size(self.mesh_nodes); i++) {
+        if (!self.mesh_nodes[i].has_mesh)  continue;
+        self.mesh_nodes[i].vtx_offset += blobs_offset;
+        self.mesh_nodes[i].ind_offset += blobs_offset;
+        self.mesh_nodes[i].ranges_offset += blobs_offset;
+    }
+    for (u64 i = 0; i < cvector_size(self.textures); i++)
+        self.textures[i].data_offset += blobs_offset;
+
+    /* --- Write --- */
+    FILE* f = fopen(path, "wb");
+    if (!f)  log_exit("[cook] Unable to open output file: %s", path);
+
+    fwrite(&header, sizeof(PackHeader), 1, f);
+    _write_section(f, self.mesh_files, header.mesh_files);
+    _write_section(f, self.mesh_nodes, header.mesh_nodes);
+    _write_section(f, self.textures, header.textures);
+    _write_section(f, self.strings, header.strings);
+
+    _write_padding(f, blobs_offset);
+    if (self.blobs)
+        fwrite(self.blobs, 1, cvector_size(self.blobs), f);
+
+    fclose(f);
+
+    log_success(
+        "[cook] %s: %.2f MB, %ld meshes, %ld textures (sources load: %.1f ms)",
+        path, header.file_size / (1024.0 * 1024.0),
+        header.mesh_files.count, header.textures.count, self.load_time * 1000.0
+    );
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(int argc, char** argv) {
+    config_load("econfig.toml");
+    atom_init();
+    Config.GRAPHICS_TEXTURE_STREAMING = false;  // read full mip chains
+
+    const char* output = argc > 1 ? argv[1] : Config.PATH_PACK;
+
+    self.strings_index = map_new(MHASH_STR);
+    self.meshes_index = map_new(MHASH_STR);
+    self.textures_index = map_new(MHASH_STR);
+
+    self.db_arena = arena_new();
+
+    f64 start = _now();
+    ObjectInfo** objects = db_load_objects_data(self.db_arena, Config.PATH_OBJECTS_DATA);
+    self.load_time += _now() - start;
+
+    if (!objects)  log_exit("[cook] Unable to load objects data: %s", Config.PATH_OBJECTS_DATA);
+    _track_mtime(Config.PATH_OBJECTS_DATA);
+
+    _cook_objects(objects);
+    _cook_scenes_dir(Config.PATH_SCENES_DATA);
+    _write_pack(output);
+
+    cvector_push_back(self.scenes, NULL);
+    if (!db_snapshot_write(Config.PATH_DB_SNAPSHOT, objects, self.scenes, self.source_mtime))
+        return EXIT_FAILURE;
+
+    log_success(
+        "[cook] %s: %ld objects, %ld scenes",
+        Config.PATH_DB_SNAPSHOT, tuple_size(objects), cvector_size(self.scenes) - 1
+    );
+
+    cvector_free(self.scenes);
+    arena_free(self.db_arena);
+
+    return EXIT_SUCCESS;
+}
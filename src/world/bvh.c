@@ -0,0 +1,427 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bvh.h"
+
+#include "core/log.h"
+
+
+#define BVH_MIN_CAPACITY  256
+#define BVH_STACK_SIZE    256  // balanced tree, enough for any leaf count that fits u32
+
+
+/* ------ Boxes ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+void _union(const vec3 a_min, const vec3 a_max, const vec3 b_min, const vec3 b_max, vec3 min, vec3 max) {
+    for (int i = 0; i < 3; i++) {
+        min[i] = fminf(a_min[i], b_min[i]);
+        max[i] = fmaxf(a_max[i], b_max[i]);
+    }
+}
+
+/* Half of surface area, insertion cost metric */
+static inline
+f32 _area(const vec3 min, const vec3 max) {
+    f32 dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static inline
+f32 _union_area(const vec3 a_min, const vec3 a_max, const vec3 b_min, const vec3 b_max) {
+    vec3 min, max;
+    _union(a_min, a_max, b_min, b_max, min, max);
+    return _area(min, max);
+}
+
+static inline
+bool _contains(const vec3 min, const vec3 max, const vec3 in_min, const vec3 in_max) {
+    return
+        min[0] <= in_min[0] && min[1] <= in_min[1] && min[2] <= in_min[2] &&
+        max[0] >= in_max[0] && max[1] >= in_max[1] && max[2] >= in_max[2];
+}
+
+static inline
+bool _overlaps(const vec3 a_min, const vec3 a_max, const vec3 b_min, const vec3 b_max) {
+    return
+        a_min[0] <= b_max[0] && a_max[0] >= b_min[0] &&
+        a_min[1] <= b_max[1] && a_max[1] >= b_min[1] &&
+        a_min[2] <= b_max[2] && a_max[2] >= b_min[2];
+}
+
+/* Ray entry distance into box, FLT_MAX if missed or farther than `max_dist` */
+static inline
+f32 _ray_box(const vec3 origin, const vec3 inv_dir, f32 max_dist, const vec3 min, const vec3 max) {
+    f32 t_near = 0.0, t_far = max_dist;
+    for (int i = 0; i < 3; i++) {
+        f32 t0 = (min[i] - origin[i]) * inv_dir[i];
+        f32 t1 = (max[i] - origin[i]) * inv_dir[i];
+        t_near = fmaxf(t_near, fminf(t0, t1));
+        t_far = fminf(t_far, fmaxf(t0, t1));
+    }
+    return t_near <= t_far ? t_near : FLT_MAX;
+}
+
+static inline
+bool _overlaps_shape(const BvhShape* shape, const vec3 min, const vec3 max) {
+    switch (shape->type) {
+        case BVH_SHAPE_AABB: {
+            vec3 s_min, s_max;
+            glm_vec3_sub((f32*)shape->box.center, (f32*)shape->box.extent, s_min);
+            glm_vec3_add((f32*)shape->box.center, (f32*)shape->box.extent, s_max);
+            return _overlaps(s_min, s_max, min, max);
+        }
+        case BVH_SHAPE_SPHERE: {
+            // Squared distance from center to nearest point of box
+            f32 dist = 0.0;
+            for (int i = 0; i < 3; i++) {
+                f32 d = fmaxf(fmaxf(min[i] - shape->sphere[i], shape->sphere[i] - max[i]), 0.0);
+                dist += d * d;
+            }
+            return dist <= shape->sphere[3] * shape->sphere[3];
+        }
+        case BVH_SHAPE_FRUSTUM: {
+            // Outside if corner farthest along plane normal is behind it
+            for (int p = 0; p < 6; p++) {
+                const f32* plane = shape->planes[p];
+                f32 dist = plane[3];
+                for (int i = 0; i < 3; i++)
+                    dist += plane[i] * (plane[i] >= 0.0 ? max[i] : min[i]);
+                if (dist < 0.0)  return false;
+            }
+            return true;
+        }
+        case BVH_SHAPE_RAY:
+            return _ray_box(shape->ray.origin, shape->ray.inv_dir, shape->ray.max_dist, min, max) != FLT_MAX;
+    }
+    return false;
+}
+
+/* ------ Nodes ------ */
+/* ------------------------------------------------------------------------- */
+
+static inline
+bool _is_leaf(BvhNode* node) {
+    return node->left == BVH_NULL;
+}
+
+static
+u32 _alloc_node(Bvh* self) {
+    if (self->free_list == BVH_NULL) {
+        u32 capacity = self->capacity ? self->capacity * 2 : BVH_MIN_CAPACITY;
+        self->nodes = realloc(self->nodes, sizeof(BvhNode) * capacity);
+        if (!self->nodes)  log_exit("[world] Out of memory for %u BVH nodes", capacity);
+
+        for (u32 i = self->capacity; i < capacity; i++) {
+            self->nodes[i].parent = i + 1 < capacity ? i + 1 : BVH_NULL;
+            self->nodes[i].height = -1;
+        }
+        self->free_list = self->capacity;
+        self->capacity = capacity;
+    }
+
+    u32 index = self->free_list;
+    BvhNode* node = &self->nodes[index];
+    self->free_list = node->parent;
+
+    node->parent = BVH_NULL;
+    node->left = BVH_NULL;
+    node->right = BVH_NULL;
+    node->height = 0;
+    node->data = 0;
+    return index;
+}
+
+static inline
+void _free_node(Bvh* self, u32 index) {
+    self->nodes[index].parent = self->free_list;
+    self->nodes[index].height = -1;
+    self->free_list = index;
+}
+
+/* Recompute bounds & height of internal node from its children */
+static inline
+void _refit_node(Bvh* self, u32 index) {
+    BvhNode* node = &self->nodes[index];
+    BvhNode* left = &self->nodes[node->left];
+    BvhNode* right = &self->nodes[node->right];
+
+    _union(left->min, left->max, right->min, right->max, node->min, node->max);
+    node->height = 1 + (left->height > right->height ? left->height : right->height);
+}
+
+static inline
+void _replace_child(Bvh* self, u32 parent, u32 old_child, u32 new_child) {
+    if (parent == BVH_NULL) {
+        self->root = new_child;
+        return;
+    }
+    if (self->nodes[parent].left == old_child)  self->nodes[parent].left = new_child;
+    else                                        self->nodes[parent].right = new_child;
+}
+
+/* Rotate taller grandchild up if subtrees of `a` differ by more than 1 in height, returns new subtree root */
+static
+u32 _balance(Bvh* self, u32 a) {
+    BvhNode* node_a = &self->nodes[a];
+    if (_is_leaf(node_a) || node_a->height < 2)  return a;
+
+    u32 b = node_a->left, c = node_a->right;
+    i32 balance = self->nodes[c].height - self->nodes[b].height;
+    if (balance >= -1 && balance <= 1)  return a;
+
+    // Rotate `up` (taller child) above `a`, `a` keeps its other child and one of grandchildren
+    bool right_up = balance > 1;
+    u32 up = right_up ? c : b;
+    BvhNode* node_up = &self->nodes[up];
+
+    u32 f = node_up->left, g = node_up->right;
+    if (self->nodes[f].height < self->nodes[g].height) {
+        u32 tmp = f;  f = g;  g = tmp;
+    }
+    // `f` is taller grandchild, stays with `up`, `g` goes under `a`
+
+    node_up->left = a;
+    node_up->right = f;
+    node_up->parent = node_a->parent;
+    _replace_child(self, node_up->parent, a, up);
+
+    node_a->parent = up;
+    if (right_up)  node_a->right = g;
+    else           node_a->left = g;
+    self->nodes[g].parent = a;
+
+    _refit_node(self, a);
+    _refit_node(self, up);
+    return up;
+}
+
+/* Fix bounds & heights from `index` to root, rebalancing on the way */
+static
+void _refit_up(Bvh* self, u32 index) {
+    while (index != BVH_NULL) {
+        index = _balance(self, index);
+        _refit_node(self, index);
+        index = self->nodes[index].parent;
+    }
+}
+
+static
+void _insert_leaf(Bvh* self, u32 leaf) {
+    if (self->root == BVH_NULL) {
+        self->root = leaf;
+        self->nodes[leaf].parent = BVH_NULL;
+        return;
+    }
+
+    /* --- Descend to cheapest sibling by surface area heuristic --- */
+    vec3 leaf_min, leaf_max;
+    glm_vec3_copy(self->nodes[leaf].min, leaf_min);
+    glm_vec3_copy(self->nodes[leaf].max, leaf_max);
+
+    u32 index = self->root;
+    while (!_is_leaf(&self->nodes[index])) {
+        BvhNode* node = &self->nodes[index];
+
+        f32 area = _area(node->min, node->max);
+        f32 combined = _union_area(node->min, node->max, leaf_min, leaf_max);
+        f32 cost = 2.0 * combined;                       // new parent of this node and leaf
+        f32 inherited = 2.0 * (combined - area);          // growth of ancestors when going down
+
+        f32 child_cost[2];
+        u32 children[2] = {node->left, node->right};
+        for (int i = 0; i < 2; i++) {
+            BvhNode* child = &self->nodes[children[i]];
+            f32 grown = _union_area(child->min, child->max, leaf_min, leaf_max);
+            child_cost[i] = inherited + (_is_leaf(child) ? grown : grown - _area(child->min, child->max));
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1])  break;
+        index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+    }
+
+    /* --- New parent for sibling and leaf --- */
+    u32 sibling = index;
+    u32 parent = _alloc_node(self);  // may move nodes
+    u32 old_parent = self->nodes[sibling].parent;
+
+    BvhNode* node = &self->nodes[parent];
+    node->parent = old_parent;
+    node->left = sibling;
+    node->right = leaf;
+    _replace_child(self, old_parent, sibling, parent);
+
+    self->nodes[sibling].parent = parent;
+    self->nodes[leaf].parent = parent;
+
+    _refit_up(self, parent);
+}
+
+static
+void _remove_leaf(Bvh* self, u32 leaf) {
+    if (leaf == self->root) {
+        self->root = BVH_NULL;
+        return;
+    }
+
+    u32 parent = self->nodes[leaf].parent;
+    u32 grand = self->nodes[parent].parent;
+    u32 sibling = self->nodes[parent].left == leaf ? self->nodes[parent].right : self->nodes[parent].left;
+
+    _replace_child(self, grand, parent, sibling);
+    self->nodes[sibling].parent = grand;
+    _free_node(self, parent);
+
+    _refit_up(self, grand);
+}
+
+static inline
+void _set_leaf_bounds(Bvh* self, u32 leaf, Bounds* bounds) {
+    BvhNode* node = &self->nodes[leaf];
+    glm_vec3_sub(bounds->center, bounds->extent, node->leaf_min);
+    glm_vec3_add(bounds->center, bounds->extent, node->leaf_max);
+    glm_vec3_subs(node->leaf_min, self->margin, node->min);
+    glm_vec3_adds(node->leaf_max, self->margin, node->max);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void bvh_init(Bvh* self, f32 margin) {
+    memset(self, 0, sizeof(Bvh));
+    self->root = BVH_NULL;
+    self->free_list = BVH_NULL;
+    self->margin = margin;
+}
+
+void bvh_free(Bvh* self) {
+    free(self->nodes);
+    bvh_init(self, self->margin);
+}
+
+u32 bvh_insert(Bvh* self, Bounds* bounds, u32 data) {
+    u32 leaf = _alloc_node(self);
+    self->nodes[leaf].data = data;
+    _set_leaf_bounds(self, leaf, bounds);
+
+    _insert_leaf(self, leaf);
+    self->leaves++;
+    return leaf;
+}
+
+void bvh_remove(Bvh* self, u32 leaf) {
+    _remove_leaf(self, leaf);
+    _free_node(self, leaf);
+    self->leaves--;
+}
+
+void bvh_move(Bvh* self, u32 leaf, Bounds* bounds) {
+    BvhNode* node = &self->nodes[leaf];
+
+    vec3 min, max;
+    glm_vec3_sub(bounds->center, bounds->extent, min);
+    glm_vec3_add(bounds->center, bounds->extent, max);
+
+    // Within fat bounds, tree is unchanged
+    if (_contains(node->min, node->max, min, max)) {
+        glm_vec3_copy(min, node->leaf_min);
+        glm_vec3_copy(max, node->leaf_max);
+        return;
+    }
+
+    _set_leaf_bounds(self, leaf, bounds);
+
+    // Still inside parent: refit ancestors in place, structure stays good enough
+    u32 parent = node->parent;
+    if (parent != BVH_NULL && _contains(self->nodes[parent].min, self->nodes[parent].max, node->min, node->max)) {
+        for (u32 index = parent; index != BVH_NULL; index = self->nodes[index].parent)
+            _refit_node(self, index);
+        return;
+    }
+
+    _remove_leaf(self, leaf);
+    _insert_leaf(self, leaf);
+}
+
+bool bvh_shape_overlaps(const BvhShape* shape, Bounds* bounds) {
+    vec3 min, max;
+    glm_vec3_sub(bounds->center, bounds->extent, min);
+    glm_vec3_add(bounds->center, bounds->extent, max);
+    return _overlaps_shape(shape, min, max);
+}
+
+void bvh_shape_ray(BvhShape* shape, vec3 origin, vec3 dir, f32 max_dist) {
+    shape->type = BVH_SHAPE_RAY;
+    glm_vec3_copy(origin, shape->ray.origin);
+    for (int i = 0; i < 3; i++)  shape->ray.inv_dir[i] = 1.0 / dir[i];
+    shape->ray.max_dist = max_dist;
+}
+
+u32 bvh_query(Bvh* self, const BvhShape* shape, u32* dest, u32 max) {
+    if (self->root == BVH_NULL)  return 0;
+
+    u32 stack[BVH_STACK_SIZE];
+    u32 top = 0;
+    u32 found = 0;
+    stack[top++] = self->root;
+
+    while (top) {
+        BvhNode* node = &self->nodes[stack[--top]];
+        if (!_overlaps_shape(shape, node->min, node->max))  continue;
+
+        if (_is_leaf(node)) {
+            if (!_overlaps_shape(shape, node->leaf_min, node->leaf_max))  continue;
+            if (found < max)  dest[found] = node->data;
+            found++;
+            continue;
+        }
+
+        if (top + 2 > BVH_STACK_SIZE)  log_exit("[world] BVH is too deep (%u leaves)", self->leaves);
+        stack[top++] = node->left;
+        stack[top++] = node->right;
+    }
+    return found;
+}
+
+bool bvh_raycast(Bvh* self, vec3 origin, vec3 dir, f32 max_dist, u32* data, f32* dist) {
+    if (self->root == BVH_NULL)  return false;
+
+    vec3 inv_dir = {1.0 / dir[0], 1.0 / dir[1], 1.0 / dir[2]};
+    f32 best = max_dist;
+    bool hit = false;
+
+    u32 stack[BVH_STACK_SIZE];
+    u32 top = 0;
+    stack[top++] = self->root;
+
+    while (top) {
+        BvhNode* node = &self->nodes[stack[--top]];
+        if (_ray_box(origin, inv_dir, best, node->min, node->max) == FLT_MAX)  continue;
+
+        if (_is_leaf(node)) {
+            f32 t = _ray_box(origin, inv_dir, best, node->leaf_min, node->leaf_max);
+            if (t == FLT_MAX)  continue;
+            best = t;
+            *data = node->data;
+            hit = true;
+            continue;
+        }
+
+        if (top + 2 > BVH_STACK_SIZE)  log_exit("[world] BVH is too deep (%u leaves)", self->leaves);
+
+        // Nearer child is popped first, so farther one is more likely culled by `best`
+        u32 near = node->left, far = node->right;
+        f32 t_left = _ray_box(origin, inv_dir, best, self->nodes[near].min, self->nodes[near].max);
+        f32 t_right = _ray_box(origin, inv_dir, best, self->nodes[far].min, self->nodes[far].max);
+        if (t_right < t_left) {
+            u32 tmp = near;  near = far;  far = tmp;
+        }
+        stack[top++] = far;
+        stack[top++] = near;
+    }
+
+    if (hit)  *dist = best;
+    return hit;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdbool.h>
+
+#include <cglm/cglm.h>
+
+#include "core/types.h"
+
+/*
+    Dynamic AABB tree: leaves hold user value (`data`) with exact bounds
+    and fat bounds (exact + margin). Leaf moving within its fat bounds costs
+    nothing, leaf staying inside its parent is refitted in place (ancestor
+    bounds recomputed), otherwise it's removed and inserted again. Insert
+    picks sibling by surface area cost, tree is kept balanced by rotations.
+*/
+
+#define BVH_NULL  0xFFFFFFFF
+
+
+typedef struct Bounds {
+    vec3 center;
+    vec3 extent;  // half size
+} Bounds;
+
+typedef struct BvhNode {
+    vec3 min, max;          // fat bounds for leaves
+    vec3 leaf_min, leaf_max;
+    u32 parent;             // next free node while in free list
+    u32 left, right;        // BVH_NULL for leaves
+    i32 height;             // 0 for leaves, -1 for free nodes
+    u32 data;
+} BvhNode;
+
+typedef struct Bvh {
+    BvhNode* nodes;
+    u32 capacity;
+    u32 root;
+    u32 free_list;
+    u32 leaves;
+    f32 margin;
+} Bvh;
+
+
+typedef enum BvhShapeType {
+    BVH_SHAPE_AABB,
+    BVH_SHAPE_SPHERE,
+    BVH_SHAPE_FRUSTUM,
+    BVH_SHAPE_RAY,
+} BvhShapeType;
+
+typedef struct BvhShape {
+    BvhShapeType type;
+    union {
+        Bounds box;
+        vec4 sphere;        // center, radius
+        vec4 planes[6];     // normalized, inside is positive (`glm_frustum_planes`)
+        struct {
+            vec3 origin;
+            vec3 inv_dir;   // 1 / dir, see `bvh_shape_ray`
+            f32 max_dist;
+        } ray;
+    };
+} BvhShape;
+
+
+void bvh_init(Bvh*, f32 margin);
+void bvh_free(Bvh*);
+
+/* Returns leaf, valid until removed */
+u32 bvh_insert(Bvh*, Bounds* bounds, u32 data);
+void bvh_remove(Bvh*, u32 leaf);
+void bvh_move(Bvh*, u32 leaf, Bounds* bounds);
+
+bool bvh_shape_overlaps(const BvhShape* shape, Bounds* bounds);
+/* Segment from `origin` along `dir` (normalized) */
+void bvh_shape_ray(BvhShape* shape, vec3 origin, vec3 dir, f32 max_dist);
+
+/* Writes data of up to `max` overlapping leaves into `dest`, returns count of all overlapping */
+u32 bvh_query(Bvh*, const BvhShape* shape, u32* dest, u32 max);
+/* Nearest leaf hit by ray (`dir` normalized) within `max_dist` */
+bool bvh_raycast(Bvh*, vec3 origin, vec3 dir, f32 max_dist, u32* data, f32* dist);
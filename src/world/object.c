@@ -2,6 +2,7 @@
 
 #include "object.h"
 
+#include "../assets/asset_loader.h"
 #include "../assets/model.h"
 
 
@@ -9,19 +10,19 @@ Object* object_new(ObjectInfo* info) {
     Object* obj = malloc(sizeof(Object));
     memset(obj, 0, sizeof(Object));
 
-    strcpy(obj->base_id, info->id);
+    obj->base_id = info->atom;
     obj->type = info->type;
     obj->info = info;
 
-    Model* model = model_create_from_info(info->model);
-    obj->model = model;
+    // Model pointer is set by loader (immediately if async loading is disabled)
+    asset_loader_load_model(info->model, &obj->model);
 
     return obj;
 }
 
 
 void object_free(Object* obj) {
-    model_destroy(obj->model);
+    if (obj->model)  model_destroy(obj->model);
     free(obj);
 }
 
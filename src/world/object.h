@@ -5,7 +5,7 @@
 
 
 typedef struct Object {
-    char base_id[MAX_ID_LENGTH];
+    Atom base_id;
     
     Model* model;
     ObjectInfo* info;
@@ -4,68 +4,91 @@
 #include <cglm/cglm.h>
 
 #include "object_ref.h"
+#include "world/ref_store.h"
 #include "world/world.h"
 
+#include "assets/texture_stream.h"
+#include "core/atom.h"
+#include "core/config.h"
 #include "core/containers/tuple.h"
 #include "core/containers/map.h"
 #include "core/cgm.h"
 #include "core/log.h"
 
-static u32 next_ref_id = 0x00000001;
+// objects.json masks are passed to physics as they are
+STATIC_ASSERT((u32)PHCAT_STATIC == (u32)PXCAT_STATIC && (u32)PHCAT_ITEM == (u32)PXCAT_ITEM);
+STATIC_ASSERT((u32)PHCAT_PLAYER == (u32)PXCAT_PLAYER && (u32)PHCAT_RAY == (u32)PXCAT_RAY);
+STATIC_ASSERT((u32)PHCAT_TRIGGER == (u32)PXCAT_TRIGGER);
 
 /* ------------------------------------------------------------------------- */
 
-static inline void _create_physics(ObjectRef* self, PhysicsInfo** infos);
+static inline void _on_model_loaded(RefStore* store, u32 slot);
+static inline void _create_physics(RefStore* store, u32 slot, PhysicsInfo** infos);
 
 /* ------------------------------------------------------------------------- */
 
-ObjectRef* object_ref_new(ObjectRefInfo* info) {
-    ObjectRef* self = malloc(sizeof(ObjectRef));
-    memset(self, 0, sizeof(ObjectRef));
-
-    /* --- Reference ID --- */
-    self->ref_id = next_ref_id++;
+void object_ref_init(RefStore* store, u32 slot, ObjectRefInfo* info) {
+    ObjectRef* self = &store->refs[slot];
+    self->ref_id = store->ids[slot];
 
     /* --- Object --- */
-    Object* obj = world_get_object(info->id);
+    Object* obj = world_get_object(info->atom);
     if (!obj)
         log_exit("[world] Object not found: %s", info->id);
     
     self->obj = obj;
-    glm_vec3_copy(info->pos, self->position);
-    glm_vec3_copy(info->rot, self->rotation);
-
-    /* --- Object Model --- */
-    int nodes_vec3_size = sizeof(vec3) * tuple_size(obj->model->nodes);
-    if (obj->model) {
-        self->node_positions = malloc(nodes_vec3_size);
-        self->node_rotations = malloc(nodes_vec3_size);
-    }
+    self->info = info;
+    store->types[slot] = obj->type;
+    glm_vec3_copy(info->pos, store->positions[slot]);
+    glm_vec3_copy(info->rot, store->rotations[slot]);
 
-    /* --- Object Physics --- */
-    _create_physics(self, obj->info->physics);
+    /* --- Model & Physics (deferred while model is loading) --- */
+    if (obj->model)
+        _on_model_loaded(store, slot);
+
+    ref_store_mark_dirty(store, slot);
+}
 
-    return self;
+void object_ref_release(RefStore* store, u32 slot) {
+    ObjectRef* self = &store->refs[slot];
+
+    if (self->physics) {
+        PxObject* px_obj;
+        tuple_for_each(px_obj, self->physics) {
+            px_delete_object(px_obj);
+        }
+        free(self->physics);
+        self->physics = NULL;
+    }
 }
 
-void object_ref_free(ObjectRef* self) {
-    if (self->node_positions)   free(self->node_positions);
-    if (self->node_rotations)   free(self->node_rotations);
+static inline
+void _on_model_loaded(RefStore* store, u32 slot) {
+    ObjectRef* self = &store->refs[slot];
+    Model* model = self->obj->model;
+
+    Bounds* local = &store->local_bounds[slot];
+    glm_vec3_copy(model->aabb.offset, local->center);
+    glm_vec3_scale(model->aabb.size, 0.5, local->extent);
 
-    if (self->physics)          free(self->physics);
-    // FIXME: also need to remove related px_objects from px storage
-    free(self);
+    _create_physics(store, slot, self->obj->info->physics);
+    self->is_loaded = true;
+    ref_store_mark_dirty(store, slot);
 }
 
 static inline
-void _create_physics(ObjectRef* self, PhysicsInfo** infos) {
+void _create_physics(RefStore* store, u32 slot, PhysicsInfo** infos) {
+    ObjectRef* self = &store->refs[slot];
+    f32* position = store->positions[slot];
+    f32* rotation = store->rotations[slot];
+
     self->physics = NULL;
     if (!infos)  return;
     
     int physics_count = tuple_size(infos);
     if (physics_count == 0) return;
 
-    int physics_size = sizeof(PxObject) * (physics_count + 1);
+    int physics_size = sizeof(PxObject*) * (physics_count + 1);
     self->physics = malloc(physics_size);
     memset(self->physics, 0, physics_size);
     
@@ -78,22 +101,22 @@ void _create_physics(ObjectRef* self, PhysicsInfo** infos) {
 
         if (info->shape == PHSHAPE_BOX) {
             body_type = PXBODY_BOX;
-            glm_vec3_add(self->position, info->pos, pos);
-            // glm_vec3_add(self->rotation, info->rot, relative_rot);  // TODO: Not supported at now
-            glm_vec3_copy(self->rotation, rot);
+            glm_vec3_add(position, info->pos, pos);
+            // glm_vec3_add(rotation, info->rot, relative_rot);  // TODO: Not supported at now
+            glm_vec3_copy(rotation, rot);
             glm_vec3_negate(rot);
             glm_vec3_copy(info->size, size);
         }
         else if (info->shape == PHSHAPE_AABB) {
             body_type = PXBODY_BOX;
-            glm_vec3_add(self->position, self->obj->model->aabb.offset, pos);
-            // glm_vec3_add(self->rotation, info->rot, relative_rot);  // TODO: Not supported at now
-            glm_vec3_copy(self->rotation, rot);
+            glm_vec3_add(position, self->obj->model->aabb.offset, pos);
+            // glm_vec3_add(rotation, info->rot, relative_rot);  // TODO: Not supported at now
+            glm_vec3_copy(rotation, rot);
             glm_vec3_negate(rot);
             glm_vec3_copy(self->obj->model->aabb.size, size);
         }
         else if (info->shape == PHSHAPE_NULL) {
-            log_error("Unknown physics shape in object: %s", self->obj->base_id);
+            log_error("Unknown physics shape in object: %s", atom_str(self->obj->base_id));
             return;
         }
         else {
@@ -105,29 +128,77 @@ void _create_physics(ObjectRef* self, PhysicsInfo** infos) {
             
         else if (self->obj->type == OBJECT_ITEM)
             self->physics[i] = px_static_create(body_type, pos, rot, size);
+
+        if (!self->physics[i])  continue;
+        self->physics[i]->owner = self->ref_id;
+
+        PxObject* px_obj = self->physics[i];
+        px_object_set_masks(
+            px_obj,
+            info->category != PHCAT_DEFAULT ? info->category : px_obj->category,
+            info->collide != PHCAT_DEFAULT ? info->collide : px_obj->collide
+        );
     }
 }
 
 /* ------------------------------------------------------------------------- */
 
-void object_ref_update(ObjectRef* self) {
+void object_ref_update(RefStore* store, u32 slot) {
+    ObjectRef* self = &store->refs[slot];
+
+    if (!self->is_loaded) {
+        if (!self->obj->model)  return;
+        _on_model_loaded(store, slot);
+    }
+
     object_update(self->obj);
     
-    if (self->obj->type == OBJECT_ITEM) {
-        // TODO: check on `object_ref_new` that there is only 1 physics body 
-        px_static_get_position(self->physics[0], self->position);
-        px_static_get_rotation(self->physics[0], self->rotation);
+    if (store->types[slot] == OBJECT_ITEM && self->physics) {
+        // TODO: check on `object_ref_init` that there is only 1 physics body 
+        PxObject* px_obj = self->physics[0];
+        vec3 pos, rot;
+        if (px_obj->body) {
+            px_rigid_get_render_transform(px_obj, pos, rot);
+        } else {
+            px_static_get_position(px_obj, pos);
+            px_static_get_rotation(px_obj, rot);
+        }
+
+        if (!glm_vec3_eqv(pos, store->positions[slot]) || !glm_vec3_eqv(rot, store->rotations[slot]))
+            object_ref_set_transform(store, slot, pos, rot);
     }
 }
 
-void object_ref_draw(ObjectRef* self) {
+void object_ref_set_transform(RefStore* store, u32 slot, vec3 pos, vec3 rot) {
+    glm_vec3_copy(pos, store->positions[slot]);
+    glm_vec3_copy(rot, store->rotations[slot]);
+    ref_store_mark_dirty(store, slot);
+}
+
+static inline
+f32 _calc_screen_size(RefStore* store, u32 slot) {
+    Camera* camera = gfx_get_camera();
+    if (!camera)  return 0.0;
+
+    Bounds* bounds = &store->bounds[slot];
+    return camera_get_projected_size(camera, bounds->center, glm_vec3_norm(bounds->extent));
+}
+
+void object_ref_draw(RefStore* store, u32 slot) {
+    Model* model = store->refs[slot].obj->model;
+    if (!model || !model->is_ready)  return;
+
     ModelNode* node;
-    mat4 model_mat;
+
+    f32 screen_size = 0.0;
+    if (Config.GRAPHICS_TEXTURE_STREAMING)
+        screen_size = _calc_screen_size(store, slot);
     
     // TODO: concat ModelNode pos and rot
-    cgm_model_mat(self->position, self->rotation, NULL, model_mat);
-    
-    tuple_for_each(node, self->obj->model->nodes) {
-        gfx_enqueue_object(node->mesh, node->texture, model_mat);
+    tuple_for_each(node, model->nodes) {
+        gfx_enqueue_object(node->mesh, node->texture, store->world_mats[slot]);
+
+        if (screen_size > 0.0)
+            texture_stream_request(node->texture, screen_size);
     }
 }
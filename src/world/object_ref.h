@@ -6,23 +6,25 @@
 #include "database/schemas.h"
 #include "physics/px.h"
 
+typedef struct RefStore RefStore;
 
+
+/* Cold per-ref data, transforms & bounds live in RefStore columns of the same slot */
 typedef struct ObjectRef {
     u32 ref_id;
     Object* obj;
-
-    vec3 position;
-    vec3 rotation;
-    vec3* node_positions;
-    vec3* node_rotations;
+    ObjectRefInfo* info;
 
     PxObject** physics;
+    bool is_loaded;  // model is parsed, physics is created
 } ObjectRef;
 
 
-ObjectRef* object_ref_new(ObjectRefInfo*);
-
-void object_ref_free(ObjectRef*);
+void object_ref_init(RefStore*, u32 slot, ObjectRefInfo*);
+/* Release physics & buffers, before slot is removed from store */
+void object_ref_release(RefStore*, u32 slot);
 
-void object_ref_update(ObjectRef*);
-void object_ref_draw(ObjectRef*);
+void object_ref_update(RefStore*, u32 slot);
+/* Move ref, its world matrix is rebuilt on next scene update */
+void object_ref_set_transform(RefStore*, u32 slot, vec3 pos, vec3 rot);
+void object_ref_draw(RefStore*, u32 slot);
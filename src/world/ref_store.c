@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <cvector.h>
+#include <cvector_utils.h>
+
+#include "ref_store.h"
+
+#include "core/cgm.h"
+#include "core/log.h"
+
+
+#define REF_STORE_MIN_CAPACITY  256
+#define REF_STORE_ALIGN         32  // mat4 is 32-byte aligned with AVX
+#define REF_STORE_BATCH         64  // dirty slots rebuilt per batch kernel call
+
+
+/* Grow column keeping `count` items, columns are aligned for SIMD loads */
+static
+void* _column_grow(void* column, u64 item_size, u32 count, u32 capacity) {
+    u64 size = (item_size * capacity + REF_STORE_ALIGN - 1) & ~(u64)(REF_STORE_ALIGN - 1);
+    void* grown = aligned_alloc(REF_STORE_ALIGN, size);
+    if (!grown)  log_exit("[world] Out of memory for %u refs", capacity);
+
+    if (column)  memcpy(grown, column, item_size * count);
+    free(column);
+    return grown;
+}
+
+static
+void _grow(RefStore* self) {
+    u32 capacity = self->capacity ? self->capacity * 2 : REF_STORE_MIN_CAPACITY;
+
+    self->ids = _column_grow(self->ids, sizeof(u32), self->count, capacity);
+    self->refs = _column_grow(self->refs, sizeof(ObjectRef), self->count, capacity);
+    self->positions = _column_grow(self->positions, sizeof(vec3), self->count, capacity);
+    self->rotations = _column_grow(self->rotations, sizeof(vec3), self->count, capacity);
+    self->world_mats = _column_grow(self->world_mats, sizeof(mat4), self->count, capacity);
+    self->local_bounds = _column_grow(self->local_bounds, sizeof(Bounds), self->count, capacity);
+    self->bounds = _column_grow(self->bounds, sizeof(Bounds), self->count, capacity);
+    self->types = _column_grow(self->types, sizeof(u8), self->count, capacity);
+    self->dirty = _column_grow(self->dirty, sizeof(u8), self->count, capacity);
+    self->proxies = _column_grow(self->proxies, sizeof(u32), self->count, capacity);
+
+    self->capacity = capacity;
+}
+
+static inline
+u32 _alloc_id(RefStore* self) {
+    if (!cvector_empty(self->free_ids)) {
+        u32 id = *cvector_back(self->free_ids);
+        cvector_pop_back(self->free_ids);
+        return id;
+    }
+
+    u32 id = ++self->next_id;
+    if (id > self->slots_capacity) {
+        u32 capacity = self->slots_capacity ? self->slots_capacity * 2 : REF_STORE_MIN_CAPACITY;
+        self->slots = realloc(self->slots, sizeof(u32) * capacity);
+        self->slots_capacity = capacity;
+    }
+    return id;
+}
+
+/* Copy every column of slot `src` into `dest` */
+static inline
+void _move_slot(RefStore* self, u32 dest, u32 src) {
+    self->ids[dest] = self->ids[src];
+    self->refs[dest] = self->refs[src];
+    glm_vec3_copy(self->positions[src], self->positions[dest]);
+    glm_vec3_copy(self->rotations[src], self->rotations[dest]);
+    glm_mat4_copy(self->world_mats[src], self->world_mats[dest]);
+    self->local_bounds[dest] = self->local_bounds[src];
+    self->bounds[dest] = self->bounds[src];
+    self->types[dest] = self->types[src];
+    self->dirty[dest] = self->dirty[src];
+    self->proxies[dest] = self->proxies[src];
+
+    self->slots[self->ids[dest] - 1] = dest;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void ref_store_init(RefStore* self) {
+    memset(self, 0, sizeof(RefStore));
+}
+
+void ref_store_free(RefStore* self) {
+    free(self->ids);
+    free(self->refs);
+    free(self->positions);
+    free(self->rotations);
+    free(self->world_mats);
+    free(self->local_bounds);
+    free(self->bounds);
+    free(self->types);
+    free(self->dirty);
+    free(self->proxies);
+    cvector_free(self->dirty_ids);
+    cvector_free(self->flushed);
+
+    free(self->slots);
+    cvector_free(self->free_ids);
+    memset(self, 0, sizeof(RefStore));
+}
+
+u32 ref_store_add(RefStore* self) {
+    if (self->count == self->capacity)  _grow(self);
+
+    u32 slot = self->count++;
+    u32 id = _alloc_id(self);
+    self->slots[id - 1] = slot;
+
+    self->ids[slot] = id;
+    memset(&self->refs[slot], 0, sizeof(ObjectRef));
+    glm_vec3_zero(self->positions[slot]);
+    glm_vec3_zero(self->rotations[slot]);
+    glm_mat4_identity(self->world_mats[slot]);
+    memset(&self->local_bounds[slot], 0, sizeof(Bounds));
+    memset(&self->bounds[slot], 0, sizeof(Bounds));
+    self->types[slot] = 0;
+    self->dirty[slot] = 0;
+    self->proxies[slot] = BVH_NULL;
+
+    return slot;
+}
+
+void ref_store_remove(RefStore* self, u32 ref_id) {
+    u32 slot = ref_store_slot(self, ref_id);
+    if (slot == REF_SLOT_NONE)  return;
+
+    u32 last = --self->count;
+    if (slot != last)  _move_slot(self, slot, last);
+
+    self->slots[ref_id - 1] = REF_SLOT_NONE;
+    cvector_push_back(self->free_ids, ref_id);
+}
+
+u32 ref_store_slot(RefStore* self, u32 ref_id) {
+    if (ref_id == 0 || ref_id > self->next_id)  return REF_SLOT_NONE;
+    return self->slots[ref_id - 1];
+}
+
+/* World AABB of rotated local box: center is transformed, extent is projected on axes */
+static inline
+void _update_bounds(RefStore* self, u32 slot) {
+    mat4* m = &self->world_mats[slot];
+    Bounds* local = &self->local_bounds[slot];
+    Bounds* world = &self->bounds[slot];
+
+    glm_mat4_mulv3(*m, local->center, 1.0, world->center);
+    for (int r = 0; r < 3; r++) {
+        world->extent[r] =
+            fabsf((*m)[0][r]) * local->extent[0] +
+            fabsf((*m)[1][r]) * local->extent[1] +
+            fabsf((*m)[2][r]) * local->extent[2];
+    }
+}
+
+/* Rebuild scattered slots, gathered so batch kernel sees contiguous input */
+static
+void _update_slots(RefStore* self, const u32* slots, u32 count) {
+    vec3 positions[REF_STORE_BATCH], rotations[REF_STORE_BATCH];
+    mat4 mats[REF_STORE_BATCH];
+
+    for (u32 i = 0; i < count; i++) {
+        glm_vec3_copy(self->positions[slots[i]], positions[i]);
+        glm_vec3_copy(self->rotations[slots[i]], rotations[i]);
+    }
+    cgm_model_mat_batch(positions, rotations, NULL, mats, count);
+
+    for (u32 i = 0; i < count; i++) {
+        glm_mat4_copy(mats[i], self->world_mats[slots[i]]);
+        _update_bounds(self, slots[i]);
+        cvector_push_back(self->flushed, slots[i]);
+    }
+}
+
+void ref_store_update_transforms(RefStore* self, u32 first, u32 count) {
+    cgm_model_mat_batch(self->positions + first, self->rotations + first, NULL, self->world_mats + first, count);
+
+    u32 end = first + count;
+    for (u32 i = first; i < end; i++) {
+        _update_bounds(self, i);
+    }
+}
+
+void ref_store_mark_dirty(RefStore* self, u32 slot) {
+    if (self->dirty[slot])  return;
+
+    self->dirty[slot] = 1;
+    cvector_push_back(self->dirty_ids, self->ids[slot]);
+}
+
+u32 ref_store_flush_transforms(RefStore* self) {
+    u32 updated = 0;
+    u32 slots[REF_STORE_BATCH];
+    u32 pending = 0;
+    cvector_clear(self->flushed);
+
+    u32* it;
+    cvector_for_each_in(it, self->dirty_ids) {
+        // Removed meanwhile, or id reused by ref which got its own entry
+        u32 slot = ref_store_slot(self, *it);
+        if (slot == REF_SLOT_NONE || !self->dirty[slot])  continue;
+
+        self->dirty[slot] = 0;
+        slots[pending++] = slot;
+        if (pending == REF_STORE_BATCH) {
+            _update_slots(self, slots, pending);
+            updated += pending;
+            pending = 0;
+        }
+    }
+    if (pending) {
+        _update_slots(self, slots, pending);
+        updated += pending;
+    }
+    cvector_clear(self->dirty_ids);
+
+    self->transforms_updated = updated;
+    return updated;
+}
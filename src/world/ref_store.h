@@ -0,0 +1,65 @@
+#pragma once
+#include <cglm/cglm.h>
+
+#include "world/bvh.h"
+#include "world/object_ref.h"
+
+#include "core/types.h"
+
+/*
+    Dense ObjectRef storage: every per-ref value lives in its own packed
+    column (SoA), index into columns is slot. Slots are kept dense, removal
+    moves last slot into freed one, so update & draw are linear scans.
+    Sparse array maps ref id to slot, ids of removed refs are reused.
+
+    World matrices & bounds are cached, slots changing position, rotation
+    or local bounds are marked dirty and rebuilt on `ref_store_flush_transforms`.
+
+    Pointers into columns (incl. `ObjectRef*`) are valid until next add/remove.
+*/
+
+#define REF_SLOT_NONE  0xFFFFFFFF
+
+
+typedef struct RefStore {
+    u32 count;
+    u32 capacity;
+
+    /* --- Columns, by slot --- */
+    u32* ids;
+    ObjectRef* refs;        // cold data: object, physics, load state
+    vec3* positions;
+    vec3* rotations;
+    mat4* world_mats;
+    Bounds* local_bounds;   // model space, set when model is loaded
+    Bounds* bounds;         // world space
+    u8* types;              // ObjectType
+    u8* dirty;              // world matrix & bounds are stale, slot is in `dirty_ids`
+    u32* proxies;           // leaf in scene BVH, BVH_NULL until bounds are first flushed
+
+    u32* dirty_ids;         // cvector, ids (stable across swaps) of dirty slots
+    u32* flushed;           // cvector, slots rebuilt by last flush
+    u32 transforms_updated; // matrices rebuilt by last flush
+
+    /* --- Sparse index, by ref id - 1 --- */
+    u32* slots;
+    u32 slots_capacity;
+    u32* free_ids;          // cvector
+    u32 next_id;
+} RefStore;
+
+
+void ref_store_init(RefStore*);
+void ref_store_free(RefStore*);
+
+/* Add zeroed slot with new ref id (`ids[slot]`), returns slot */
+u32 ref_store_add(RefStore*);
+void ref_store_remove(RefStore*, u32 ref_id);
+u32 ref_store_slot(RefStore*, u32 ref_id);
+
+/* Rebuild world matrices & bounds of slots [first, first + count) from positions/rotations */
+void ref_store_update_transforms(RefStore*, u32 first, u32 count);
+
+void ref_store_mark_dirty(RefStore*, u32 slot);
+/* Rebuild dirty slots only, returns count of rebuilt matrices */
+u32 ref_store_flush_transforms(RefStore*);
@@ -1,22 +1,154 @@
+#include <float.h>
+#include <math.h>
 #include <string.h>
 
+#include <GLFW/glfw3.h>
+#include <cvector.h>
+#include <cvector_utils.h>
+
 #include "scene.h"
 
+#include "core/cgm.h"
+#include "core/config.h"
 #include "core/containers/tuple.h"
+#include "core/log.h"
+#include "graphics/camera.h"
+#include "graphics/gfx.h"
+#include "physics/px.h"
 #include "physics/px_object.h"
 
 
+#define SCENE_BVH_MARGIN    0.1   // fat bounds, refs moving less don't touch the tree
+#define SCENE_CULL_MARGIN   1.0   // frustum is widened, camera still turns after culling (late latch)
+
+
+/* ------ Cells ------ */
+/* ------------------------------------------------------------------------- */
+
+/* Cell coords are packed into map key, +-32k cells per axis */
+static inline
+void* _cell_key(i32 x, i32 z) {
+    return (void*)(u64)((u32)(u16)x << 16 | (u16)z);
+}
+
+static inline
+void _cell_coords(vec3 pos, i32* x, i32* z) {
+    *x = floorf(pos[0] / Config.WORLD_CELL_SIZE);
+    *z = floorf(pos[2] / Config.WORLD_CELL_SIZE);
+}
+
+/* Distance on XZ plane from `center` to nearest point of cell */
+static inline
+f32 _cell_distance(SceneCell* cell, vec3 center) {
+    f32 size = Config.WORLD_CELL_SIZE;
+    f32 dx = fmaxf(fmaxf(cell->x * size - center[0], center[0] - (cell->x + 1) * size), 0.0);
+    f32 dz = fmaxf(fmaxf(cell->z * size - center[2], center[2] - (cell->z + 1) * size), 0.0);
+    return sqrtf(dx * dx + dz * dz);
+}
+
+static inline
+void _queue_cell(Scene* self, vec3 center, i32 x, i32 z) {
+    SceneCell* cell = map_get(self->cells, _cell_key(x, z));
+    if (!cell || cell->state != CELL_UNLOADED)  return;
+    if (_cell_distance(cell, center) > Config.WORLD_LOAD_RADIUS)  return;
+
+    cell->state = CELL_LOADING;
+    cvector_push_back(self->active_cells, cell);
+    cvector_push_back(self->loading_cells, cell);
+}
+
+static inline
+void _remove_ref(Scene* self, u32 ref_id) {
+    u32 slot = ref_store_slot(&self->refs, ref_id);
+    if (slot == REF_SLOT_NONE)  return;
+
+    if (self->refs.proxies[slot] != BVH_NULL)
+        bvh_remove(&self->bvh, self->refs.proxies[slot]);
+    object_ref_release(&self->refs, slot);
+    ref_store_remove(&self->refs, ref_id);
+}
+
+static
+void _unload_cell(Scene* self, SceneCell* cell) {
+    u32* it;
+    cvector_for_each_in(it, cell->ref_ids) {
+        _remove_ref(self, *it);
+    }
+    cvector_clear(cell->ref_ids);
+
+    if (cell->state == CELL_LOADING) {
+        for (u64 i = 0; i < cvector_size(self->loading_cells); i++) {
+            if (self->loading_cells[i] != cell)  continue;
+            cvector_erase(self->loading_cells, i);
+            break;
+        }
+    }
+
+    cell->state = CELL_UNLOADED;
+    cell->next_info = 0;
+}
+
+/* Instantiate next ref of cell, returns false when cell is complete */
+static inline
+bool _load_next_ref(Scene* self, SceneCell* cell) {
+    if (cell->next_info >= cvector_size(cell->infos))  return false;
+
+    ObjectRefInfo* info = cell->infos[cell->next_info++];
+    if (map_get(self->removed_infos, info))  return true;
+
+    u32 slot = ref_store_add(&self->refs);
+    object_ref_init(&self->refs, slot, info);
+    cvector_push_back(cell->ref_ids, self->refs.ids[slot]);
+    if (!self->refs.refs[slot].is_loaded)  self->loading_refs++;
+
+    return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
 Scene* scene_new(SceneInfo* info) {
+    if (Config.WORLD_CELL_SIZE <= 0.0)
+        log_exit("[world] Invalid cell size: %.2f", Config.WORLD_CELL_SIZE);
+    if (Config.WORLD_UNLOAD_RADIUS < Config.WORLD_LOAD_RADIUS)
+        log_exit("[world] Unload radius must not be less than load radius");
+
     Scene* self = malloc(sizeof(Scene));
     memset(self, 0, sizeof(Scene));
     
-    self->object_refs = map_new(MHASH_INT);
+    ref_store_init(&self->refs);
+    bvh_init(&self->bvh, SCENE_BVH_MARGIN);
+    self->cells = map_new(MHASH_INT);
+    self->removed_infos = map_new(MHASH_INT);
 
+    /* --- Bucket refs into cells (instantiated by `scene_stream`) --- */
     ObjectRefInfo* oref_info;
+    vec3 min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    vec3 max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
 
     tuple_for_each(oref_info, info->object_refs) {
-        ObjectRef* oref = object_ref_new(oref_info);
-        map_set(self->object_refs, oref, (void*)(intptr_t)oref->ref_id);
+        glm_vec3_minv(min, oref_info->pos, min);
+        glm_vec3_maxv(max, oref_info->pos, max);
+
+        i32 x, z;
+        _cell_coords(oref_info->pos, &x, &z);
+
+        SceneCell* cell = map_get(self->cells, _cell_key(x, z));
+        if (!cell) {
+            cell = calloc(1, sizeof(SceneCell));
+            cell->x = x;
+            cell->z = z;
+            map_set(self->cells, cell, _cell_key(x, z));
+        }
+        cvector_push_back(cell->infos, oref_info);
+    }
+
+    // Static broadphase is built once for whole scene, before cells stream in
+    if (min[0] <= max[0]) {
+        vec3 center, extent;
+        glm_vec3_center(min, max, center);
+        glm_vec3_sub(max, center, extent);
+        glm_vec3_adds(extent, Config.WORLD_CELL_SIZE, extent);
+        px_build_static_space(center, extent);
     }
 
     glm_vec3_copy(info->player_init_pos, self->player_init_pos);
@@ -26,53 +158,211 @@ Scene* scene_new(SceneInfo* info) {
 }
 
 void scene_free(Scene* self) {
-    ObjectRef* oref;
-    map_for_each(oref, self->object_refs) {
-        object_ref_free(oref);
+    SceneCell* cell;
+    map_for_each(cell, self->cells) {
+        _unload_cell(self, cell);
+        cvector_free(cell->infos);
+        cvector_free(cell->ref_ids);
+        free(cell);
     }
 
-    map_free(self->object_refs);
+    cvector_free(self->active_cells);
+    cvector_free(self->loading_cells);
+    map_free(self->cells);
+    map_free(self->removed_infos);
+    ref_store_free(&self->refs);
+    bvh_free(&self->bvh);
+    cvector_free(self->query_ids);
     free(self);
 }
 
 /* ------------------------------------------------------------------------- */
 
 ObjectRef* scene_get_oref_by_id(Scene* self, u32 ref_id) {
-    return map_get(self->object_refs, (void*)(intptr_t)ref_id);
+    u32 slot = ref_store_slot(&self->refs, ref_id);
+    return slot != REF_SLOT_NONE ? &self->refs.refs[slot] : NULL;
 }
 
 ObjectRef* scene_get_oref_by_physics(Scene* self, PxObject* px_obj) {
-    ObjectRef* oref;
-    PxObject* i_obj;
-
-    // FIXME
-    map_for_each(oref, self->object_refs) {
-        tuple_for_each(i_obj, oref->physics) {
-            if (i_obj == px_obj)
-                return oref;
-        }
-    }
-    return NULL;
+    if (!px_obj || !px_obj->owner)  return NULL;
+    return scene_get_oref_by_id(self, px_obj->owner);
 }
 
+/* Ref is freed and won't come back when its cell is streamed in again */
 void scene_remove_oref(Scene* self, ObjectRef* oref) {
-    map_remove(self->object_refs, (void*)(intptr_t)oref->ref_id);
-    // FIXME scene shouldn't manage object ref lifetime, control globally from world
-    // object_ref_free(oref);
+    ObjectRefInfo* info = oref->info;
+    u32 ref_id = oref->ref_id;
+    map_set(self->removed_infos, info, info);
+
+    i32 x, z;
+    _cell_coords(info->pos, &x, &z);
+    SceneCell* cell = map_get(self->cells, _cell_key(x, z));
+
+    for (u64 i = 0; cell && i < cvector_size(cell->ref_ids); i++) {
+        if (cell->ref_ids[i] != ref_id)  continue;
+        cvector_erase(cell->ref_ids, i);
+        break;
+    }
+    _remove_ref(self, ref_id);
+}
+
+void scene_set_oref_transform(Scene* self, ObjectRef* oref, vec3 pos, vec3 rot) {
+    u32 slot = ref_store_slot(&self->refs, oref->ref_id);
+    if (slot != REF_SLOT_NONE)  object_ref_set_transform(&self->refs, slot, pos, rot);
+}
+
+/* ------ Queries ------ */
+/* ------------------------------------------------------------------------- */
+
+/* Scratch for at least `count` ids */
+static inline
+u32* _query_ids(Scene* self, u32 count) {
+    if (cvector_capacity(self->query_ids) < count)
+        cvector_reserve(self->query_ids, count);
+    return self->query_ids;
+}
+
+u32 scene_query(Scene* self, const BvhShape* shape, ObjectRef** dest, u32 max) {
+    u32* ids = _query_ids(self, max);
+    u32 found = bvh_query(&self->bvh, shape, ids, max);
+
+    for (u32 i = 0; i < found && i < max; i++) {
+        dest[i] = &self->refs.refs[ref_store_slot(&self->refs, ids[i])];
+    }
+    return found;
+}
+
+u32 scene_query_batch(Scene* self, const BvhShape* shapes, u32 count, ObjectRef** dest, u32 max, u32* offsets) {
+    u32 found = 0;
+
+    offsets[0] = 0;
+    for (u32 i = 0; i < count; i++) {
+        u32 written = offsets[i];
+        u32 n = scene_query(self, &shapes[i], dest + written, max - written);
+        found += n;
+        offsets[i + 1] = written + min(n, max - written);
+    }
+    return found;
+}
+
+bool scene_raycast(Scene* self, vec3 origin, vec3 dir, f32 max_dist, RayHit* hit) {
+    u32 ref_id;
+    f32 dist;
+    if (!bvh_raycast(&self->bvh, origin, dir, max_dist, &ref_id, &dist))  return false;
+
+    hit->oref = &self->refs.refs[ref_store_slot(&self->refs, ref_id)];
+    hit->dist = dist;
+    return true;
+}
+
+u32 scene_raycast_batch(Scene* self, const vec3* origins, const vec3* dirs, u32 count, f32 max_dist, RayHit* hits) {
+    u32 hit_count = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        if (scene_raycast(self, (f32*)origins[i], (f32*)dirs[i], max_dist, &hits[i])) {
+            hit_count++;
+            continue;
+        }
+        hits[i].oref = NULL;
+        hits[i].dist = max_dist;
+    }
+    return hit_count;
 }
 
 /* ------------------------------------------------------------------------- */
 
+void scene_stream(Scene* self, vec3 center, f64 budget) {
+    /* --- Unload cells beyond unload radius --- */
+    for (u64 i = 0; i < cvector_size(self->active_cells);) {
+        SceneCell* cell = self->active_cells[i];
+        if (_cell_distance(cell, center) <= Config.WORLD_UNLOAD_RADIUS) {
+            i++;
+            continue;
+        }
+        _unload_cell(self, cell);
+        cvector_erase(self->active_cells, i);
+    }
+
+    /* --- Queue cells within load radius, ring by ring so nearest go first --- */
+    i32 cx, cz;
+    _cell_coords(center, &cx, &cz);
+    i32 rings = ceilf(Config.WORLD_LOAD_RADIUS / Config.WORLD_CELL_SIZE);
+
+    _queue_cell(self, center, cx, cz);
+    for (i32 r = 1; r <= rings; r++) {
+        for (i32 d = -r; d <= r; d++) {
+            _queue_cell(self, center, cx + d, cz - r);
+            _queue_cell(self, center, cx + d, cz + r);
+        }
+        for (i32 d = -r + 1; d <= r - 1; d++) {
+            _queue_cell(self, center, cx - r, cz + d);
+            _queue_cell(self, center, cx + r, cz + d);
+        }
+    }
+
+    /* --- Instantiate refs within frame budget (at least one per frame) --- */
+    f64 start = glfwGetTime();
+
+    while (!cvector_empty(self->loading_cells)) {
+        SceneCell* cell = self->loading_cells[0];
+
+        if (!_load_next_ref(self, cell)) {
+            cell->state = CELL_LOADED;
+            cvector_erase(self->loading_cells, 0);
+        }
+
+        if (budget > 0.0 && glfwGetTime() - start >= budget)  break;
+    }
+}
+
+bool scene_is_streaming(Scene* self) {
+    return !cvector_empty(self->loading_cells);
+}
+
 void scene_update(Scene* self) {
-    ObjectRef* oref;
-    map_for_each(oref, self->object_refs) {
-        object_ref_update(oref);
+    u32 loading_refs = 0;
+
+    for (u32 i = 0; i < self->refs.count; i++) {
+        object_ref_update(&self->refs, i);
+        if (!self->refs.refs[i].is_loaded)  loading_refs++;
+    }
+    self->loading_refs = loading_refs;
+
+    /* --- Moved refs update their leaves, new ones are inserted --- */
+    RefStore* refs = &self->refs;
+    ref_store_flush_transforms(refs);
+
+    u32* slot;
+    cvector_for_each_in(slot, refs->flushed) {
+        if (refs->proxies[*slot] == BVH_NULL)
+            refs->proxies[*slot] = bvh_insert(&self->bvh, &refs->bounds[*slot], refs->ids[*slot]);
+        else
+            bvh_move(&self->bvh, refs->proxies[*slot], &refs->bounds[*slot]);
     }
 }
 
 void scene_draw(Scene* self) {
-    ObjectRef* oref;
-    map_for_each(oref, self->object_refs) {
-        object_ref_draw(oref);
+    Camera* camera = gfx_get_camera();
+
+    if (!Config.GRAPHICS_FRUSTUM_CULLING || !camera) {
+        for (u32 i = 0; i < self->refs.count; i++) {
+            object_ref_draw(&self->refs, i);
+        }
+        return;
+    }
+
+    BvhShape frustum = {.type = BVH_SHAPE_FRUSTUM};
+    mat4 m_view_proj;
+    glm_mat4_mul(camera->m_persp, camera->m_view, m_view_proj);
+    glm_frustum_planes(m_view_proj, frustum.planes);
+    for (int i = 0; i < 6; i++) {
+        frustum.planes[i][3] += SCENE_CULL_MARGIN;
+    }
+
+    u32* ids = _query_ids(self, self->refs.count);
+    u32 visible = bvh_query(&self->bvh, &frustum, ids, self->refs.count);
+
+    for (u32 i = 0; i < visible && i < self->refs.count; i++) {
+        object_ref_draw(&self->refs, ref_store_slot(&self->refs, ids[i]));
     }
 }
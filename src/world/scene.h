@@ -1,13 +1,53 @@
 #pragma once
 
+#include "bvh.h"
 #include "object_ref.h"
+#include "ref_store.h"
 
 #include "core/containers/map.h"
 #include "database/schemas.h"
 
 
+/*
+    Scene refs are bucketed into square cells on XZ plane. Only cells around
+    streaming center (player) are instantiated, so memory and per-frame work
+    depend on loaded area, not on scene size.
+
+    Bounds of instantiated refs are indexed in BVH (leaf data is ref id),
+    spatial queries & culling go through it instead of scanning refs.
+*/
+
+typedef enum {
+    CELL_UNLOADED,
+    CELL_LOADING,  // queued, refs are instantiated within per-frame budget
+    CELL_LOADED,
+} SceneCellState;
+
+typedef struct SceneCell {
+    i32 x, z;
+    SceneCellState state;
+
+    ObjectRefInfo** infos;      // cvector, all refs of cell
+    u32* ref_ids;               // cvector, instantiated refs
+    u32 next_info;              // instantiation progress while loading
+} SceneCell;
+
+typedef struct RayHit {
+    ObjectRef* oref;
+    f32 dist;
+} RayHit;
+
+
 typedef struct Scene {
-    map(ObjectRef) object_refs;
+    RefStore refs;                  // instantiated refs
+    Bvh bvh;                        // bounds of refs, updated on `scene_update`
+    u32* query_ids;                 // cvector, scratch for BVH results
+    u32 loading_refs;               // refs waiting for their model, counted on update
+
+    map(SceneCell) cells;           // by packed cell coords
+    SceneCell** active_cells;       // cvector, loading or loaded
+    SceneCell** loading_cells;      // cvector, instantiation queue (nearest first)
+    map(void) removed_infos;        // refs removed during gameplay, never re-instantiated
 
     vec3 player_init_pos;
     vec2 player_init_rot;
@@ -20,6 +60,20 @@ void scene_free(Scene*);
 ObjectRef* scene_get_oref_by_id(Scene* self, u32 ref_id);
 ObjectRef* scene_get_oref_by_physics(Scene* self, PxObject* px_obj);
 void scene_remove_oref(Scene* self, ObjectRef* oref);
+void scene_set_oref_transform(Scene* self, ObjectRef* oref, vec3 pos, vec3 rot);
+
+/* Writes up to `max` refs overlapping shape into `dest`, returns count of all overlapping */
+u32 scene_query(Scene* self, const BvhShape* shape, ObjectRef** dest, u32 max);
+/* Results of query `i` are `dest[offsets[i] .. offsets[i + 1])`, `offsets` has `count + 1` items */
+u32 scene_query_batch(Scene* self, const BvhShape* shapes, u32 count, ObjectRef** dest, u32 max, u32* offsets);
+/* Nearest ref whose bounds are hit by ray (`dir` normalized) */
+bool scene_raycast(Scene* self, vec3 origin, vec3 dir, f32 max_dist, RayHit* hit);
+/* Returns count of rays which hit, `hits[i].oref` is NULL for missed ones */
+u32 scene_raycast_batch(Scene* self, const vec3* origins, const vec3* dirs, u32 count, f32 max_dist, RayHit* hits);
+
+/* Queue cells around `center`, unload far ones, instantiate refs (`budget` in sec, <= 0 for no limit) */
+void scene_stream(Scene*, vec3 center, f64 budget);
+bool scene_is_streaming(Scene*);
 
 void scene_update(Scene*);
 void scene_draw(Scene*);
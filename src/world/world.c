@@ -1,28 +1,36 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <cvector.h>
+
 #include "world.h"
 #include "world/object.h"
 #include "world/scene.h"
 
+#include "assets/asset_cache.h"
+#include "assets/asset_loader.h"
 #include "assets/texture.h"
+#include "assets/texture_stream.h"
+#include "core/config.h"
 #include "core/containers/map.h"
 #include "core/containers/tuple.h"
 #include "core/log.h"
 #include "graphics/gfx.h"
 #include "database/db.h"
 #include "gameplay/player.h"
+#include "physics/px.h"
 
 
 static struct World {
     map(Object) objects;
     Scene* current_scene;
     GfxSkybox* skybox;
+    bool scene_loading;
 } self = {};
 
 
 void world_init() {
-    self.objects = map_new(MHASH_STR);
+    self.objects = map_new(MHASH_INT);
     
     /* --- Objects Loading --- */
     Database* db = db_get();
@@ -31,16 +39,20 @@ void world_init() {
 
     tuple_for_each(obj_info, db->objects) {
         obj = object_new(obj_info);
-        map_set(self.objects, obj, obj->base_id);
+        map_set(self.objects, obj, (void*)(u64)obj->base_id);
     }
 
     /* --- Scene Loading --- */
     Scene* scene = scene_new(db->scene);
     self.current_scene = scene;
+    self.scene_loading = true;
 
     /* --- Player Loading */
     player_init(scene->player_init_pos, scene->player_init_rot);
 
+    // Cells around player are instantiated at once, the rest is streamed while moving
+    scene_stream(scene, scene->player_init_pos, 0.0);
+
     /* --- Skybox --- */
     self.skybox = texture_load_skybox(
         "skybox/vz_sinister_right.dds",
@@ -72,12 +84,22 @@ void world_destroy() {
 
 void world_print() {
     log_debug("total Object: %i", map_size(self.objects));
-    log_debug("total ObjectRef: %i", tuple_size(self.current_scene->object_refs));
+    log_debug(
+        "total ObjectRef: %i (matrices rebuilt last update: %i)",
+        self.current_scene->refs.count, self.current_scene->refs.transforms_updated
+    );
+    log_debug(
+        "total SceneCell: %i (active %i)",
+        map_size(self.current_scene->cells), cvector_size(self.current_scene->active_cells)
+    );
+    texture_stream_print();
+    asset_cache_print();
+    px_print();
 }
 
 
-Object* world_get_object(char* id) {
-    return map_get(self.objects, id);
+Object* world_get_object(Atom id) {
+    return map_get(self.objects, (void*)(u64)id);
 }
 
 Scene* world_get_current_scene() {
@@ -96,9 +118,60 @@ void world_remove_oref(ObjectRef* oref) {
     scene_remove_oref(self.current_scene, oref);
 }
 
+void world_set_oref_transform(ObjectRef* oref, vec3 pos, vec3 rot) {
+    scene_set_oref_transform(self.current_scene, oref, pos, rot);
+}
+
+u32 world_get_transforms_updated() {
+    return self.current_scene->refs.transforms_updated;
+}
+
+u32 world_query_aabb(Bounds* box, ObjectRef** dest, u32 max) {
+    BvhShape shape = {.type = BVH_SHAPE_AABB, .box = *box};
+    return scene_query(self.current_scene, &shape, dest, max);
+}
+
+u32 world_query_sphere(vec3 center, f32 radius, ObjectRef** dest, u32 max) {
+    BvhShape shape = {.type = BVH_SHAPE_SPHERE, .sphere = {center[0], center[1], center[2], radius}};
+    return scene_query(self.current_scene, &shape, dest, max);
+}
+
+u32 world_query_frustum(mat4 view_proj, ObjectRef** dest, u32 max) {
+    BvhShape shape = {.type = BVH_SHAPE_FRUSTUM};
+    glm_frustum_planes(view_proj, shape.planes);
+    return scene_query(self.current_scene, &shape, dest, max);
+}
+
+u32 world_query_batch(const BvhShape* shapes, u32 count, ObjectRef** dest, u32 max, u32* offsets) {
+    return scene_query_batch(self.current_scene, shapes, count, dest, max, offsets);
+}
+
+bool world_raycast(vec3 origin, vec3 dir, f32 max_dist, RayHit* hit) {
+    return scene_raycast(self.current_scene, origin, dir, max_dist, hit);
+}
+
+u32 world_raycast_batch(const vec3* origins, const vec3* dirs, u32 count, f32 max_dist, RayHit* hits) {
+    return scene_raycast_batch(self.current_scene, origins, dirs, count, max_dist, hits);
+}
+
+
+bool world_is_loading() {
+    return asset_loader_is_busy()
+        || self.current_scene->loading_refs > 0
+        || scene_is_streaming(self.current_scene);
+}
 
 void world_update() {
-    player_update();
+    // Hold player until initial cells, their models (and physics) are loaded
+    if (!self.scene_loading)
+        player_update();
+
+    if (self.scene_loading && !world_is_loading()) {
+        self.scene_loading = false;
+        asset_cache_log_stats();
+    }
+
+    scene_stream(self.current_scene, player_get()->position, Config.WORLD_STREAM_BUDGET_MS / 1000.0);
     scene_update(self.current_scene);
 }
 
@@ -9,12 +9,31 @@ void world_init();
 void world_destroy();
 
 void world_print();
-Object* world_get_object(char* id);
+Object* world_get_object(Atom id);
 Scene* world_get_current_scene();
 
+// Returned refs are valid until refs are added or removed (next world update)
 ObjectRef* world_get_oref_by_id(u32 ref_id);
 ObjectRef* world_get_oref_by_physics(PxObject* value);
 void world_remove_oref(ObjectRef* oref);
+/* Move ref from gameplay/editor, cached matrix is rebuilt on next update */
+void world_set_oref_transform(ObjectRef* oref, vec3 pos, vec3 rot);
+/* World matrices rebuilt on last update, stays near zero on static scenes */
+u32 world_get_transforms_updated();
 
+/*
+    Spatial queries over ref bounds (world BVH), write up to `max` refs into
+    `dest` and return count of all found. Batch versions take any mix of
+    shapes, results of query `i` are `dest[offsets[i] .. offsets[i + 1])`.
+*/
+u32 world_query_aabb(Bounds* box, ObjectRef** dest, u32 max);
+u32 world_query_sphere(vec3 center, f32 radius, ObjectRef** dest, u32 max);
+u32 world_query_frustum(mat4 view_proj, ObjectRef** dest, u32 max);
+u32 world_query_batch(const BvhShape* shapes, u32 count, ObjectRef** dest, u32 max, u32* offsets);
+/* Nearest ref whose bounds are hit by ray (`dir` normalized) */
+bool world_raycast(vec3 origin, vec3 dir, f32 max_dist, RayHit* hit);
+u32 world_raycast_batch(const vec3* origins, const vec3* dirs, u32 count, f32 max_dist, RayHit* hits);
+
+bool world_is_loading();
 void world_update();
 void world_draw();